@@ -1,2 +1,3 @@
 find_package(xxHash 0.7 CONFIG REQUIRED)
+find_package(Threads REQUIRED)
 include(${CMAKE_CURRENT_LIST_DIR}/EBSTargets.cmake)
\ No newline at end of file
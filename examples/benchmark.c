@@ -0,0 +1,85 @@
+#include "EBS/EBS.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// embeds into and extracts from growing lists of thumbnails, the time per image should stay flat as the list grows
+
+#define BENCHMARK_WIDTH 8
+#define BENCHMARK_HEIGHT 8
+#define BENCHMARK_CHANNEL 1
+
+static double benchmarkSeconds(void) {
+    struct timespec time;
+    timespec_get(&time, TIME_UTC);
+    return (double) time.tv_sec + (double) time.tv_nsec * 1e-9;
+}
+
+static int benchmarkRun(uint64_t imageCount, uint64_t threadCount) {
+    const uint64_t imageSize = BENCHMARK_WIDTH * BENCHMARK_HEIGHT * BENCHMARK_CHANNEL;
+    uint8_t *pixels = (uint8_t *) malloc(imageCount * imageSize);
+    EBS_Image *images = (EBS_Image *) malloc(imageCount * sizeof(EBS_Image));
+    // a quarter of the capacity of the images, 4 squares holding 2 bytes each
+    const uint64_t messageSize = imageCount * 2;
+    uint8_t *data = (uint8_t *) malloc(messageSize);
+    if (pixels == NULL || images == NULL || data == NULL) {
+        free(pixels);
+        free(images);
+        free(data);
+        printf("out of memory for %" PRIu64 " images\n", imageCount);
+        return EBS_ErrorOOM;
+    }
+
+    for (uint64_t i = 0; i < imageCount * imageSize; ++i) {
+        pixels[i] = (uint8_t) rand();
+    }
+    for (uint64_t i = 0; i < imageCount; ++i) {
+        images[i] = (EBS_Image) {.width = BENCHMARK_WIDTH, .height = BENCHMARK_HEIGHT, .channel = BENCHMARK_CHANNEL,
+                                 .pixels = pixels + i * imageSize};
+    }
+    for (uint64_t i = 0; i < messageSize; ++i) {
+        data[i] = (uint8_t) rand();
+    }
+
+    EBS_ImageList imageList = {imageCount, images};
+    const EBS_Message message = {messageSize, data};
+    const EBS_Options options = {
+            .squareSize = 4,
+            .threadCount = threadCount
+    };
+    int errorCode;
+
+    const double start = benchmarkSeconds();
+    EBS_MessageEmbedWithOptions(&imageList, &message, &options, &errorCode);
+    const double embedded = benchmarkSeconds();
+    EBS_Message extracted = {0, NULL};
+    if (errorCode == EBS_OK) extracted = EBS_MessageExtractWithOptions(&imageList, &options, &errorCode);
+    const double end = benchmarkSeconds();
+
+    if (errorCode == EBS_OK) {
+        printf("%8" PRIu64 " images: embed %7.3f s (%6.0f ns per image), extract %7.3f s (%6.0f ns per image)\n",
+               imageCount, embedded - start, (embedded - start) * 1e9 / (double) imageCount, end - embedded,
+               (end - embedded) * 1e9 / (double) imageCount);
+    } else {
+        printf("error %d with %" PRIu64 " images\n", errorCode, imageCount);
+    }
+
+    EBS_MessageFree(&extracted);
+    free(pixels);
+    free(images);
+    free(data);
+    return errorCode;
+}
+
+int main(int argc, char **argv) {
+    // the largest list, 1M images by default, and the number of threads, 1 by default
+    const uint64_t maxCount = argc > 1 ? strtoull(argv[1], NULL, 10) : 1000000;
+    const uint64_t threadCount = argc > 2 ? strtoull(argv[2], NULL, 10) : 1;
+    for (uint64_t imageCount = 1000; imageCount <= maxCount; imageCount *= 10) {
+        const int errorCode = benchmarkRun(imageCount, threadCount);
+        if (errorCode != EBS_OK) return errorCode;
+    }
+    return 0;
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <inttypes.h>
+#include <stdbool.h>
 
 /**
  * OK Code.
@@ -18,14 +19,16 @@ static const int EBS_ErrorOOM = 1;
 /**
  * Invalid Message Error.
  * Could occur when extracting messages.
- * It indicates that the length of data extracted from the images is larger than they could possibly hold.
+ * It indicates that the length of data extracted from the images is larger than they could possibly hold, or that
+ * the images have no square at all to hold one.
  */
 static const int EBS_ErrorInvalidMessage = 2;
 
 /**
  * Overflow Error.
  * Could occur when embedding messages.
- * It indicates that the length of the message is large than what the images could possibly hold.
+ * It indicates that the length of the message is large than what the images could possibly hold. Even an empty
+ * message needs one square for its header.
  */
 static const int EBS_ErrorOverflow = 3;
 
@@ -44,19 +47,60 @@ static const int EBS_ErrorBadSquareSize = 4;
  * Could occur when embedding or extracting messages.
  * It indicates that one or more of the images passed do not meet the following requirements:
  * \code{.c}
- * image->width != 0 && image->height != 0 && image->channel != 0 && image->pixels != NULL
+ * image->width != 0 && image->height != 0 && image->channel != 0 && image->pixels != NULL &&
+ * (image->width / 4) * (image->height / 4) <= UINT32_MAX &&
+ * (image->sampleBits == 0 || image->sampleBits == 8 || (image->sampleBits == 16 && image->channel <= 32))
  * \endcode
  */
 static const int EBS_ErrorInvalidImage = 5;
 
 /**
- * Image represents an image loaded in memory
+ * Bad Depth.
+ * Could occur when embedding or extracting messages with options.
+ * It indicates that the depth of the options doesn't meet the following requirement, 0 being taken as 1:
+ * \code{.c}
+ * depth <= 4
+ * \endcode
+ */
+static const int EBS_ErrorBadDepth = 6;
+
+/**
+ * Bad Channel Mask.
+ * Could occur when embedding or extracting messages with options.
+ * It indicates that the channel mask of the options is not 0 but selects none of the channels of an image:
+ * \code{.c}
+ * channelMask == 0 || (channelMask & ((1 << image->channel) - 1)) != 0
+ * \endcode
+ */
+static const int EBS_ErrorBadChannelMask = 7;
+
+/**
+ * Checksum Mismatch.
+ * Could occur when extracting messages with the checksum option.
+ * It indicates that the message extracted doesn't match the checksum stored with it, because the images were changed
+ * or the options differ from the ones used to embed it.
+ */
+static const int EBS_ErrorChecksum = 8;
+
+/**
+ * Stream Error.
+ * Could occur when embedding messages from a reader or extracting messages to a writer.
+ * It indicates that the reader returned 0 bytes, or more than asked, before the whole message was read, that there's
+ * no reader for a message that isn't empty, or that the writer didn't take all the bytes it was given. The squares
+ * written or the bytes given until then are left as is.
+ */
+static const int EBS_ErrorStream = 9;
+
+/**
+ * Image represents an image loaded in memory, or a view of part of one made by \b EBS_ImageView
  */
 typedef struct EBS_Image {
     uint64_t width;
     uint64_t height;
     uint64_t channel;
-    uint8_t *pixels;
+    uint8_t *pixels; /* The first pixel of the first row */
+    uint64_t stride; /* The bytes from the start of a row to the start of the next, 0 for packed rows */
+    uint64_t sampleBits; /* 8 (also taken for 0), or 16 for samples of 2 bytes in the byte order of the processor */
 } EBS_Image;
 
 /**
@@ -75,6 +119,62 @@ typedef struct EBS_Message {
     uint8_t *data; /* The pointer to the data */
 } EBS_Message;
 
+/**
+ * Allocator represents the functions every allocation made for a \b Context goes through.
+ */
+typedef struct EBS_Allocator {
+    void *(*allocate)(void *user, uint64_t size); /* Allocates like malloc, returning NULL when out of memory */
+    /* Allocates the arenas like aligned_alloc, with a power of 2 alignment and a multiple of it as size, NULL uses
+     * allocate */
+    void *(*allocateAligned)(void *user, uint64_t alignment, uint64_t size);
+    void (*deallocate)(void *user, void *pointer); /* Frees what either function allocated, never given NULL */
+    void *user; /* Passed to every call of the functions */
+} EBS_Allocator;
+
+/**
+ * Context represents an allocator and the arenas that embedding and extracting keep their temporary memory in.
+ * The arenas only grow, so repeated calls with similar images and messages stop allocating after the first ones.
+ * The threads a call runs on are kept waiting by the context for the next calls, until it's freed.
+ * A context is used by one call at a time.
+ */
+typedef struct EBS_Context EBS_Context;
+
+/**
+ * Options represents the settings shared by embedding and extracting.
+ */
+typedef struct EBS_Options {
+    uint64_t squareSize; /* The size of squares the image is split into to calculate local entropy */
+    uint64_t threadCount; /* The threads computing entropy, embedding and extracting, 0 uses every hardware thread */
+    const char *indexDirectory; /* A directory caching the ordered squares of every image, NULL disables it */
+    uint64_t depth; /* The number of low bits of every channel carrying the message, 1 to 4, 0 is taken as 1 */
+    uint64_t channelMask; /* Bit c selects channel c to carry the message, 0 selects every channel */
+    const uint8_t *key; /* A 32-byte ChaCha20 key encrypting the message and its size, NULL leaves them in clear */
+    const uint8_t *nonce; /* The 12-byte nonce used with the key, never twice with the same key, NULL is all zeros */
+    bool checksum; /* Stores XXH3_64bits_withSeed(data, size, size) with the size, which extracting then verifies */
+    EBS_Context *context; /* Allocates through its allocator and reuses its arenas, NULL allocates with malloc */
+} EBS_Options;
+
+/**
+ * Reader gives the bytes of a message to embed, in order.
+ * It copies up to size bytes into buffer and returns how many it copied, fewer being fine, like fread. Returning 0
+ * before the whole message was read stops the embedding with EBS_ErrorStream.
+ */
+typedef uint64_t (*EBS_Reader)(void *context, uint8_t *buffer, uint64_t size);
+
+/**
+ * Writer takes the bytes of an extracted message, in order.
+ * It gets the next size bytes of the message in data and returns how many it took, like fwrite. Taking fewer stops
+ * the extraction with EBS_ErrorStream.
+ */
+typedef uint64_t (*EBS_Writer)(void *context, const uint8_t *data, uint64_t size);
+
+/**
+ * Plan represents the ordered squares of an image list, built once and reused by any number of embeds, extracts
+ * and capacity queries.
+ * Embedding only changes the low bits, which the entropy ignores, so a plan stays valid for its images.
+ */
+typedef struct EBS_Plan EBS_Plan;
+
 /**
  * @brief Embed a \b Message into an \b ImageList.
  * @param imageList A list of images to embed into. The memory should be handled by the caller.
@@ -86,6 +186,35 @@ typedef struct EBS_Message {
  */
 void EBS_MessageEmbed(EBS_ImageList *imageList, const EBS_Message *message, uint64_t squareSize, int *errorCode);
 
+/**
+ * @brief Embed a \b Message into an \b ImageList with the given \b Options.
+ * @param imageList A list of images to embed into. The memory should be handled by the caller.
+ * @param message The message to embed. The memory should be handled by the caller.
+ * @param options The options to embed with. The images are the same whatever the threadCount is.
+ * @param errorCode The error code if there's any. If there's no error, EBS_OK/0 is set.
+ *
+ * Note that the same squareSize, depth, channelMask, key, nonce and checksum are needed when the message is extracted,
+ * otherwise you might get wrong data.
+ */
+void EBS_MessageEmbedWithOptions(EBS_ImageList *imageList, const EBS_Message *message, const EBS_Options *options,
+                                 int *errorCode);
+
+/**
+ * @brief Embed a message of a known size, read from a \b Reader, into an \b ImageList with the given \b Options.
+ * @param imageList A list of images to embed into. The memory should be handled by the caller.
+ * @param messageSize The size of the message in bytes, which the reader has to give in full.
+ * @param reader The reader called for the bytes of the message, always from the same thread, in the order the
+ * squares are filled. Only a buffer of about 64 KiB per thread is held at a time. NULL only for an empty message.
+ * @param readerContext The context passed to every call of the reader.
+ * @param options The options to embed with. The images are the same whatever the threadCount is.
+ * @param errorCode The error code if there's any. If there's no error, EBS_OK/0 is set.
+ *
+ * The images are the same as with \b EBS_MessageEmbedWithOptions and the whole message in memory, so the message is
+ * extracted the same way.
+ */
+void EBS_MessageEmbedStream(EBS_ImageList *imageList, uint64_t messageSize, EBS_Reader reader, void *readerContext,
+                            const EBS_Options *options, int *errorCode);
+
 /**
  * @brief Extract a \b Message from an \b ImageList.
  * @param imageList A list of images to extract from. The memory should be handled by the caller.
@@ -100,6 +229,107 @@ void EBS_MessageEmbed(EBS_ImageList *imageList, const EBS_Message *message, uint
  */
 EBS_Message EBS_MessageExtract(EBS_ImageList *imageList, uint64_t squareSize, int *errorCode);
 
+/**
+ * @brief Extract a \b Message from an \b ImageList with the given \b Options.
+ * @param imageList A list of images to extract from. The memory should be handled by the caller.
+ * @param options The options to extract with. The message is the same whatever the threadCount is.
+ * @param errorCode The error code if there's any. If there's no error, EBS_OK/0 is set.
+ * @return The message extracted. The memory needs to be freed by the caller by calling \b EBS_MessageFree. With a
+ * context in the options, the memory belongs to the context instead, and stays valid until it extracts again.
+ *
+ * Note that the squareSize, depth, channelMask, key, nonce and checksum have to be the same as when the message was
+ * embedded, otherwise you might get wrong data. With the checksum, wrong data gives EBS_ErrorChecksum instead.
+ */
+EBS_Message EBS_MessageExtractWithOptions(EBS_ImageList *imageList, const EBS_Options *options, int *errorCode);
+
+/**
+ * @brief Extract a message from an \b ImageList to a \b Writer with the given \b Options.
+ * @param imageList A list of images to extract from. The memory should be handled by the caller.
+ * @param writer The writer given the bytes of the message, always from the same thread, in order, as soon as the
+ * squares holding them are read. Only a buffer of about 64 KiB per thread is held at a time.
+ * @param writerContext The context passed to every call of the writer.
+ * @param options The options to extract with. The message is the same whatever the threadCount is.
+ * @param errorCode The error code if there's any. If there's no error, EBS_OK/0 is set.
+ * @return The size of the message in bytes, all of them given to the writer, or 0 on error.
+ *
+ * Note that the squareSize, depth, channelMask, key, nonce and checksum have to be the same as when the message was
+ * embedded, otherwise you might get wrong data. The checksum can only be verified at the end, once the writer was
+ * given every byte, so with EBS_ErrorChecksum the bytes written have to be thrown away.
+ */
+uint64_t EBS_MessageExtractStream(EBS_ImageList *imageList, EBS_Writer writer, void *writerContext,
+                                  const EBS_Options *options, int *errorCode);
+
+/**
+ * @brief Create a \b Plan for an \b ImageList with the given \b Options.
+ * @param imageList A list of images to plan for. The images are reordered, but the array may be freed afterwards.
+ * The pixels are used by the plan and have to outlive it.
+ * @param options The options to plan with. The plan is the same whatever the threadCount is. A context is used by
+ * the plan and every call with it, so it has to outlive the plan.
+ * @param errorCode The error code if there's any. If there's no error, EBS_OK/0 is set.
+ * @return The plan created, or NULL on error. It needs to be freed by the caller by calling \b EBS_PlanFree.
+ */
+EBS_Plan *EBS_PlanCreate(EBS_ImageList *imageList, const EBS_Options *options, int *errorCode);
+
+/**
+ * @brief Embed a \b Message into the images of a \b Plan.
+ * @param plan The plan to embed with.
+ * @param message The message to embed. The memory should be handled by the caller.
+ * @param errorCode The error code if there's any. If there's no error, EBS_OK/0 is set.
+ *
+ * The images are the same as with \b EBS_MessageEmbedWithOptions and the plan's squareSize, depth, channelMask,
+ * key, nonce and checksum.
+ */
+void EBS_PlanEmbed(const EBS_Plan *plan, const EBS_Message *message, int *errorCode);
+
+/**
+ * @brief Extract a \b Message from the images of a \b Plan.
+ * @param plan The plan to extract with.
+ * @param errorCode The error code if there's any. If there's no error, EBS_OK/0 is set.
+ * @return The message extracted. The memory needs to be freed by the caller by calling \b EBS_MessageFree, unless
+ * the plan has a context, which then keeps it until it extracts again.
+ */
+EBS_Message EBS_PlanExtract(const EBS_Plan *plan, int *errorCode);
+
+/**
+ * @brief Get the capacity of a \b Plan.
+ * @param plan The plan to query.
+ * @return The largest message size in bytes that can be embedded with the plan.
+ */
+uint64_t EBS_PlanCapacity(const EBS_Plan *plan);
+
+/**
+ * @brief Free a \b Plan returned by \b EBS_PlanCreate.
+ * @param plan The plan to be freed. NULL is ignored.
+ */
+void EBS_PlanFree(EBS_Plan *plan);
+
+/**
+ * @brief Make an \b Image viewing a rectangle of another one, without copying the pixels.
+ * @param image The image to view. Its pixels are shared with the view, which writes into them.
+ * @param x The first column of the rectangle.
+ * @param y The first row of the rectangle.
+ * @param width The width of the rectangle.
+ * @param height The height of the rectangle.
+ * @param errorCode The error code if there's any. If there's no error, EBS_OK/0 is set.
+ * @return The view, or an image without pixels if the rectangle isn't inside the image.
+ */
+EBS_Image EBS_ImageView(const EBS_Image *image, uint64_t x, uint64_t y, uint64_t width, uint64_t height,
+                        int *errorCode);
+
+/**
+ * @brief Create a \b Context.
+ * @param allocator The allocator the context and its arenas are allocated with, copied. NULL uses malloc and free.
+ * @param errorCode The error code if there's any. If there's no error, EBS_OK/0 is set.
+ * @return The context created, or NULL on error. It needs to be freed by the caller by calling \b EBS_ContextFree.
+ */
+EBS_Context *EBS_ContextCreate(const EBS_Allocator *allocator, int *errorCode);
+
+/**
+ * @brief Free a \b Context returned by \b EBS_ContextCreate, with its arenas and threads.
+ * @param context The context to be freed. NULL is ignored.
+ */
+void EBS_ContextFree(EBS_Context *context);
+
 /**
  * @brief Free a \b Message returned by \b EBS_MessageExtract.
  * It's equal to
@@ -3,6 +3,10 @@
 #include <string>
 #include <sstream>
 #include <cinttypes>
+#include <memory>
+#include <stdexcept>
+#include <istream>
+#include <ostream>
 
 extern "C" {
 #include "EBS.h"
@@ -18,7 +22,11 @@ namespace EBS {
         InvalidMessage = EBS_ErrorInvalidMessage,
         Overflow = EBS_ErrorOverflow,
         BadSquareSize = EBS_ErrorBadSquareSize,
-        InvalidImage = EBS_ErrorInvalidImage
+        InvalidImage = EBS_ErrorInvalidImage,
+        BadDepth = EBS_ErrorBadDepth,
+        BadChannelMask = EBS_ErrorBadChannelMask,
+        Checksum = EBS_ErrorChecksum,
+        Stream = EBS_ErrorStream
     };
 
     /**
@@ -45,12 +53,21 @@ namespace EBS {
     public:
         const uint64_t width, height, channel;
         const std::shared_ptr<std::vector<uint8_t>> pixels;
+        /**
+         * The bytes from the start of a row to the start of the next, 0 for packed rows.
+         */
+        const uint64_t stride;
+        /**
+         * 8 (also taken for 0), or 16 for samples of 2 bytes in the byte order of the processor.
+         */
+        const uint64_t sampleBits;
 
-        Image(uint64_t width, uint64_t height, uint64_t channel, const std::shared_ptr<std::vector<uint8_t>> &pixels) :
-            width{width}, height{height}, channel{channel}, pixels{pixels} {}
+        Image(uint64_t width, uint64_t height, uint64_t channel, const std::shared_ptr<std::vector<uint8_t>> &pixels,
+              uint64_t stride = 0, uint64_t sampleBits = 0) :
+            width{width}, height{height}, channel{channel}, pixels{pixels}, stride{stride}, sampleBits{sampleBits} {}
 
         EBS_Image toEBS() const {
-            EBS_Image ebsImage{width, height, channel, const_cast<uint8_t *>(pixels->data())};
+            EBS_Image ebsImage{width, height, channel, const_cast<uint8_t *>(pixels->data()), stride, sampleBits};
             return ebsImage;
         }
     };
@@ -64,17 +81,60 @@ namespace EBS {
      */
     typedef std::vector<uint8_t> Data;
 
+    /**
+     * @brief Check the sizes of a key and a nonce, empty ones being left out.
+     * @throws std::invalid_argument if the key isn't 32 bytes or the nonce isn't 12 bytes.
+     */
+    inline void checkCipher(const Data &key, const Data &nonce) {
+        if ((!key.empty() && key.size() != 32) || (!nonce.empty() && nonce.size() != 12)) {
+            throw std::invalid_argument{"EBS key has to be 32 bytes and nonce 12 bytes"};
+        }
+    }
+
+    inline const uint8_t *cipherData(const Data &data) {
+        return data.empty() ? nullptr : data.data();
+    }
+
+    inline uint64_t readStream(void *context, uint8_t *buffer, uint64_t size) {
+        auto stream = static_cast<std::istream *>(context);
+        stream->read(reinterpret_cast<char *>(buffer), static_cast<std::streamsize>(size));
+        return static_cast<uint64_t>(stream->gcount());
+    }
+
+    inline uint64_t writeStream(void *context, const uint8_t *data, uint64_t size) {
+        auto stream = static_cast<std::ostream *>(context);
+        stream->write(reinterpret_cast<const char *>(data), static_cast<std::streamsize>(size));
+        return stream->good() ? size : 0;
+    }
+
     /**
      * Message to embed or extract.
      */
     class Message {
     private:
         const uint64_t squareSize;
+        const uint64_t threadCount;
+        const uint64_t depth;
+        const uint64_t channelMask;
+        const Data key;
+        const Data nonce;
+        const bool checksum;
     public:
         /**
          * @param squareSize The square size for calculating the regional entropy. This has to be the same when embedding and extracting messages, otherwise unexpected data will be decoded.
+         * @param threadCount The number of threads computing entropy, embedding and extracting, 0 uses every hardware thread. It doesn't change the result.
+         * @param depth The number of low bits of every channel carrying the data, 1 to 4. This has to be the same when embedding and extracting messages.
+         * @param channelMask Bit c selects channel c to carry the data, 0 selects every channel. This has to be the same when embedding and extracting messages.
+         * @param key A 32-byte ChaCha20 key encrypting the data and its size, empty leaves them in clear. This has to be the same when embedding and extracting messages.
+         * @param nonce The 12-byte nonce used with the key, never twice with the same key, empty is all zeros. This has to be the same when embedding and extracting messages.
+         * @param checksum Stores the XXH3-64 of the data, seeded with its size, with the size, which extracting then verifies. This has to be the same when embedding and extracting messages.
          */
-        explicit Message(uint64_t squareSize) : squareSize{squareSize} {}
+        explicit Message(uint64_t squareSize, uint64_t threadCount = 1, uint64_t depth = 1, uint64_t channelMask = 0,
+                         const Data &key = Data{}, const Data &nonce = Data{}, bool checksum = false) :
+            squareSize{squareSize}, threadCount{threadCount}, depth{depth}, channelMask{channelMask}, key{key},
+            nonce{nonce}, checksum{checksum} {
+            checkCipher(key, nonce);
+        }
 
         /**
          * @brief Embed data into an image list.
@@ -90,7 +150,9 @@ namespace EBS {
             EBS_ImageList ebsImageList{imageList.size(), images};
             EBS_Message ebsMessage{data.size(), const_cast<uint8_t *>(data.data())};
             int errorCode;
-            EBS_MessageEmbed(&ebsImageList, &ebsMessage, this->squareSize, &errorCode);
+            EBS_Options options{this->squareSize, this->threadCount, nullptr, this->depth, this->channelMask,
+                                cipherData(this->key), cipherData(this->nonce), this->checksum, nullptr};
+            EBS_MessageEmbedWithOptions(&ebsImageList, &ebsMessage, &options, &errorCode);
             if (errorCode != EBS_OK) {
                 delete[] images;
                 throw Error{static_cast<ErrorType>(errorCode)};
@@ -98,6 +160,28 @@ namespace EBS {
             delete[] images;
         }
 
+        /**
+         * @brief Embed data read from a stream into an image list, without holding all of it in memory.
+         * @param imageList The image list to embed the data into.
+         * @param stream The stream the data is read from, starting at its current position.
+         * @param size The size of the data in bytes, which the stream has to hold.
+         * Remember to check the potential error.
+         */
+        void embed(ImageList &imageList, std::istream &stream, uint64_t size) const {
+            std::vector<EBS_Image> images;
+            for (const auto &image : imageList) {
+                images.push_back(image->toEBS());
+            }
+            EBS_ImageList ebsImageList{images.size(), images.data()};
+            int errorCode;
+            EBS_Options options{this->squareSize, this->threadCount, nullptr, this->depth, this->channelMask,
+                                cipherData(this->key), cipherData(this->nonce), this->checksum, nullptr};
+            EBS_MessageEmbedStream(&ebsImageList, size, readStream, &stream, &options, &errorCode);
+            if (errorCode != EBS_OK) {
+                throw Error{static_cast<ErrorType>(errorCode)};
+            }
+        }
+
         /**
          * @brief Extract data from an image list.
          * @param imageList The image list to extract data from.
@@ -111,14 +195,116 @@ namespace EBS {
             }
             EBS_ImageList ebsImageList{imageList.size(), images};
             int errorCode;
-            EBS_Message ebsMessage = EBS_MessageExtract(&ebsImageList, this->squareSize, &errorCode);
+            EBS_Options options{this->squareSize, this->threadCount, nullptr, this->depth, this->channelMask,
+                                cipherData(this->key), cipherData(this->nonce), this->checksum, nullptr};
+            EBS_Message ebsMessage = EBS_MessageExtractWithOptions(&ebsImageList, &options, &errorCode);
             if (errorCode != EBS_OK) {
                 delete[] images;
                 throw Error{static_cast<ErrorType>(errorCode)};
             }
             delete[] images;
             Data data{ebsMessage.data, ebsMessage.data + ebsMessage.size};
+            EBS_MessageFree(&ebsMessage);
             return data;
         }
+
+        /**
+         * @brief Extract data from an image list into a stream, without holding all of it in memory.
+         * @param imageList The image list to extract data from.
+         * @param stream The stream the data is written to as it's read.
+         * @return The size of the data written.
+         * Remember to check the potential errors. A checksum error comes after all the data was written.
+         */
+        uint64_t extract(const ImageList &imageList, std::ostream &stream) const {
+            std::vector<EBS_Image> images;
+            for (const auto &image : imageList) {
+                images.push_back(image->toEBS());
+            }
+            EBS_ImageList ebsImageList{images.size(), images.data()};
+            int errorCode;
+            EBS_Options options{this->squareSize, this->threadCount, nullptr, this->depth, this->channelMask,
+                                cipherData(this->key), cipherData(this->nonce), this->checksum, nullptr};
+            const uint64_t size = EBS_MessageExtractStream(&ebsImageList, writeStream, &stream, &options, &errorCode);
+            if (errorCode != EBS_OK) {
+                throw Error{static_cast<ErrorType>(errorCode)};
+            }
+            return size;
+        }
+    };
+
+    /**
+     * Plan of an image list, built once and reused by any number of embeds, extracts and capacity queries.
+     */
+    class Plan {
+    private:
+        const ImageList imageList;
+        std::unique_ptr<EBS_Plan, void (*)(EBS_Plan *)> plan{nullptr, EBS_PlanFree};
+    public:
+        /**
+         * @param imageList The image list to plan for. The images are kept alive by the plan.
+         * @param squareSize The square size for calculating the regional entropy. This has to be the same when embedding and extracting messages, otherwise unexpected data will be decoded.
+         * @param threadCount The number of threads computing entropy, embedding and extracting, 0 uses every hardware thread. It doesn't change the result.
+         * @param indexDirectory A directory caching the ordered squares of every image, empty disables it.
+         * @param depth The number of low bits of every channel carrying the data, 1 to 4. This has to be the same when embedding and extracting messages.
+         * @param channelMask Bit c selects channel c to carry the data, 0 selects every channel. This has to be the same when embedding and extracting messages.
+         * @param key A 32-byte ChaCha20 key encrypting the data and its size, empty leaves them in clear. This has to be the same when embedding and extracting messages.
+         * @param nonce The 12-byte nonce used with the key, never twice with the same key, empty is all zeros. This has to be the same when embedding and extracting messages.
+         * @param checksum Stores the XXH3-64 of the data, seeded with its size, with the size, which extracting then verifies. This has to be the same when embedding and extracting messages.
+         */
+        Plan(const ImageList &imageList, uint64_t squareSize, uint64_t threadCount = 1,
+             const std::string &indexDirectory = "", uint64_t depth = 1, uint64_t channelMask = 0,
+             const Data &key = Data{}, const Data &nonce = Data{}, bool checksum = false) :
+            imageList{imageList} {
+            checkCipher(key, nonce);
+            std::vector<EBS_Image> images;
+            for (const auto &image : imageList) {
+                images.push_back(image->toEBS());
+            }
+            EBS_ImageList ebsImageList{images.size(), images.data()};
+            int errorCode;
+            EBS_Options options{squareSize, threadCount, indexDirectory.empty() ? nullptr : indexDirectory.c_str(), depth,
+                                channelMask, cipherData(key), cipherData(nonce), checksum, nullptr};
+            this->plan.reset(EBS_PlanCreate(&ebsImageList, &options, &errorCode));
+            if (errorCode != EBS_OK) {
+                throw Error{static_cast<ErrorType>(errorCode)};
+            }
+        }
+
+        /**
+         * @brief Embed data into the planned images.
+         * @param data The data to be embedded into.
+         * Remember to check the potential error.
+         */
+        void embed(const Data &data) const {
+            EBS_Message ebsMessage{data.size(), const_cast<uint8_t *>(data.data())};
+            int errorCode;
+            EBS_PlanEmbed(this->plan.get(), &ebsMessage, &errorCode);
+            if (errorCode != EBS_OK) {
+                throw Error{static_cast<ErrorType>(errorCode)};
+            }
+        }
+
+        /**
+         * @brief Extract data from the planned images.
+         * @return The data extracted.
+         * Remember to check the potential errors.
+         */
+        Data extract() const {
+            int errorCode;
+            EBS_Message ebsMessage = EBS_PlanExtract(this->plan.get(), &errorCode);
+            if (errorCode != EBS_OK) {
+                throw Error{static_cast<ErrorType>(errorCode)};
+            }
+            Data data{ebsMessage.data, ebsMessage.data + ebsMessage.size};
+            EBS_MessageFree(&ebsMessage);
+            return data;
+        }
+
+        /**
+         * @return The largest data size in bytes that can be embedded.
+         */
+        uint64_t capacity() const {
+            return EBS_PlanCapacity(this->plan.get());
+        }
     };
 }
@@ -0,0 +1,161 @@
+#include "channel.h"
+
+#include <string.h>
+
+#if EBS_X86_64
+#include <immintrin.h>
+#endif
+
+// the red, green and blue channels of an RGBA image, by far the most common mask
+static const uint64_t EBS_ChannelMaskRGB = 0x7;
+
+static inline bool EBS_ChannelSelected(uint64_t channelMask, uint64_t c) {
+    return c < 64 && (channelMask >> c & 1);
+}
+
+uint64_t EBS_ChannelMaskResolve(uint64_t channel, uint64_t channelMask) {
+    // 0 stands for every channel, whether it was passed as 0 or as a mask covering them all, a mask selecting none
+    // of them has to be rejected before
+    if (channelMask == 0 || channel > 64) return channelMask;
+    const uint64_t all = channel == 64 ? UINT64_MAX : (1ull << channel) - 1;
+    return (channelMask & all) == all ? 0 : channelMask & all;
+}
+
+uint64_t EBS_ChannelCount(uint64_t channel, uint64_t channelMask) {
+    if (channelMask == 0) return channel;
+    if (channel < 64) channelMask &= (1ull << channel) - 1;
+    uint64_t count = 0;
+    for (; channelMask != 0; channelMask &= channelMask - 1) {
+        ++count;
+    }
+    return count;
+}
+
+uint64_t EBS_ChannelMaskBytes(uint64_t channel, uint64_t channelMask, uint64_t bytes) {
+    // the mask of 16-bit samples read as bytes, channel c becoming channels 2c and 2c + 1 of which bytes selects some
+    uint64_t mask = 0;
+    for (uint64_t c = 0; c < channel && c < 32; ++c) {
+        if (channelMask == 0 || EBS_ChannelSelected(channelMask, c)) mask |= bytes << 2 * c;
+    }
+    return mask;
+}
+
+bool EBS_ChannelRGB(uint64_t channel, uint64_t channelMask) {
+    return channel == 4 && EBS_ChannelMaskResolve(channel, channelMask) == EBS_ChannelMaskRGB;
+}
+
+void EBS_ChannelPackScalar(uint8_t *packed, const uint8_t *pixels, uint64_t pixelCount, uint64_t channel,
+                           uint64_t channelMask) {
+    for (uint64_t p = 0; p < pixelCount; ++p, pixels += channel) {
+        for (uint64_t c = 0; c < channel; ++c) {
+            if (EBS_ChannelSelected(channelMask, c)) *packed++ = pixels[c];
+        }
+    }
+}
+
+void EBS_ChannelUnpackScalar(uint8_t *pixels, const uint8_t *packed, uint64_t pixelCount, uint64_t channel,
+                             uint64_t channelMask) {
+    for (uint64_t p = 0; p < pixelCount; ++p, pixels += channel) {
+        for (uint64_t c = 0; c < channel; ++c) {
+            if (EBS_ChannelSelected(channelMask, c)) pixels[c] = *packed++;
+        }
+    }
+}
+
+void EBS_ChannelPackRGBScalar(uint8_t *packed, const uint8_t *pixels, uint64_t pixelCount, uint64_t channel,
+                              uint64_t channelMask) {
+    (void) channel;
+    (void) channelMask;
+    for (uint64_t p = 0; p < pixelCount; ++p) {
+        memcpy(packed + 3 * p, pixels + 4 * p, 3);
+    }
+}
+
+void EBS_ChannelUnpackRGBScalar(uint8_t *pixels, const uint8_t *packed, uint64_t pixelCount, uint64_t channel,
+                                uint64_t channelMask) {
+    (void) channel;
+    (void) channelMask;
+    for (uint64_t p = 0; p < pixelCount; ++p) {
+        memcpy(pixels + 4 * p, packed + 3 * p, 3);
+    }
+}
+
+#if EBS_X86_64
+
+EBS_TARGET("sse4.2")
+void EBS_ChannelPackRGBSSE42(uint8_t *packed, const uint8_t *pixels, uint64_t pixelCount, uint64_t channel,
+                             uint64_t channelMask) {
+    // 4 pixels give 12 bytes, stored as 8 and 4 so that nothing is written past them
+    const __m128i shuffle = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+    uint64_t p = 0;
+    for (; p + 4 <= pixelCount; p += 4) {
+        const __m128i rgb = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (pixels + 4 * p)), shuffle);
+        _mm_storel_epi64((__m128i *) (packed + 3 * p), rgb);
+        const uint32_t rest = (uint32_t) _mm_extract_epi32(rgb, 2);
+        memcpy(packed + 3 * p + 8, &rest, sizeof(rest));
+    }
+    EBS_ChannelPackRGBScalar(packed + 3 * p, pixels + 4 * p, pixelCount - p, channel, channelMask);
+}
+
+EBS_TARGET("sse4.2")
+void EBS_ChannelUnpackRGBSSE42(uint8_t *pixels, const uint8_t *packed, uint64_t pixelCount, uint64_t channel,
+                               uint64_t channelMask) {
+    // the alpha bytes are blended back from the pixels, so they keep their value
+    const __m128i shuffle = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    const __m128i alpha = _mm_set1_epi32((int) 0xff000000);
+    uint64_t p = 0;
+    for (; p + 4 <= pixelCount; p += 4) {
+        uint32_t rest;
+        memcpy(&rest, packed + 3 * p + 8, sizeof(rest));
+        const __m128i rgb = _mm_insert_epi32(_mm_loadl_epi64((const __m128i *) (packed + 3 * p)), (int) rest, 2);
+        const __m128i original = _mm_loadu_si128((const __m128i *) (pixels + 4 * p));
+        const __m128i merged = _mm_blendv_epi8(_mm_shuffle_epi8(rgb, shuffle), original, alpha);
+        _mm_storeu_si128((__m128i *) (pixels + 4 * p), merged);
+    }
+    EBS_ChannelUnpackRGBScalar(pixels + 4 * p, packed + 3 * p, pixelCount - p, channel, channelMask);
+}
+
+#endif
+
+EBS_ChannelPackKernel EBS_ChannelPackKernelSelect(uint32_t cpuFeatures, uint64_t channel, uint64_t channelMask) {
+    if (!EBS_ChannelRGB(channel, channelMask)) return EBS_ChannelPackScalar;
+#if EBS_X86_64
+    if (cpuFeatures & EBS_CpuSSE42) return EBS_ChannelPackRGBSSE42;
+#else
+    (void) cpuFeatures;
+#endif
+    return EBS_ChannelPackRGBScalar;
+}
+
+EBS_ChannelUnpackKernel EBS_ChannelUnpackKernelSelect(uint32_t cpuFeatures, uint64_t channel, uint64_t channelMask) {
+    if (!EBS_ChannelRGB(channel, channelMask)) return EBS_ChannelUnpackScalar;
+#if EBS_X86_64
+    if (cpuFeatures & EBS_CpuSSE42) return EBS_ChannelUnpackRGBSSE42;
+#else
+    (void) cpuFeatures;
+#endif
+    return EBS_ChannelUnpackRGBScalar;
+}
+
+EBS_ChannelPackKernel EBS_ChannelPackKernelGet(uint64_t channel, uint64_t channelMask) {
+    // only the RGB kernels depend on the processor
+    static EBS_ChannelPackKernel cache = NULL;
+    if (!EBS_ChannelRGB(channel, channelMask)) return EBS_ChannelPackScalar;
+    EBS_ChannelPackKernel rgb = EBS_KernelLoad(EBS_ChannelPackKernel, cache);
+    if (rgb == NULL) {
+        rgb = EBS_ChannelPackKernelSelect(EBS_CpuFeatures(), channel, channelMask);
+        EBS_KernelStore(cache, rgb);
+    }
+    return rgb;
+}
+
+EBS_ChannelUnpackKernel EBS_ChannelUnpackKernelGet(uint64_t channel, uint64_t channelMask) {
+    static EBS_ChannelUnpackKernel cache = NULL;
+    if (!EBS_ChannelRGB(channel, channelMask)) return EBS_ChannelUnpackScalar;
+    EBS_ChannelUnpackKernel rgb = EBS_KernelLoad(EBS_ChannelUnpackKernel, cache);
+    if (rgb == NULL) {
+        rgb = EBS_ChannelUnpackKernelSelect(EBS_CpuFeatures(), channel, channelMask);
+        EBS_KernelStore(cache, rgb);
+    }
+    return rgb;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <inttypes.h>
+#include <stdbool.h>
+
+#include "cpu.h"
+
+// a mask selects among the first 64 channels, so a packed square row never exceeds this
+#define EBS_CHANNEL_PACKED_ROW (256 * 64)
+
+// the bytes of a 16-bit sample, as two channels of its bytes, the high bits coming second on little endian processors
+#define EBS_CHANNEL_SAMPLE_HIGH (EBS_LITTLE_ENDIAN ? 0x2ull : 0x1ull)
+#define EBS_CHANNEL_SAMPLE_BOTH 0x3ull
+
+typedef void (*EBS_ChannelPackKernel)(uint8_t *packed, const uint8_t *pixels, uint64_t pixelCount, uint64_t channel,
+                                      uint64_t channelMask);
+
+typedef void (*EBS_ChannelUnpackKernel)(uint8_t *pixels, const uint8_t *packed, uint64_t pixelCount,
+                                        uint64_t channel, uint64_t channelMask);
+
+uint64_t EBS_ChannelMaskResolve(uint64_t channel, uint64_t channelMask);
+
+uint64_t EBS_ChannelCount(uint64_t channel, uint64_t channelMask);
+
+uint64_t EBS_ChannelMaskBytes(uint64_t channel, uint64_t channelMask, uint64_t bytes);
+
+bool EBS_ChannelRGB(uint64_t channel, uint64_t channelMask);
+
+void EBS_ChannelPackScalar(uint8_t *packed, const uint8_t *pixels, uint64_t pixelCount, uint64_t channel,
+                           uint64_t channelMask);
+
+void EBS_ChannelUnpackScalar(uint8_t *pixels, const uint8_t *packed, uint64_t pixelCount, uint64_t channel,
+                             uint64_t channelMask);
+
+void EBS_ChannelPackRGBScalar(uint8_t *packed, const uint8_t *pixels, uint64_t pixelCount, uint64_t channel,
+                              uint64_t channelMask);
+
+void EBS_ChannelUnpackRGBScalar(uint8_t *pixels, const uint8_t *packed, uint64_t pixelCount, uint64_t channel,
+                                uint64_t channelMask);
+
+#if EBS_X86_64
+
+void EBS_ChannelPackRGBSSE42(uint8_t *packed, const uint8_t *pixels, uint64_t pixelCount, uint64_t channel,
+                             uint64_t channelMask);
+
+void EBS_ChannelUnpackRGBSSE42(uint8_t *pixels, const uint8_t *packed, uint64_t pixelCount, uint64_t channel,
+                               uint64_t channelMask);
+
+#endif
+
+EBS_ChannelPackKernel EBS_ChannelPackKernelSelect(uint32_t cpuFeatures, uint64_t channel, uint64_t channelMask);
+
+EBS_ChannelUnpackKernel EBS_ChannelUnpackKernelSelect(uint32_t cpuFeatures, uint64_t channel, uint64_t channelMask);
+
+EBS_ChannelPackKernel EBS_ChannelPackKernelGet(uint64_t channel, uint64_t channelMask);
+
+EBS_ChannelUnpackKernel EBS_ChannelUnpackKernelGet(uint64_t channel, uint64_t channelMask);
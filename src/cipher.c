@@ -0,0 +1,217 @@
+#include "cipher.h"
+
+#include <string.h>
+
+#include "context.h"
+
+#if EBS_X86_64
+#include <emmintrin.h>
+#endif
+
+static inline uint32_t EBS_CipherLoad(const uint8_t *bytes) {
+    return (uint32_t) bytes[0] | (uint32_t) bytes[1] << 8 | (uint32_t) bytes[2] << 16 | (uint32_t) bytes[3] << 24;
+}
+
+static inline void EBS_CipherStore(uint8_t *bytes, uint32_t word) {
+    bytes[0] = (uint8_t) word;
+    bytes[1] = (uint8_t) (word >> 8);
+    bytes[2] = (uint8_t) (word >> 16);
+    bytes[3] = (uint8_t) (word >> 24);
+}
+
+void EBS_CipherInit(EBS_Cipher *cipher, const uint8_t *key, const uint8_t *nonce) {
+    // the ChaCha20 layout of RFC 8439: "expand 32-byte k", the key, the block counter and the nonce
+    cipher->state[0] = 0x61707865;
+    cipher->state[1] = 0x3320646e;
+    cipher->state[2] = 0x79622d32;
+    cipher->state[3] = 0x6b206574;
+    for (uint64_t i = 0; i < EBS_CIPHER_KEY / 4; ++i) {
+        cipher->state[4 + i] = EBS_CipherLoad(key + 4 * i);
+    }
+    cipher->state[12] = 0;
+    for (uint64_t i = 0; i < EBS_CIPHER_NONCE / 4; ++i) {
+        cipher->state[13 + i] = EBS_CipherLoad(nonce + 4 * i);
+    }
+}
+
+const EBS_Cipher *EBS_CipherFromOptions(EBS_Cipher *cipher, const EBS_Options *options) {
+    static const uint8_t zeroNonce[EBS_CIPHER_NONCE] = {0};
+    if (options->key == NULL) return NULL;
+    EBS_CipherInit(cipher, options->key, options->nonce == NULL ? zeroNonce : options->nonce);
+    return cipher;
+}
+
+static inline uint32_t EBS_CipherRotate(uint32_t word, int bits) {
+    return word << bits | word >> (32 - bits);
+}
+
+static inline void EBS_CipherQuarter(uint32_t *x, int a, int b, int c, int d) {
+    x[a] += x[b];
+    x[d] = EBS_CipherRotate(x[d] ^ x[a], 16);
+    x[c] += x[d];
+    x[b] = EBS_CipherRotate(x[b] ^ x[c], 12);
+    x[a] += x[b];
+    x[d] = EBS_CipherRotate(x[d] ^ x[a], 8);
+    x[c] += x[d];
+    x[b] = EBS_CipherRotate(x[b] ^ x[c], 7);
+}
+
+void EBS_CipherBlocksScalar(const uint32_t *state, uint64_t block, uint8_t *keystream) {
+    for (uint64_t i = 0; i < EBS_CIPHER_BLOCKS; ++i, ++block, keystream += EBS_CIPHER_BLOCK) {
+        // the counter is 32 bits in RFC 8439, past 256 GiB it carries into the first word of the nonce
+        uint32_t input[16];
+        memcpy(input, state, sizeof(input));
+        input[12] = (uint32_t) block;
+        input[13] += (uint32_t) (block >> 32);
+
+        uint32_t x[16];
+        memcpy(x, input, sizeof(x));
+        for (int round = 0; round < 10; ++round) {
+            EBS_CipherQuarter(x, 0, 4, 8, 12);
+            EBS_CipherQuarter(x, 1, 5, 9, 13);
+            EBS_CipherQuarter(x, 2, 6, 10, 14);
+            EBS_CipherQuarter(x, 3, 7, 11, 15);
+            EBS_CipherQuarter(x, 0, 5, 10, 15);
+            EBS_CipherQuarter(x, 1, 6, 11, 12);
+            EBS_CipherQuarter(x, 2, 7, 8, 13);
+            EBS_CipherQuarter(x, 3, 4, 9, 14);
+        }
+        for (uint64_t k = 0; k < 16; ++k) {
+            EBS_CipherStore(keystream + 4 * k, x[k] + input[k]);
+        }
+    }
+}
+
+#if EBS_X86_64
+
+static inline __m128i EBS_CipherRotateSSE2(__m128i v, int bits) {
+    return _mm_or_si128(_mm_slli_epi32(v, bits), _mm_srli_epi32(v, 32 - bits));
+}
+
+static inline void EBS_CipherQuarterSSE2(__m128i *x, int a, int b, int c, int d) {
+    x[a] = _mm_add_epi32(x[a], x[b]);
+    x[d] = EBS_CipherRotateSSE2(_mm_xor_si128(x[d], x[a]), 16);
+    x[c] = _mm_add_epi32(x[c], x[d]);
+    x[b] = EBS_CipherRotateSSE2(_mm_xor_si128(x[b], x[c]), 12);
+    x[a] = _mm_add_epi32(x[a], x[b]);
+    x[d] = EBS_CipherRotateSSE2(_mm_xor_si128(x[d], x[a]), 8);
+    x[c] = _mm_add_epi32(x[c], x[d]);
+    x[b] = EBS_CipherRotateSSE2(_mm_xor_si128(x[b], x[c]), 7);
+}
+
+void EBS_CipherBlocksSSE2(const uint32_t *state, uint64_t block, uint8_t *keystream) {
+    // lane j of every vector works on block + j, so the 4 blocks go through the rounds together
+    __m128i input[16], x[16];
+    for (int k = 0; k < 16; ++k) {
+        input[k] = _mm_set1_epi32((int) state[k]);
+    }
+    input[12] = _mm_setr_epi32((int) (uint32_t) block, (int) (uint32_t) (block + 1), (int) (uint32_t) (block + 2),
+                               (int) (uint32_t) (block + 3));
+    input[13] = _mm_add_epi32(input[13],
+                              _mm_setr_epi32((int) (uint32_t) (block >> 32), (int) (uint32_t) ((block + 1) >> 32),
+                                             (int) (uint32_t) ((block + 2) >> 32),
+                                             (int) (uint32_t) ((block + 3) >> 32)));
+    memcpy(x, input, sizeof(x));
+    for (int round = 0; round < 10; ++round) {
+        EBS_CipherQuarterSSE2(x, 0, 4, 8, 12);
+        EBS_CipherQuarterSSE2(x, 1, 5, 9, 13);
+        EBS_CipherQuarterSSE2(x, 2, 6, 10, 14);
+        EBS_CipherQuarterSSE2(x, 3, 7, 11, 15);
+        EBS_CipherQuarterSSE2(x, 0, 5, 10, 15);
+        EBS_CipherQuarterSSE2(x, 1, 6, 11, 12);
+        EBS_CipherQuarterSSE2(x, 2, 7, 8, 13);
+        EBS_CipherQuarterSSE2(x, 3, 4, 9, 14);
+    }
+
+    // every 4 words are transposed from lanes into blocks, x86 stores them little endian already
+    for (int k = 0; k < 16; k += 4) {
+        const __m128i a = _mm_add_epi32(x[k], input[k]), b = _mm_add_epi32(x[k + 1], input[k + 1]);
+        const __m128i c = _mm_add_epi32(x[k + 2], input[k + 2]), d = _mm_add_epi32(x[k + 3], input[k + 3]);
+        const __m128i ab0 = _mm_unpacklo_epi32(a, b), ab1 = _mm_unpackhi_epi32(a, b);
+        const __m128i cd0 = _mm_unpacklo_epi32(c, d), cd1 = _mm_unpackhi_epi32(c, d);
+        const __m128i words[EBS_CIPHER_BLOCKS] = {
+                _mm_unpacklo_epi64(ab0, cd0), _mm_unpackhi_epi64(ab0, cd0),
+                _mm_unpacklo_epi64(ab1, cd1), _mm_unpackhi_epi64(ab1, cd1)
+        };
+        for (uint64_t j = 0; j < EBS_CIPHER_BLOCKS; ++j) {
+            _mm_storeu_si128((__m128i *) (keystream + j * EBS_CIPHER_BLOCK + 4 * k), words[j]);
+        }
+    }
+}
+
+#endif
+
+EBS_CipherKernel EBS_CipherKernelSelect(uint32_t cpuFeatures) {
+    (void) cpuFeatures;
+#if EBS_X86_64
+    // SSE2 is part of x86-64 itself
+    return EBS_CipherBlocksSSE2;
+#else
+    return EBS_CipherBlocksScalar;
+#endif
+}
+
+EBS_CipherKernel EBS_CipherKernelGet(void) {
+    static EBS_CipherKernel cache = NULL;
+    EBS_CipherKernel kernel = EBS_KernelLoad(EBS_CipherKernel, cache);
+    if (kernel == NULL) {
+        kernel = EBS_CipherKernelSelect(EBS_CpuFeatures());
+        EBS_KernelStore(cache, kernel);
+    }
+    return kernel;
+}
+
+static void EBS_CipherXor(uint8_t *output, const uint8_t *input, const uint8_t *keystream, uint64_t size) {
+    uint64_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word, stream;
+        memcpy(&word, input + i, sizeof(word));
+        memcpy(&stream, keystream + i, sizeof(stream));
+        word ^= stream;
+        memcpy(output + i, &word, sizeof(word));
+    }
+    for (; i < size; ++i) {
+        output[i] = input[i] ^ keystream[i];
+    }
+}
+
+EBS_CipherStream *EBS_CipherStreamInit(EBS_CipherStream *stream, const EBS_Cipher *cipher) {
+    if (cipher == NULL) return NULL;
+    stream->cipher = cipher;
+    stream->block = 0;
+    stream->valid = false;
+    return stream;
+}
+
+EBS_CipherStream *EBS_CipherStreamsCreate(EBS_Context *context, const EBS_Cipher *cipher, uint64_t workers) {
+    // a stream for every worker, kept over all the tasks it runs, released with EBS_ScratchRelease
+    EBS_CipherStream *streams = (EBS_CipherStream *) EBS_ScratchGet(context, EBS_SCRATCH_CIPHER,
+                                                                    workers * sizeof(EBS_CipherStream));
+    if (streams == NULL) return NULL;
+    for (uint64_t i = 0; i < workers; ++i) {
+        EBS_CipherStreamInit(streams + i, cipher);
+    }
+    return streams;
+}
+
+void EBS_CipherApply(EBS_CipherStream *stream, uint64_t offset, uint8_t *output, const uint8_t *input,
+                     uint64_t size) {
+    // any byte of the keystream is found from its offset alone, so the squares can be encrypted in any order
+    while (size != 0) {
+        const uint64_t block = offset / EBS_CIPHER_BLOCK;
+        if (!stream->valid || block < stream->block || block >= stream->block + EBS_CIPHER_BLOCKS) {
+            EBS_CipherKernelGet()(stream->cipher->state, block, stream->keystream);
+            stream->block = block;
+            stream->valid = true;
+        }
+
+        const uint64_t skip = offset - stream->block * EBS_CIPHER_BLOCK;
+        uint64_t count = sizeof(stream->keystream) - skip;
+        if (count > size) count = size;
+        EBS_CipherXor(output, input, stream->keystream + skip, count);
+        offset += count;
+        output += count;
+        input += count;
+        size -= count;
+    }
+}
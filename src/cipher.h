@@ -0,0 +1,54 @@
+#pragma once
+
+#include <inttypes.h>
+#include <stdbool.h>
+
+#include "../include/EBS/EBS.h"
+#include "cpu.h"
+
+#define EBS_CIPHER_KEY 32
+#define EBS_CIPHER_NONCE 12
+#define EBS_CIPHER_BLOCK 64
+
+// a kernel call gives this many consecutive blocks
+#define EBS_CIPHER_BLOCKS 4
+
+// a square is encrypted through a buffer of this many bytes, a whole number of samples at any depth
+#define EBS_CIPHER_CHUNK (12 * 1024)
+
+typedef struct EBS_Cipher {
+    uint32_t state[16];
+} EBS_Cipher;
+
+// the blocks of keystream last computed, kept by one thread so that the next squares, small and in order, reuse them
+typedef struct EBS_CipherStream {
+    const EBS_Cipher *cipher;
+    uint64_t block;
+    bool valid;
+    uint8_t keystream[EBS_CIPHER_BLOCKS * EBS_CIPHER_BLOCK];
+} EBS_CipherStream;
+
+typedef void (*EBS_CipherKernel)(const uint32_t *state, uint64_t block, uint8_t *keystream);
+
+void EBS_CipherInit(EBS_Cipher *cipher, const uint8_t *key, const uint8_t *nonce);
+
+const EBS_Cipher *EBS_CipherFromOptions(EBS_Cipher *cipher, const EBS_Options *options);
+
+void EBS_CipherBlocksScalar(const uint32_t *state, uint64_t block, uint8_t *keystream);
+
+#if EBS_X86_64
+
+void EBS_CipherBlocksSSE2(const uint32_t *state, uint64_t block, uint8_t *keystream);
+
+#endif
+
+EBS_CipherKernel EBS_CipherKernelSelect(uint32_t cpuFeatures);
+
+EBS_CipherKernel EBS_CipherKernelGet(void);
+
+EBS_CipherStream *EBS_CipherStreamInit(EBS_CipherStream *stream, const EBS_Cipher *cipher);
+
+EBS_CipherStream *EBS_CipherStreamsCreate(EBS_Context *context, const EBS_Cipher *cipher, uint64_t workers);
+
+void EBS_CipherApply(EBS_CipherStream *stream, uint64_t offset, uint8_t *output, const uint8_t *input,
+                     uint64_t size);
@@ -0,0 +1,94 @@
+#include "context.h"
+
+#include <stdlib.h>
+
+#include "cpu.h"
+#include "entropy.h"
+
+static void *EBS_DefaultAllocate(void *user, uint64_t size) {
+    (void) user;
+    return malloc(size);
+}
+
+static void EBS_DefaultDeallocate(void *user, void *pointer) {
+    (void) user;
+    free(pointer);
+}
+
+EBS_Context *EBS_ContextCreate(const EBS_Allocator *allocator, int *errorCode) {
+    const EBS_Allocator defaultAllocator = {
+            .allocate = EBS_DefaultAllocate,
+            .allocateAligned = NULL,
+            .deallocate = EBS_DefaultDeallocate,
+            .user = NULL
+    };
+    if (allocator == NULL) allocator = &defaultAllocator;
+
+    EBS_Context *context = (EBS_Context *) allocator->allocate(allocator->user, sizeof(EBS_Context));
+    if (context == NULL) {
+        *errorCode = EBS_ErrorOOM;
+        return NULL;
+    }
+    context->allocator = *allocator;
+    for (uint64_t i = 0; i < EBS_SCRATCH_SLOTS; ++i) {
+        context->arenas[i] = (EBS_Arena) {NULL, 0};
+    }
+    context->pool = NULL;
+    context->entropyTable = NULL;
+
+    *errorCode = EBS_OK;
+    return context;
+}
+
+void EBS_ContextFree(EBS_Context *context) {
+    if (context == NULL) return;
+    // the threads still use their arena until they are stopped
+    EBS_ThreadPoolFree(context);
+    EBS_EntropyTableFree(context);
+    for (uint64_t i = 0; i < EBS_SCRATCH_SLOTS; ++i) {
+        if (context->arenas[i].data != NULL) {
+            context->allocator.deallocate(context->allocator.user, context->arenas[i].data);
+        }
+    }
+    context->allocator.deallocate(context->allocator.user, context);
+}
+
+void *EBS_Allocate(EBS_Context *context, uint64_t size) {
+    // a size of 0 still gives a pointer, so that NULL always means out of memory
+    if (size == 0) size = 1;
+    if (context == NULL) return malloc(size);
+    return context->allocator.allocate(context->allocator.user, size);
+}
+
+void EBS_Deallocate(EBS_Context *context, void *pointer) {
+    if (context == NULL) {
+        free(pointer);
+    } else if (pointer != NULL) {
+        context->allocator.deallocate(context->allocator.user, pointer);
+    }
+}
+
+void *EBS_ScratchGet(EBS_Context *context, uint64_t slot, uint64_t size) {
+    if (context == NULL) return EBS_Allocate(NULL, size);
+
+    // arenas only grow, by half at least, so that a service settles on sizes it never has to allocate again
+    EBS_Arena *arena = context->arenas + slot;
+    if (size <= arena->size && arena->data != NULL) return arena->data;
+    uint64_t arenaSize = arena->size + arena->size / 2;
+    if (arenaSize < size) arenaSize = size;
+    // whole cache lines, so that the slices threads are given never share one with the next arena
+    arenaSize = (arenaSize + EBS_CACHE_LINE - 1) / EBS_CACHE_LINE * EBS_CACHE_LINE;
+    if (arenaSize == 0) arenaSize = EBS_CACHE_LINE;
+
+    if (arena->data != NULL) context->allocator.deallocate(context->allocator.user, arena->data);
+    arena->data = context->allocator.allocateAligned != NULL ?
+                  context->allocator.allocateAligned(context->allocator.user, EBS_CACHE_LINE, arenaSize) :
+                  context->allocator.allocate(context->allocator.user, arenaSize);
+    arena->size = arena->data == NULL ? 0 : arenaSize;
+    return arena->data;
+}
+
+void EBS_ScratchRelease(EBS_Context *context, void *pointer) {
+    // kept by the arena for the next call
+    if (context == NULL) free(pointer);
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "../include/EBS/EBS.h"
+#include "thread.h"
+
+// the allocations a call frees again before it returns, each kept in an arena of its own between calls
+#define EBS_SCRATCH_IMAGES 0
+#define EBS_SCRATCH_SQUARES 1
+#define EBS_SCRATCH_INDEX 2
+#define EBS_SCRATCH_BANDS 3
+#define EBS_SCRATCH_HISTOGRAMS 4
+#define EBS_SCRATCH_SORT 5
+#define EBS_SCRATCH_MERGE 6
+#define EBS_SCRATCH_PIECES 7
+#define EBS_SCRATCH_STREAM 8
+#define EBS_SCRATCH_MESSAGE 9
+#define EBS_SCRATCH_KEYS 10
+#define EBS_SCRATCH_CIPHER 11
+// held by the threads of the pool until it grows or the context is freed
+#define EBS_SCRATCH_WORKERS 12
+#define EBS_SCRATCH_SLOTS 13
+
+typedef struct EBS_Arena {
+    void *data;
+    uint64_t size;
+} EBS_Arena;
+
+struct EBS_Context {
+    EBS_Allocator allocator;
+    EBS_Arena arenas[EBS_SCRATCH_SLOTS];
+    // made by the first call running on more than one thread
+    EBS_ThreadPool *pool;
+    // made by the first call with squares too large for the static table
+    uint64_t *entropyTable;
+};
+
+void *EBS_Allocate(EBS_Context *context, uint64_t size);
+
+void EBS_Deallocate(EBS_Context *context, void *pointer);
+
+void *EBS_ScratchGet(EBS_Context *context, uint64_t slot, uint64_t size);
+
+void EBS_ScratchRelease(EBS_Context *context, void *pointer);
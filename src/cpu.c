@@ -0,0 +1,30 @@
+#include "cpu.h"
+
+#if EBS_X86_64 && defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+uint32_t EBS_CpuFeatures(void) {
+    uint32_t features = 0;
+#if EBS_X86_64 && (defined(__GNUC__) || defined(__clang__))
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse4.2")) features |= EBS_CpuSSE42;
+    if (__builtin_cpu_supports("avx2")) features |= EBS_CpuAVX2;
+#elif EBS_X86_64 && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    const int maxLeaf = info[0];
+    if (maxLeaf >= 1) {
+        __cpuid(info, 1);
+        if (info[2] & (1 << 20)) features |= EBS_CpuSSE42;
+        // AVX2 also needs the OS to save the YMM state
+        const int osxsave = (info[2] & (1 << 27)) != 0;
+        if (maxLeaf >= 7 && osxsave && (_xgetbv(0) & 0x6) == 0x6) {
+            __cpuidex(info, 7, 0);
+            if (info[1] & (1 << 5)) features |= EBS_CpuAVX2;
+        }
+    }
+#endif
+    return features;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <inttypes.h>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define EBS_X86_64 1
+#else
+#define EBS_X86_64 0
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define EBS_TARGET(features) __attribute__((target(features)))
+#else
+#define EBS_TARGET(features)
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define EBS_Prefetch(address) __builtin_prefetch(address)
+#elif EBS_X86_64
+#include <xmmintrin.h>
+#define EBS_Prefetch(address) _mm_prefetch((const char *) (address), _MM_HINT_T0)
+#else
+#define EBS_Prefetch(address) ((void) (address))
+#endif
+
+#define EBS_CACHE_LINE 64
+
+// kernels resolved on first use are cached with a release store and read back with an acquire load, so threads
+// racing on the first call only ever see NULL or the whole pointer
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define EBS_KernelLoad(type, cache) ((type) _InterlockedCompareExchangePointer((void *volatile *) &(cache), NULL, NULL))
+#define EBS_KernelStore(cache, kernel) _InterlockedExchangePointer((void *volatile *) &(cache), (void *) (kernel))
+#else
+#define EBS_KernelLoad(type, cache) ((type) __atomic_load_n(&(cache), __ATOMIC_ACQUIRE))
+#define EBS_KernelStore(cache, kernel) __atomic_store_n(&(cache), (kernel), __ATOMIC_RELEASE)
+#endif
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define EBS_LITTLE_ENDIAN 0
+#else
+#define EBS_LITTLE_ENDIAN 1
+#endif
+
+static const uint32_t EBS_CpuSSE42 = 1u << 0;
+static const uint32_t EBS_CpuAVX2 = 1u << 1;
+
+uint32_t EBS_CpuFeatures(void);
@@ -1,84 +1,418 @@
 #include "embed.h"
 
 #include <string.h>
+#include <stdlib.h>
 
-void EBS_SquareEmbed(EBS_Image *image, const EBS_Square *square, uint64_t squareSize, const uint8_t *data,
+#define XXH_STATIC_LINKING_ONLY
+#include "xxhash.h"
+
+#include "channel.h"
+#include "thread.h"
+#include "context.h"
+
+static const uint64_t EBS_EmbedLowBits = 0x0101010101010101ull;
+
+static const uint64_t EBS_EmbedLowLanes = 0x0001000100010001ull;
+
+// spreads the bits of a byte over the least significant bits of a word, bit k going to byte k
+static inline uint64_t EBS_EmbedSpread(uint8_t bits) {
+    const uint64_t isolated = ((uint64_t) bits * EBS_EmbedLowBits) & 0x8040201008040201ull;
+    return ((isolated + 0x7f7f7f7f7f7f7f7full) >> 7) & EBS_EmbedLowBits;
+}
+
+// the 8 message bits starting at any bit, the caller makes sure they are all in the message
+static inline uint8_t EBS_EmbedBits(const uint8_t *data, uint64_t bit) {
+    const uint8_t *byte = data + bit / 8;
+    const uint64_t shift = bit % 8;
+    return shift == 0 ? byte[0] : (uint8_t) ((byte[0] >> shift) | (byte[1] << (8 - shift)));
+}
+
+// spreads 8 * depth bits over the low bits of a word, depth bits to each byte, halving the groups at every step
+static inline uint64_t EBS_EmbedSpreadDepth(uint64_t bits, uint64_t depth) {
+    bits = (bits | bits << 4 * (8 - depth)) & 0x0000000100000001ull * ((1ull << 4 * depth) - 1);
+    bits = (bits | bits << 2 * (8 - depth)) & 0x0001000100010001ull * ((1ull << 2 * depth) - 1);
+    return (bits | bits << (8 - depth)) & EBS_EmbedLowBits * ((1ull << depth) - 1);
+}
+
+// up to 32 message bits starting at any bit, reading only the bytes they span
+static inline uint64_t EBS_EmbedWindow(const uint8_t *data, uint64_t bit, uint64_t count) {
+    const uint8_t *byte = data + bit / 8;
+    const uint64_t shift = bit % 8;
+    uint64_t window = 0;
+    for (uint64_t i = 0; i < (shift + count + 7) / 8; ++i) {
+        window |= (uint64_t) byte[i] << (8 * i);
+    }
+    return (window >> shift) & ((1ull << count) - 1);
+}
+
+// writes the message bits [bit, bit + bits) over a row, depth bits per byte, the last byte may take fewer
+static void EBS_EmbedRow(uint8_t *row, const uint8_t *data, uint64_t bit, uint64_t bits, uint64_t depth) {
+    uint64_t x = 0;
+#if EBS_LITTLE_ENDIAN
+    const uint64_t mask = EBS_EmbedLowBits * ((1ull << depth) - 1);
+    for (; (x + 8) * depth <= bits; x += 8) {
+        const uint64_t position = bit + x * depth;
+        const uint64_t spread = depth == 1 ? EBS_EmbedSpread(EBS_EmbedBits(data, position))
+                                           : EBS_EmbedSpreadDepth(EBS_EmbedWindow(data, position, 8 * depth), depth);
+        uint64_t word;
+        memcpy(&word, row + x, sizeof(word));
+        word = (word & ~mask) | spread;
+        memcpy(row + x, &word, sizeof(word));
+    }
+#endif
+    for (; x * depth < bits; ++x) {
+        const uint64_t count = bits - x * depth < depth ? bits - x * depth : depth;
+        const uint8_t keep = (uint8_t) ~((1u << count) - 1);
+        row[x] = (uint8_t) ((row[x] & keep) | EBS_EmbedWindow(data, bit + x * depth, count));
+    }
+}
+
+// spreads 4 * depth bits over the low bits of 4 16-bit lanes, depth bits to each lane
+static inline uint64_t EBS_EmbedSpreadLanes(uint64_t bits, uint64_t depth) {
+    bits = (bits | bits << 2 * (16 - depth)) & 0x0000000100000001ull * ((1ull << 2 * depth) - 1);
+    return (bits | bits << (16 - depth)) & EBS_EmbedLowLanes * ((1ull << depth) - 1);
+}
+
+// the same as EBS_EmbedRow over a row of 16-bit samples, 4 of them to a word
+static void EBS_EmbedRow16(uint8_t *row, const uint8_t *data, uint64_t bit, uint64_t bits, uint64_t depth) {
+    uint64_t x = 0;
+#if EBS_LITTLE_ENDIAN
+    const uint64_t mask = EBS_EmbedLowLanes * ((1ull << depth) - 1);
+    for (; (x + 4) * depth <= bits; x += 4) {
+        uint64_t word;
+        memcpy(&word, row + 2 * x, sizeof(word));
+        word = (word & ~mask) | EBS_EmbedSpreadLanes(EBS_EmbedWindow(data, bit + x * depth, 4 * depth), depth);
+        memcpy(row + 2 * x, &word, sizeof(word));
+    }
+#endif
+    for (; x * depth < bits; ++x) {
+        const uint64_t count = bits - x * depth < depth ? bits - x * depth : depth;
+        uint16_t sample;
+        memcpy(&sample, row + 2 * x, sizeof(sample));
+        sample = (uint16_t) ((sample & ~((1u << count) - 1)) | EBS_EmbedWindow(data, bit + x * depth, count));
+        memcpy(row + 2 * x, &sample, sizeof(sample));
+    }
+}
+
+void EBS_SquareEmbed(EBS_Image *image, const EBS_Square *square, uint64_t squareSize, uint64_t depth,
+                     uint64_t channelMask, EBS_CipherStream *stream, uint64_t offset, const uint8_t *data,
                      uint64_t dataSize) {
-    if (dataSize == 0) return;
-    const uint64_t channel = image->channel;
-    const uint64_t realWidth = image->width * channel;
-    uint64_t index = 0, bit = 0;
-    uint8_t *yStart = image->pixels + (square->y * image->width + square->x) * channel;
-    for (uint64_t y = 0; y < squareSize; ++y, yStart += realWidth) {
-        uint8_t *xStart = yStart;
-        for (uint64_t x = 0; x < squareSize; ++x) {
-            for (uint64_t c = 0; c < channel; ++c, ++xStart) {
-                *xStart &= (uint8_t) 0b11111110;
-                *xStart |= (uint8_t) ((data[index] & (1 << bit)) >> bit);
-                if (++bit == 8) {
-                    bit = 0;
-                    if (++index == dataSize) return;
-                }
+    // 16-bit samples are read as pairs of byte channels, a mask selecting both bytes of a sample packs whole samples
+    const uint64_t sampleSize = EBS_ImageSampleSize(image);
+    const uint64_t channel = image->channel * sampleSize;
+    const uint64_t realWidth = EBS_ImageStride(image);
+    const uint64_t rowBits = squareSize * EBS_ChannelCount(image->channel, channelMask) * depth;
+    if (sampleSize != 1) channelMask = EBS_ChannelMaskBytes(image->channel, channelMask, EBS_CHANNEL_SAMPLE_BOTH);
+    channelMask = EBS_ChannelMaskResolve(channel, channelMask);
+    void (*const embedRow)(uint8_t *, const uint8_t *, uint64_t, uint64_t, uint64_t) =
+            sampleSize == 1 ? EBS_EmbedRow : EBS_EmbedRow16;
+
+    // depth message bits per sample of the square, row after row, stopping wherever the message or the square ends
+    uint64_t bits = rowBits * squareSize;
+    if (dataSize < bits / 8) bits = dataSize * 8;
+    uint8_t *pixels = image->pixels + EBS_SquareY(*square, image, squareSize) * realWidth +
+                      EBS_SquareX(*square, image, squareSize) * channel;
+
+    // with a key the message is encrypted a chunk at a time into a buffer the rows read from, while it's still in
+    // cache, a chunk may end inside a row but always on a whole sample
+    // with a mask the selected channels of a row are packed, written as a narrower row and put back
+    const EBS_ChannelPackKernel pack = EBS_ChannelPackKernelGet(channel, channelMask);
+    const EBS_ChannelUnpackKernel unpack = EBS_ChannelUnpackKernelGet(channel, channelMask);
+    uint8_t packed[EBS_CHANNEL_PACKED_ROW];
+    uint8_t encrypted[EBS_CIPHER_CHUNK];
+    const uint64_t chunkBits = stream == NULL ? bits : EBS_CIPHER_CHUNK * 8;
+    for (uint64_t chunk = 0; chunk < bits; chunk += chunkBits) {
+        const uint64_t chunkEnd = bits - chunk < chunkBits ? bits : chunk + chunkBits;
+        const uint8_t *source = data + chunk / 8;
+        if (stream != NULL) {
+            EBS_CipherApply(stream, offset + chunk / 8, encrypted, source, (chunkEnd - chunk) / 8);
+            source = encrypted;
+        }
+
+        for (uint64_t bit = chunk; bit < chunkEnd;) {
+            const uint64_t rowStart = bit - bit % rowBits;
+            const uint64_t end = rowStart + rowBits < chunkEnd ? rowStart + rowBits : chunkEnd;
+            uint8_t *row = pixels + rowStart / rowBits * realWidth;
+            if (channelMask == 0) {
+                embedRow(row + (bit - rowStart) / depth * sampleSize, source, bit - chunk, end - bit, depth);
+            } else {
+                pack(packed, row, squareSize, channel, channelMask);
+                embedRow(packed + (bit - rowStart) / depth * sampleSize, source, bit - chunk, end - bit, depth);
+                unpack(row, packed, squareSize, channel, channelMask);
             }
+            bit = end;
         }
     }
 }
 
 void EBS_MessageEmbed(EBS_ImageList *imageList, const EBS_Message *message, uint64_t squareSize, int *errorCode) {
-    if (!EBS_SquareSizeCheck(squareSize)) {
-        *errorCode = EBS_ErrorBadSquareSize;
-        return;
+    const EBS_Options options = {
+            .squareSize = squareSize,
+            .threadCount = 1
+    };
+    EBS_MessageEmbedWithOptions(imageList, message, &options, errorCode);
+}
+
+typedef struct EBS_EmbedContext {
+    const EBS_ComputedImageList *computedImageList;
+    // the bytes of the message from dataOffset on, all of it in memory or the part a reader filled
+    const uint8_t *data;
+    uint64_t dataOffset;
+    const EBS_SquarePiece *pieces;
+    uint64_t pieceCount;
+    uint64_t piecesPerTask;
+    uint64_t taskBase;
+    uint64_t squareSize;
+    uint64_t depth;
+    uint64_t channelMask;
+    // a stream of keystream per worker, NULL without a key
+    EBS_CipherStream *streams;
+    const uint8_t *header;
+    uint64_t headerSize;
+    bool checksum;
+} EBS_EmbedContext;
+
+static void EBS_EmbedTaskRun(void *context, uint64_t task, uint64_t worker) {
+    const EBS_EmbedContext *embedContext = context;
+    EBS_CipherStream *stream = embedContext->streams == NULL ? NULL : embedContext->streams + worker;
+    task += embedContext->taskBase;
+    const uint64_t begin = task * embedContext->piecesPerTask;
+    const uint64_t end = begin + embedContext->piecesPerTask < embedContext->pieceCount ?
+                         begin + embedContext->piecesPerTask : embedContext->pieceCount;
+    for (uint64_t i = begin; i < end; ++i) {
+        const EBS_SquarePiece *piece = embedContext->pieces + i;
+        // a checksum is only known once the whole message was read, so then the header is written last
+        if (i == 0 && embedContext->checksum) continue;
+
+        // the keystream runs over the header and then the message, as they are laid out in the squares
+        const uint8_t *data = i == 0 ? embedContext->header :
+                              embedContext->data + (piece->offset - embedContext->dataOffset);
+        const uint64_t offset = i == 0 ? 0 : embedContext->headerSize + piece->offset;
+        EBS_SquareEmbed(&embedContext->computedImageList->computedImages[piece->computedImageIndex].image,
+                        piece->square, embedContext->squareSize, embedContext->depth, embedContext->channelMask,
+                        stream, offset, data, piece->size);
     }
+}
 
-    if (!EBS_ImageListCheck(imageList)) {
-        *errorCode = EBS_ErrorInvalidImage;
+// a reader may give fewer bytes than asked, like fread, but none at all means the message ended early
+static bool EBS_EmbedRead(EBS_Reader reader, void *readerContext, uint8_t *buffer, uint64_t size) {
+    while (size != 0) {
+        const uint64_t count = reader(readerContext, buffer, size);
+        if (count == 0 || count > size) return false;
+        buffer += count;
+        size -= count;
+    }
+    return true;
+}
+
+// the tasks are run a batch of as many as there are workers at a time, their bytes coming in the order of the message
+// so that its checksum is hashed along the way, just before the batch reads them again from cache, a message in
+// memory is used where it is and one from a reader goes through a buffer holding the bytes of the largest batch
+static bool EBS_EmbedBatches(EBS_EmbedContext *context, uint64_t taskCount, uint64_t workers, const uint8_t *data,
+                             EBS_Reader reader, void *readerContext, uint64_t messageSize, uint64_t *checksum,
+                             int *errorCode) {
+    EBS_Context *scratch = context->computedImageList->context;
+    uint8_t *buffer = NULL;
+    if (data == NULL) {
+        uint64_t bufferSize = 1;
+        for (uint64_t task = 0; task < taskCount; task += workers) {
+            uint64_t begin, end;
+            EBS_SquarePiecesBytes(context->pieces, context->pieceCount, context->piecesPerTask, task, task + workers,
+                                  &begin, &end);
+            if (end - begin > bufferSize) bufferSize = end - begin;
+        }
+        buffer = (uint8_t *) EBS_ScratchGet(scratch, EBS_SCRATCH_STREAM, bufferSize);
+        if (buffer == NULL) {
+            *errorCode = EBS_ErrorOOM;
+            return false;
+        }
+    }
+    // part of the format, the XXH3-64 of the whole message seeded with its size, whatever tasks it was split into
+    XXH3_state_t state;
+    XXH3_INITSTATE(&state);
+    XXH3_64bits_reset_withSeed(&state, messageSize);
+
+    for (uint64_t task = 0; task < taskCount; task += workers) {
+        uint64_t begin, end;
+        EBS_SquarePiecesBytes(context->pieces, context->pieceCount, context->piecesPerTask, task, task + workers,
+                              &begin, &end);
+        const uint8_t *bytes;
+        if (data != NULL) {
+            bytes = data + begin;
+        } else {
+            if (!EBS_EmbedRead(reader, readerContext, buffer, end - begin)) {
+                EBS_ScratchRelease(scratch, buffer);
+                *errorCode = EBS_ErrorStream;
+                return false;
+            }
+            bytes = buffer;
+            context->data = buffer;
+            context->dataOffset = begin;
+        }
+        if (context->checksum) XXH3_64bits_update(&state, bytes, end - begin);
+        context->taskBase = task;
+        const uint64_t count = taskCount - task < workers ? taskCount - task : workers;
+        EBS_ParallelFor(scratch, workers, count, EBS_EmbedTaskRun, context);
+    }
+
+    if (context->checksum) *checksum = XXH3_64bits_digest(&state);
+    EBS_ScratchRelease(scratch, buffer);
+    return true;
+}
+
+// the message is either data in memory or, with data NULL, read a few tasks at a time from the reader
+static void EBS_EmbedMessage(const EBS_ComputedImageList *computedImageList, uint64_t messageSize,
+                             const uint8_t *data, EBS_Reader reader, void *readerContext, uint64_t squareSize,
+                             uint64_t depth, uint64_t channelMask, const EBS_Cipher *cipher, bool checksum,
+                             uint64_t threadCount, int *errorCode) {
+    // even an empty message needs a square for its header
+    const uint64_t capacity = EBS_ComputedImageListCalcCapacity(computedImageList, checksum);
+    if (messageSize > capacity ||
+        EBS_ComputedImageListFindMaxEntropy(computedImageList, NULL) == computedImageList->size) {
+        *errorCode = EBS_ErrorOverflow;
         return;
     }
 
-    EBS_ComputedImageList computedImageList = EBS_ComputedImageListCreate(imageList, squareSize);
-    if (computedImageList.computedImages == NULL) {
+    // every square gets its bytes of the message first, then the squares are written by as many threads
+    uint64_t header[2] = {messageSize, 0};
+    EBS_EmbedContext context = {
+            .computedImageList = computedImageList,
+            .data = data,
+            .squareSize = squareSize,
+            .depth = depth,
+            .channelMask = channelMask,
+            .header = (const uint8_t *) header,
+            .headerSize = EBS_HeaderSize(checksum),
+            .checksum = checksum
+    };
+    EBS_Context *scratch = computedImageList->context;
+    EBS_SquarePiece *pieces = EBS_SquarePiecesCreate(computedImageList, context.headerSize, messageSize,
+                                                     &context.pieceCount);
+    if (pieces == NULL) {
         *errorCode = EBS_ErrorOOM;
         return;
     }
 
-    const uint64_t capacity = EBS_ComputedImageListCalcCapacity(&computedImageList);
-    if (message->size > capacity) {
-        EBS_ComputedImageListFree(&computedImageList);
+    // the whole header has to fit in its square for the checksum to be read back
+    const EBS_SquareList *headerList = &computedImageList->computedImages[pieces[0].computedImageIndex].squareList;
+    if (checksum && headerList->squareCapacity < context.headerSize) {
+        EBS_ScratchRelease(scratch, pieces);
         *errorCode = EBS_ErrorOverflow;
         return;
     }
 
-    uint64_t messageIndex = 0;
-    uint64_t squareIndex[computedImageList.size];
-    memset(squareIndex, 0, computedImageList.size * sizeof(uint64_t));
+    context.pieces = pieces;
+    context.piecesPerTask = EBS_SquarePiecesPerTask(context.pieceCount, messageSize);
+    const uint64_t taskCount = (context.pieceCount + context.piecesPerTask - 1) / context.piecesPerTask;
 
-    {
-        const uint64_t maxComputedImageIndex = EBS_ComputedImageListFindMaxEntropy(&computedImageList, squareIndex);
-        EBS_ComputedImage *maxComputedImage = computedImageList.computedImages + maxComputedImageIndex;
-        EBS_SquareEmbed(&maxComputedImage->image, maxComputedImage->squareList.squares, squareSize,
-                        (const uint8_t *) &message->size, sizeof(message->size));
-        ++squareIndex[maxComputedImageIndex];
+    const uint64_t workers = EBS_ParallelWorkers(threadCount, taskCount);
+    if (cipher != NULL) {
+        context.streams = EBS_CipherStreamsCreate(scratch, cipher, workers);
+        if (context.streams == NULL) {
+            EBS_ScratchRelease(scratch, pieces);
+            *errorCode = EBS_ErrorOOM;
+            return;
+        }
+    }
+    // without a checksum nor a reader the tasks don't have to go in the order of the message
+    if (data != NULL && !checksum) {
+        EBS_ParallelFor(scratch, workers, taskCount, EBS_EmbedTaskRun, &context);
+    } else if (!EBS_EmbedBatches(&context, taskCount, workers, data, reader, readerContext, messageSize, header + 1,
+                                 errorCode)) {
+        EBS_ScratchRelease(scratch, context.streams);
+        EBS_ScratchRelease(scratch, pieces);
+        return;
     }
+    EBS_ScratchRelease(scratch, context.streams);
 
-    while (true) {
-        const uint64_t maxComputedImageIndex = EBS_ComputedImageListFindMaxEntropy(&computedImageList, squareIndex);
-        EBS_ComputedImage *maxComputedImage = computedImageList.computedImages + maxComputedImageIndex;
+    if (checksum) {
+        EBS_CipherStream cipherStream;
+        EBS_SquareEmbed(&computedImageList->computedImages[pieces[0].computedImageIndex].image, pieces[0].square,
+                        squareSize, depth, channelMask, EBS_CipherStreamInit(&cipherStream, cipher), 0,
+                        context.header, context.headerSize);
+    }
 
-        const EBS_Square *square = maxComputedImage->squareList.squares + squareIndex[maxComputedImageIndex];
-        uint64_t messagePieceSize = maxComputedImage->squareList.squareCapacity;
-        if (messagePieceSize > message->size - messageIndex) {
-            messagePieceSize = message->size - messageIndex;
-            EBS_SquareEmbed(&maxComputedImage->image, square, squareSize, message->data + messageIndex,
-                            messagePieceSize);
-            break;
-        }
-        EBS_SquareEmbed(&maxComputedImage->image, square, squareSize, message->data + messageIndex, messagePieceSize);
+    EBS_ScratchRelease(scratch, pieces);
+    *errorCode = EBS_OK;
+}
+
+void EBS_ComputedImageListEmbed(const EBS_ComputedImageList *computedImageList, const EBS_Message *message,
+                                uint64_t squareSize, uint64_t depth, uint64_t channelMask, const EBS_Cipher *cipher,
+                                bool checksum, uint64_t threadCount, int *errorCode) {
+    // an empty message may come without data, but it's never read
+    static const uint8_t empty = 0;
+    EBS_EmbedMessage(computedImageList, message->size, message->data == NULL ? &empty : message->data, NULL, NULL,
+                     squareSize, depth, channelMask, cipher, checksum, threadCount, errorCode);
+}
+
+void EBS_ComputedImageListEmbedStream(const EBS_ComputedImageList *computedImageList, uint64_t messageSize,
+                                      EBS_Reader reader, void *readerContext, uint64_t squareSize, uint64_t depth,
+                                      uint64_t channelMask, const EBS_Cipher *cipher, bool checksum,
+                                      uint64_t threadCount, int *errorCode) {
+    EBS_EmbedMessage(computedImageList, messageSize, NULL, reader, readerContext, squareSize, depth, channelMask,
+                     cipher, checksum, threadCount, errorCode);
+}
 
-        ++squareIndex[maxComputedImageIndex];
-        messageIndex += messagePieceSize;
+// the checks and the ordering shared by embedding a message from memory or from a reader
+static void EBS_EmbedWithOptions(EBS_ImageList *imageList, uint64_t messageSize, const uint8_t *data,
+                                 EBS_Reader reader, void *readerContext, const EBS_Options *options, int *errorCode) {
+    const uint64_t squareSize = options->squareSize;
+    if (!EBS_SquareSizeCheck(squareSize)) {
+        *errorCode = EBS_ErrorBadSquareSize;
+        return;
+    }
+
+    const uint64_t depth = EBS_OptionsDepth(options);
+    if (!EBS_DepthCheck(depth)) {
+        *errorCode = EBS_ErrorBadDepth;
+        return;
+    }
+
+    if (!EBS_ImageListCheck(imageList)) {
+        *errorCode = EBS_ErrorInvalidImage;
+        return;
+    }
+
+    if (!EBS_ChannelMaskCheck(imageList, options->channelMask)) {
+        *errorCode = EBS_ErrorBadChannelMask;
+        return;
+    }
+
+    // only the squares the message can reach have to be ordered
+    const uint64_t squareLimit = EBS_MessageSquareCount(imageList, squareSize, depth, options->channelMask,
+                                                        messageSize);
+    EBS_ComputedImageList computedImageList = EBS_ComputedImageListCreate(imageList, options, squareLimit);
+    if (computedImageList.computedImages == NULL) {
+        *errorCode = EBS_ErrorOOM;
+        return;
+    }
+
+    EBS_Cipher cipher;
+    if (reader == NULL) {
+        const EBS_Message message = {messageSize, (uint8_t *) data};
+        EBS_ComputedImageListEmbed(&computedImageList, &message, squareSize, depth, options->channelMask,
+                                   EBS_CipherFromOptions(&cipher, options), options->checksum, options->threadCount,
+                                   errorCode);
+    } else {
+        EBS_ComputedImageListEmbedStream(&computedImageList, messageSize, reader, readerContext, squareSize, depth,
+                                         options->channelMask, EBS_CipherFromOptions(&cipher, options),
+                                         options->checksum, options->threadCount, errorCode);
     }
 
     EBS_ComputedImageListFree(&computedImageList);
+}
 
-    *errorCode = EBS_OK;
+void EBS_MessageEmbedWithOptions(EBS_ImageList *imageList, const EBS_Message *message, const EBS_Options *options,
+                                 int *errorCode) {
+    EBS_EmbedWithOptions(imageList, message->size, message->data, NULL, NULL, options, errorCode);
+}
+
+void EBS_MessageEmbedStream(EBS_ImageList *imageList, uint64_t messageSize, EBS_Reader reader, void *readerContext,
+                            const EBS_Options *options, int *errorCode) {
+    // without a reader the message would be taken from memory, which isn't there
+    if (reader == NULL && messageSize != 0) {
+        *errorCode = EBS_ErrorStream;
+        return;
+    }
+    EBS_EmbedWithOptions(imageList, messageSize, NULL, reader, readerContext, options, errorCode);
 }
@@ -2,6 +2,17 @@
 
 #include "../include/EBS/EBS.h"
 #include "shared.h"
+#include "cipher.h"
 
-void EBS_SquareEmbed(EBS_Image *image, const EBS_Square *square, uint64_t squareSize, const uint8_t *data,
+void EBS_SquareEmbed(EBS_Image *image, const EBS_Square *square, uint64_t squareSize, uint64_t depth,
+                     uint64_t channelMask, EBS_CipherStream *stream, uint64_t offset, const uint8_t *data,
                      uint64_t dataSize);
+
+void EBS_ComputedImageListEmbed(const EBS_ComputedImageList *computedImageList, const EBS_Message *message,
+                                uint64_t squareSize, uint64_t depth, uint64_t channelMask, const EBS_Cipher *cipher,
+                                bool checksum, uint64_t threadCount, int *errorCode);
+
+void EBS_ComputedImageListEmbedStream(const EBS_ComputedImageList *computedImageList, uint64_t messageSize,
+                                      EBS_Reader reader, void *readerContext, uint64_t squareSize, uint64_t depth,
+                                      uint64_t channelMask, const EBS_Cipher *cipher, bool checksum,
+                                      uint64_t threadCount, int *errorCode);
@@ -0,0 +1,125 @@
+#include "entropy.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "context.h"
+
+// the largest valid square is 252x252
+#define EBS_ENTROPY_TABLE_SIZE (252 * 252 + 1)
+
+#define EBS_ENTROPY_LOG2_FRACTION_BITS 44
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+static uint64_t *EBS_EntropyTable = NULL;
+
+static uint64_t *EBS_EntropyTableLoad(void) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    return (uint64_t *) _InterlockedCompareExchangePointer((void *volatile *) &EBS_EntropyTable, NULL, NULL);
+#else
+    return __atomic_load_n(&EBS_EntropyTable, __ATOMIC_ACQUIRE);
+#endif
+}
+
+static bool EBS_EntropyTablePublish(uint64_t *table) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    return _InterlockedCompareExchangePointer((void *volatile *) &EBS_EntropyTable, table, NULL) == NULL;
+#else
+    uint64_t *expected = NULL;
+    return __atomic_compare_exchange_n(&EBS_EntropyTable, &expected, table, false, __ATOMIC_ACQ_REL,
+                                       __ATOMIC_ACQUIRE);
+#endif
+}
+
+static uint64_t EBS_MulHigh(uint64_t a, uint64_t b) {
+    const uint64_t aLow = a & 0xffffffff, aHigh = a >> 32;
+    const uint64_t bLow = b & 0xffffffff, bHigh = b >> 32;
+    const uint64_t lowLow = aLow * bLow, lowHigh = aLow * bHigh;
+    const uint64_t highLow = aHigh * bLow, highHigh = aHigh * bHigh;
+    const uint64_t middle = (lowLow >> 32) + (lowHigh & 0xffffffff) + (highLow & 0xffffffff);
+    return highHigh + (lowHigh >> 32) + (highLow >> 32) + (middle >> 32);
+}
+
+uint64_t EBS_EntropyLog2(uint64_t n) {
+    uint64_t integer = 0;
+    while ((n >> integer) > 1) ++integer;
+
+    // the mantissa in [1, 2) as Q1.63, squared once per fraction bit
+    uint64_t mantissa = n << (63 - integer);
+    uint64_t fraction = 0;
+    for (uint64_t i = 0; i < EBS_ENTROPY_LOG2_FRACTION_BITS; ++i) {
+        const uint64_t high = EBS_MulHigh(mantissa, mantissa);
+        const uint64_t low = mantissa * mantissa;
+        fraction <<= 1;
+        if (high >> 63) {
+            fraction |= 1;
+            mantissa = high;
+        } else {
+            mantissa = (high << 1) | (low >> 63);
+        }
+    }
+    return (integer << EBS_ENTROPY_LOG2_FRACTION_BITS) | fraction;
+}
+
+uint64_t EBS_EntropyTableValue(uint64_t n) {
+    if (n == 0) return 0;
+    // n < 2^16 and log2(n) < 16, so the product stays below 2^64
+    const uint64_t shift = EBS_ENTROPY_LOG2_FRACTION_BITS - EBS_ENTROPY_FRACTION_BITS;
+    return (n * EBS_EntropyLog2(n) + (1ull << (shift - 1))) >> shift;
+}
+
+static void EBS_EntropyTableFill(uint64_t *table) {
+    for (uint64_t n = 0; n < EBS_ENTROPY_TABLE_SIZE; ++n) {
+        table[n] = EBS_EntropyTableValue(n);
+    }
+}
+
+const uint64_t *EBS_EntropyTableGet(EBS_Context *context, uint64_t squareSize) {
+    if (squareSize * squareSize < EBS_ENTROPY_STATIC_TABLE_SIZE) return EBS_EntropyStaticTable;
+
+    // a context computes its own, through its allocator, and keeps it until it's freed
+    if (context != NULL) {
+        if (context->entropyTable == NULL) {
+            uint64_t *table = (uint64_t *) EBS_Allocate(context, EBS_ENTROPY_TABLE_SIZE * sizeof(uint64_t));
+            if (table == NULL) return NULL;
+            EBS_EntropyTableFill(table);
+            context->entropyTable = table;
+        }
+        return context->entropyTable;
+    }
+
+    uint64_t *table = EBS_EntropyTableLoad();
+    if (table != NULL) return table;
+
+    table = (uint64_t *) malloc(EBS_ENTROPY_TABLE_SIZE * sizeof(uint64_t));
+    if (table == NULL) return NULL;
+    EBS_EntropyTableFill(table);
+
+    // the table is never freed, the losing thread drops its identical copy
+    if (!EBS_EntropyTablePublish(table)) {
+        free(table);
+        table = EBS_EntropyTableLoad();
+    }
+    return table;
+}
+
+void EBS_EntropyTableFree(EBS_Context *context) {
+    EBS_Deallocate(context, context->entropyTable);
+    context->entropyTable = NULL;
+}
+
+uint64_t EBS_EntropySum(const uint64_t *entropyTable, const uint16_t *histogram) {
+    uint64_t sum = 0;
+    for (uint64_t i = 0; i < EBS_HISTOGRAM_BINS; ++i) {
+        sum += entropyTable[histogram[i]];
+    }
+    return sum;
+}
+
+uint32_t EBS_EntropyKey(const uint64_t *entropyTable, uint64_t count, uint64_t channel, uint64_t sum) {
+    // the mean over channels of log2(count) - sum(n * log2(n)) / count
+    return (uint32_t) ((channel * entropyTable[count] - sum) / (channel * count));
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <inttypes.h>
+
+#include "../include/EBS/EBS.h"
+#include "histogram.h"
+
+#define EBS_ENTROPY_FRACTION_BITS 28
+
+#define EBS_ENTROPY_STATIC_TABLE_SIZE 1025
+
+extern const uint64_t EBS_EntropyStaticTable[EBS_ENTROPY_STATIC_TABLE_SIZE];
+
+uint64_t EBS_EntropyLog2(uint64_t n);
+
+uint64_t EBS_EntropyTableValue(uint64_t n);
+
+const uint64_t *EBS_EntropyTableGet(EBS_Context *context, uint64_t squareSize);
+
+void EBS_EntropyTableFree(EBS_Context *context);
+
+uint64_t EBS_EntropySum(const uint64_t *entropyTable, const uint16_t *histogram);
+
+uint32_t EBS_EntropyKey(const uint64_t *entropyTable, uint64_t count, uint64_t channel, uint64_t sum);
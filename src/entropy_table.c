@@ -0,0 +1,262 @@
+#include "entropy.h"
+
+// generated with EBS_EntropyTableValue, covers squares up to 32x32
+const uint64_t EBS_EntropyStaticTable[EBS_ENTROPY_STATIC_TABLE_SIZE] = {
+        0x0000000000000ull, 0x0000000000000ull, 0x0000020000000ull, 0x000004c1404ebull,
+        0x0000080000000ull, 0x00000b9c1165full, 0x00000f82809d6ull, 0x000013a6c7af7ull,
+        0x0000180000000ull, 0x00001c8781d81ull, 0x0000213822cbeull, 0x0000260dc26a9ull,
+        0x00002b05013abull, 0x0000301b1039dull, 0x0000354d8f5edull, 0x00003a9a75bb3ull,
+        0x0000400000000ull, 0x0000457ca366aull, 0x00004b0f03b02ull, 0x000050b5eb5f7ull,
+        0x000056704597bull, 0x00005c3d19350ull, 0x0000621b84d51ull, 0x0000680abb98aull,
+        0x00006e0a02757ull, 0x00007418adfb4ull, 0x00007a362073aull, 0x00008061c84c6ull,
+        0x0000869b1ebdaull, 0x00008ce1a6a1eull, 0x00009334eb765ull, 0x00009994807dcull,
+        0x0000a00000000ull, 0x0000a6770aa11ull, 0x0000acf946cd5ull, 0x0000b38660368ull,
+        0x0000ba1e07605ull, 0x0000c0bff1393ull, 0x0000c76bd6befull, 0x0000ce2174ac4ull,
+        0x0000d4e08b2f6ull, 0x0000dba8dda7cull, 0x0000e27a326a0ull, 0x0000e954528a2ull,
+        0x0000f03709aa2ull, 0x0000f72225cdbull, 0x0000fe1577313ull, 0x00010510d024full,
+        0x00010c1404eaeull, 0x0001131eeb97cull, 0x00011a315bf67ull, 0x0001214b2f6d8ull,
+        0x0001286c40e73ull, 0x00012f946cbafull, 0x000136c39098bull, 0x00013df98b75dull,
+        0x000145363d7b5ull, 0x00014c7987f55ull, 0x000153c34d43dull, 0x00015b1370cc5ull,
+        0x00016269d6ecaull, 0x000169c664ee7ull, 0x0001712900fb9ull, 0x0001789192134ull,
+        0x0001800000000ull, 0x00018774334e0ull, 0x00018eee15422ull, 0x0001966d8fd1cull,
+        0x00019df28d9aaull, 0x0001a57cf9db7ull, 0x0001ad0cc06d0ull, 0x0001b4a1cdbbaull,
+        0x0001bc3c0ec0aull, 0x0001c3db70fccull, 0x0001cb7fe2727ull, 0x0001d32951a0aull,
+        0x0001dad7ad7deull, 0x0001e28ae5734ull, 0x0001ea42e9588ull, 0x0001f1ffa96f1ull,
+        0x0001f9c1165ecull, 0x0002018721316ull, 0x00020951bb4f7ull, 0x00021120d67c8ull,
+        0x000218f464d40ull, 0x000220cc58c5full, 0x000228a8a5143ull, 0x000230893ccf6ull,
+        0x0002386e13544ull, 0x000240571c492ull, 0x000248444b9b6ull, 0x00025035957cfull,
+        0x0002582aee626ull, 0x000260244b006ull, 0x00026821a049eull, 0x00027022e36ddull,
+        0x0002782809d5cull, 0x0002803109237ull, 0x0002883dd72f9ull, 0x0002904e6a07aull,
+        0x00029862b7eceull, 0x0002a07ab7523ull, 0x0002a8965edb0ull, 0x0002b0b5a559cull,
+        0x0002b8d881ce7ull, 0x0002c0feeb655ull, 0x0002c928d975eull, 0x0002d15643815ull,
+        0x0002d98721316ull, 0x0002e1bb6a579ull, 0x0002e9f316ebaull, 0x0002f22e1f0acull,
+        0x0002fa6c7af6aull, 0x000302ae23141ull, 0x00030af30feaaull, 0x0003133b3a233ull,
+        0x00031b869a879ull, 0x000323d52a013ull, 0x00032c26e198aull, 0x0003347bba749ull,
+        0x00033cd3add95ull, 0x0003452eb527cull, 0x00034d8cc9dceull, 0x000355ede5910ull,
+        0x00035e5201f72ull, 0x000366b918dc2ull, 0x00036f2324268ull, 0x000377901dd55ull,
+        0x0003800000000ull, 0x00038872c4d58ull, 0x000390e8669c0ull, 0x00039960dfb00ull,
+        0x0003a1dc2a845ull, 0x0003aa5a41a11ull, 0x0003b2db1fa39ull, 0x0003bb5ebf3daull,
+        0x0003c3e51b354ull, 0x0003cc6e2e640ull, 0x0003d4f9f3b6eull, 0x0003dd88662d8ull,
+        0x0003e61980da1ull, 0x0003eead3ee0bull, 0x0003f7439b774ull, 0x0003ffdc91e4cull,
+        0x000408781d814ull, 0x0004111639b53ull, 0x000419b6e1f97ull, 0x0004225a11d6aull,
+        0x00042affc4e4eull, 0x000433a7f6cbaull, 0x00043c52a3415ull, 0x000444ffc60aeull,
+        0x00044daf5afbbull, 0x000456615df53ull, 0x00045f15cae69ull, 0x000467cc9dcc8ull,
+        0x00047085d2b0full, 0x0004794165aafull, 0x000481ff52de2ull, 0x00048abf967adull,
+        0x000493822cbd8ull, 0x00049c4711eebull, 0x0004a50e4262cull, 0x0004add7ba79bull,
+        0x0004b6a3769eeull, 0x0004bf717348dull, 0x0004c841acf90ull, 0x0004d114203bcull,
+        0x0004d9e8c9a7full, 0x0004e2bfa5dedull, 0x0004eb98b18beull, 0x0004f473e964aull,
+        0x0004fd514a286ull, 0x00050630d0a04ull, 0x00050f12799edull, 0x000517f641ffdull,
+        0x000520dc26a89ull, 0x000529c424870ull, 0x000532ae38925ull, 0x00053b9a5fca1ull,
+        0x000544889736cull, 0x00054d78dbe90ull, 0x0005566b2af9full, 0x00055f5f818adull,
+        0x00056855dcc4dull, 0x0005714e39d93ull, 0x00057a489600dull, 0x00058344ee7c4ull,
+        0x00058c434093bull, 0x0005954389969ull, 0x00059e45c6dbbull, 0x0005a749f5c0full,
+        0x0005b05013ab8ull, 0x0005b9581e073ull, 0x0005c2621246eull, 0x0005cb6dede42ull,
+        0x0005d47bae5f1ull, 0x0005dd8b513e7ull, 0x0005e69cd40f5ull, 0x0005efb034653ull,
+        0x0005f8c56fd9cull, 0x000601dc840ceull, 0x00060af56ea46ull, 0x000614102d4c4ull,
+        0x00061d2cbdb61ull, 0x0006264b1d997ull, 0x00062f6b4ab38ull, 0x0006388d42c73ull,
+        0x000641b1039cdull, 0x00064ad68b024ull, 0x000653fdd6caaull, 0x00065d26e4ce9ull,
+        0x00066651b2ebcull, 0x00066f7e3f052ull, 0x000678ac87029ull, 0x000681dc88d12ull,
+        0x00068b0e4262cull, 0x00069441b1ae4ull, 0x00069d76d4af2ull, 0x0006a6ada965dull,
+        0x0006afe62dd74ull, 0x0006b920600d2ull, 0x0006c25c3e159ull, 0x0006cb99c6034ull,
+        0x0006d4d8f5ed3ull, 0x0006de19cbeeeull, 0x0006e75c46282ull, 0x0006f0a062bcdull,
+        0x0006f9e61fd53ull, 0x0007032d7b9d9ull, 0x00070c7674467ull, 0x000715c108042ull,
+        0x00071f0d350f3ull, 0x0007285af9a3eull, 0x000731aa54027ull, 0x00073afb426efull,
+        0x0007444dc3314ull, 0x00074da1d494full, 0x000756f774e93ull, 0x0007604ea280full,
+        0x000769a75bb2aull, 0x000773019ed85ull, 0x00077c5d6a4f8ull, 0x000785babc793ull,
+        0x00078f1993b9cull, 0x00079879ee790ull, 0x0007a1dbcb221ull, 0x0007ab3f28234ull,
+        0x0007b4a403ee4ull, 0x0007be0a5cf7eull, 0x0007c77231b85ull, 0x0007d0db80aa9ull,
+        0x0007da46484d0ull, 0x0007e3b28720eull, 0x0007ed203baaaull, 0x0007f68f64719ull,
+        0x0008000000000ull, 0x000809720ce32ull, 0x000812e589ab1ull, 0x00081c5a74eacull,
+        0x000825d0cd37full, 0x00082f48912b5ull, 0x000838c1bf601ull, 0x0008423c56744ull,
+        0x00084bb85508aull, 0x00085535b9c09ull, 0x00085eb483422ull, 0x00086834b035full,
+        0x000871b63f472ull, 0x00087b392f238ull, 0x000884bd7e7b4ull, 0x00088e432c013ull,
+        0x000897ca366a7ull, 0x0008a1529c6ecull, 0x0008aadc5cc80ull, 0x0008b4677632cull,
+        0x0008bdf3e76dcull, 0x0008c781af3a0ull, 0x0008d110cc5b0ull, 0x0008daa13d966ull,
+        0x0008e43301b42ull, 0x0008edc6177e5ull, 0x0008f75a7dc16ull, 0x000900f0334beull,
+        0x00090a8736ee8ull, 0x0009141f877c1ull, 0x00091db923c98ull, 0x000927540aadfull,
+        0x000930f03b027ull, 0x00093a8db3a24ull, 0x0009442c736a7ull, 0x00094dcc793a4ull,
+        0x0009576dc3f2full, 0x0009611052779ull, 0x00096ab423ad3ull, 0x00097459367afull,
+        0x00097dff89c9bull, 0x000987a71c844ull, 0x0009914fed974ull, 0x00099af9fbf14ull,
+        0x0009a4a546829ull, 0x0009ae51cc3d7ull, 0x0009b7ff8c15cull, 0x0009c1ae85014ull,
+        0x0009cb5eb5f76ull, 0x0009d5101df17ull, 0x0009dec2bbea6ull, 0x0009e8768ededull,
+        0x0009f22b95cd1ull, 0x0009fbe1cfb54ull, 0x000a05993b98full, 0x000a0f51d87b8ull,
+        0x000a190ba561eull, 0x000a22c6a152aull, 0x000a2c82cb55eull, 0x000a364022755ull,
+        0x000a3ffea5bc5ull, 0x000a49be5437aull, 0x000a537f2cf5bull, 0x000a5d412f065ull,
+        0x000a6704597b0ull, 0x000a70c8ab669ull, 0x000a7a8e23dd6ull, 0x000a8454c1f54ull,
+        0x000a8e1c84c59ull, 0x000a97e56b66eull, 0x000aa1af74f37ull, 0x000aab7aa086cull,
+        0x000ab546ed3dcull, 0x000abf145a36dull, 0x000ac8e2e691aull, 0x000ad2b2916f3ull,
+        0x000adc8359f20ull, 0x000ae6553f3dcull, 0x000af02840778ull, 0x000af9fc5cc5bull,
+        0x000b03d1934feull, 0x000b0da7e33f2ull, 0x000b177f4bbdaull, 0x000b2157cbf6full,
+        0x000b2b316317cull, 0x000b350c104e2ull, 0x000b3ee7d2c94ull, 0x000b48c4a9b99ull,
+        0x000b52a29450dull, 0x000b5c8191c1cull, 0x000b6661a1409ull, 0x000b7042c2025ull,
+        0x000b7a24f33d9ull, 0x000b84083429cull, 0x000b8dec83ffbull, 0x000b97d1e1f92ull,
+        0x000ba1b84d511ull, 0x000bab9fc543bull, 0x000bb588490e1ull, 0x000bbf71d7ee9ull,
+        0x000bc95c71249ull, 0x000bd34813f0aull, 0x000bdd34bf943ull, 0x000be7227351eull,
+        0x000bf1112e6d7ull, 0x000bfb00f02b9ull, 0x000c04f1b7d20ull, 0x000c0ee384a78ull,
+        0x000c18d655f3eull, 0x000c22ca2afffull, 0x000c2cbf03159ull, 0x000c36b4dd7f8ull,
+        0x000c40abb989aull, 0x000c4aa39680aull, 0x000c549c73b26ull, 0x000c5e96506d7ull,
+        0x000c68912c01aull, 0x000c728d05bf7ull, 0x000c7c89dcf89ull, 0x000c8687b0ff6ull,
+        0x000c908681276ull, 0x000c9a864cc4eull, 0x000ca487132d2ull, 0x000cae88d3b64ull,
+        0x000cb88b8db75ull, 0x000cc28f40884ull, 0x000ccc93eb81full, 0x000cd6998dfe0ull,
+        0x000ce0a027570ull, 0x000ceaa7b6e86ull, 0x000cf4b03c0e6ull, 0x000cfeb9b6264ull,
+        0x000d08c4248ddull, 0x000d12cf86a3full, 0x000d1cdbdbc84ull, 0x000d26e9235b4ull,
+        0x000d30f75cbe3ull, 0x000d3b0687531ull, 0x000d4516a27ceull, 0x000d4f27ad9f3ull,
+        0x000d5939a81eaull, 0x000d634c91605ull, 0x000d6d6068ca6ull, 0x000d77752dc39ull,
+        0x000d818adfb38ull, 0x000d8ba17e029ull, 0x000d95b90819cull, 0x000d9fd17d62full,
+        0x000da9eadd48dull, 0x000db4052736aull, 0x000dbe205a987ull, 0x000dc83c76db2ull,
+        0x000dd2597b6c2ull, 0x000ddc7767b9bull, 0x000de6963b32dull, 0x000df0b5f5472ull,
+        0x000dfad695670ull, 0x000e04f81b038ull, 0x000e0f1a858e6ull, 0x000e193dd47a1ull,
+        0x000e23620739aull, 0x000e2d871d40full, 0x000e37ad16048ull, 0x000e41d3f0f95ull,
+        0x000e4bfbad955ull, 0x000e56244b4eeull, 0x000e604dc99d3ull, 0x000e6a7827f7full,
+        0x000e74a365d79ull, 0x000e7ecf82b51ull, 0x000e88fc7e0a3ull, 0x000e932a57514ull,
+        0x000e9d590e052ull, 0x000ea788a1a17ull, 0x000eb1b911a25ull, 0x000ebbea5d849ull,
+        0x000ec61c84c59ull, 0x000ed04f86e35ull, 0x000eda83635c7ull, 0x000ee4b819b03ull,
+        0x000eeeeda95e4ull, 0x000ef92411e71ull, 0x000f035b52cb9ull, 0x000f0d936b8d6ull,
+        0x000f17cc5bae8ull, 0x000f220622b1bull, 0x000f2c40c01a4ull, 0x000f367c336beull,
+        0x000f40b87c2b2ull, 0x000f4af599dcdull, 0x000f55338c067ull, 0x000f5f72522e2ull,
+        0x000f69b1ebda6ull, 0x000f73f258926ull, 0x000f7e3397dddull, 0x000f8875a944dull,
+        0x000f92b88c503ull, 0x000f9cfc40893ull, 0x000fa740c579aull, 0x000fb1861aabcull,
+        0x000fbbcc3faa6ull, 0x000fc6133400full, 0x000fd05af73b3ull, 0x000fdaa388e59ull,
+        0x000fe4ece88ceull, 0x000fef3715be8ull, 0x000ff98210084ull, 0x001003cdd6f8aull,
+        0x00100e1a6a1e5ull, 0x00101867c908cull, 0x001022b5f347bull, 0x00102d04e86b7ull,
+        0x00103754a804dull, 0x001041a531a51ull, 0x00104bf684ddeull, 0x00105648a1418ull,
+        0x0010609b86628ull, 0x00106aef33d41ull, 0x00107543a929dull, 0x00107f98e5f7cull,
+        0x001089eee9d25ull, 0x00109445b44e9ull, 0x00109e9d4501dull, 0x0010a8f59b81full,
+        0x0010b34eb7654ull, 0x0010bda898426ull, 0x0010c8033db0aull, 0x0010d25ea7478ull,
+        0x0010dcbad49f0ull, 0x0010e717c54fbull, 0x0010f17578f26ull, 0x0010fbd3ef207ull,
+        0x0011063327739ull, 0x001110932185full, 0x00111af3dcf21ull, 0x0011255559530ull,
+        0x00112fb796441ull, 0x00113a1a93613ull, 0x0011447e50467ull, 0x00114ee2cc909ull,
+        0x0011594807dc7ull, 0x001163ae01c7aull, 0x00116e14b9efdull, 0x0011787c2ff34ull,
+        0x001182e463709ull, 0x00118d4d5406cull, 0x001197b701552ull, 0x0011a2216afb8ull,
+        0x0011ac8c909a0ull, 0x0011b6f871d12ull, 0x0011c1650e41dull, 0x0011cbd2658d5ull,
+        0x0011d64077555ull, 0x0011e0af433bdull, 0x0011eb1ec8e33ull, 0x0011f58f07ee3ull,
+        0x0012000000000ull, 0x00120a71b0bc1ull, 0x001214e419c64ull, 0x00121f573ac2cull,
+        0x001229cb13561ull, 0x0012343fa3254ull, 0x00123eb4e9d58ull, 0x0012492ae70c6ull,
+        0x001253a19a6ffull, 0x00125e1903a67ull, 0x0012689122569ull, 0x00127309f6275ull,
+        0x00127d837ec01ull, 0x001287fdbbc87ull, 0x00129278ace87ull, 0x00129cf451c88ull,
+        0x0012a770aa114ull, 0x0012b1edb56bbull, 0x0012bc6b73812ull, 0x0012c6e9e3fb6ull,
+        0x0012d16906844ull, 0x0012dbe8dac63ull, 0x0012e669606bdull, 0x0012f0ea97201ull,
+        0x0012fb6c7e8e4ull, 0x001305ef1661eull, 0x001310725e46full, 0x00131af655e9aull,
+        0x0013257afcf68ull, 0x00133000531a6ull, 0x00133a8658026ull, 0x0013450d0b5bfull,
+        0x00134f946cd4full, 0x00135a1c7c1b5ull, 0x001364a538dd7ull, 0x00136f2ea2ca1ull,
+        0x001379b8b9901ull, 0x001384437cdebull, 0x00138eceec659ull, 0x0013995b07d47ull,
+        0x0013a3e7cedb7ull, 0x0013ae75412b1ull, 0x0013b9035e740ull, 0x0013c39226674ull,
+        0x0013ce2198b60ull, 0x0013d8b1b511full, 0x0013e3427b2cdull, 0x0013edd3eab8cull,
+        0x0013f86603684ull, 0x001402f8c4edeull, 0x00140d8c2efcbull, 0x001418204147dull,
+        0x001422b4fb82dull, 0x00142d4a5d617ull, 0x001437e06697cull, 0x0014427716da1ull,
+        0x00144d0e6ddcfull, 0x001457a66b554ull, 0x0014623f0ef81ull, 0x00146cd8587adull,
+        0x0014777247930ull, 0x0014820cdbf6bull, 0x00148ca8155beull, 0x00149743f3791ull,
+        0x0014a1e07604full, 0x0014ac7d9cb65ull, 0x0014b71b67447ull, 0x0014c1b9d566cull,
+        0x0014cc58e6d4eull, 0x0014d6f89b46cull, 0x0014e198f2748ull, 0x0014ec39ec16bull,
+        0x0014f6db87e5dull, 0x0015017dc59afull, 0x00150c20a4ef1ull, 0x001516c4259bbull,
+        0x00152168475a7ull, 0x00152c0d09e52ull, 0x001536b26cf5full, 0x0015415870472ull,
+        0x00154bff13936ull, 0x001556a656958ull, 0x0015614e39087ull, 0x00156bf6baa7aull,
+        0x0015769fdb2e8ull, 0x001581499a58cull, 0x00158bf3f7e28ull, 0x0015969ef387dull,
+        0x0015a14a8d053ull, 0x0015abf6c4174ull, 0x0015b6a3987aeull, 0x0015c15109ed3ull,
+        0x0015cbff182b8ull, 0x0015d6adc2f35ull, 0x0015e15d0a027ull, 0x0015ec0ced16eull,
+        0x0015f6bd6beedull, 0x0016016e8648aull, 0x00160c203be2full, 0x001616d28c7caull,
+        0x0016218577d4cull, 0x00162c38fdaaaull, 0x001636ed1dbdaull, 0x001641a1d7cd8ull,
+        0x00164c572b9a3ull, 0x0016570d18e3cull, 0x001661c39f6a8ull, 0x00166c7abeef0ull,
+        0x001677327731eull, 0x001681eac7f43ull, 0x00168ca3b0f71ull, 0x0016975d31fbbull,
+        0x0016a2174ac3dull, 0x0016acd1fb110ull, 0x0016b78d42a54ull, 0x0016c2492142cull,
+        0x0016cd0596abcull, 0x0016d7c2a2a2dull, 0x0016e28044eaaull, 0x0016ed3e7d463ull,
+        0x0016f7fd4b78aull, 0x001702bcaf452ull, 0x00170d7ca86f4ull, 0x0017183d36babull,
+        0x001722fe59eb6ull, 0x00172dc011c54ull, 0x001738825e0cbull, 0x001743453e861ull,
+        0x00174e08b2f60ull, 0x001758ccbb216ull, 0x0017639156cd2ull, 0x00176e5685be8ull,
+        0x0017791c47bacull, 0x001783e29c879ull, 0x00178ea983ea9ull, 0x00179970fda9bull,
+        0x0017a439098b1ull, 0x0017af01a754full, 0x0017b9cad6cdcull, 0x0017c49497bc2ull,
+        0x0017cf5ee9e6eull, 0x0017da29cd14full, 0x0017e4f5410d8ull, 0x0017efc14597eull,
+        0x0017fa8dda7b9ull, 0x0018055aff803ull, 0x00181028b46daull, 0x00181af6f90bfull,
+        0x001825c5cd234ull, 0x00183095307beull, 0x00183b6522de7ull, 0x00184635a4138ull,
+        0x00185106b3e40ull, 0x00185bd85218full, 0x001866aa7e7b8ull, 0x0018717d38d51ull,
+        0x00187c5080ef1ull, 0x0018872456933ull, 0x001891f8b98b5ull, 0x00189ccda9a18ull,
+        0x0018a7a3269fcull, 0x0018b27930509ull, 0x0018bd4fc67e4ull, 0x0018c826e8f39ull,
+        0x0018d2fe977b5ull, 0x0018ddd6d1e06ull, 0x0018e8af97edeull, 0x0018f388e96f2ull,
+        0x0018fe62c62f9ull, 0x0019093d2dfabull, 0x00191418209c4ull, 0x00191ef39de03ull,
+        0x001929cfa5928ull, 0x001934ac377f6ull, 0x00193f8953733ull, 0x00194a66f93a6ull,
+        0x0019554528a1aull, 0x00196023e175bull, 0x00196b0323839ull, 0x001975e2ee984ull,
+        0x001980c342811ull, 0x00198ba41f0b6ull, 0x001996858404bull, 0x0019a167713abull,
+        0x0019ac49e67b2ull, 0x0019b72ce3941ull, 0x0019c21068539ull, 0x0019ccf47487eull,
+        0x0019d7d907ff6ull, 0x0019e2be2288aull, 0x0019eda3c3f24ull, 0x0019f889ec0b2ull,
+        0x001a03709aa23ull, 0x001a0e57cf868ull, 0x001a193f8a875ull, 0x001a2427cb741ull,
+        0x001a2f10921c2ull, 0x001a39f9de4f3ull, 0x001a44e3afdd2ull, 0x001a4fce0695cull,
+        0x001a5ab8e2493ull, 0x001a65a442c79ull, 0x001a709027e13ull, 0x001a7b7c9166aull,
+        0x001a86697f286ull, 0x001a9156f0f72ull, 0x001a9c44e6a3dull, 0x001aa7335fff6ull,
+        0x001ab2225cdafull, 0x001abd11dd07cull, 0x001ac801e0572ull, 0x001ad2f2669abull,
+        0x001adde36fa3full, 0x001ae8d4fb44cull, 0x001af3c7094efull, 0x001afeb999949ull,
+        0x001b09acabe7cull, 0x001b14a0401abull, 0x001b1f9455ffeull, 0x001b2a88ed69dull,
+        0x001b357e062b2ull, 0x001b4073a0169ull, 0x001b4b69baff1ull, 0x001b566056b79ull,
+        0x001b615773134ull, 0x001b6c4f0fe56ull, 0x001b77472d015ull, 0x001b823fca3a8ull,
+        0x001b8d38e764bull, 0x001b983284538ull, 0x001ba32ca0daeull, 0x001bae273ccecull,
+        0x001bb92258033ull, 0x001bc41df24c8ull, 0x001bcf1a0b7eeull, 0x001bda16a36efull,
+        0x001be513b9f11ull, 0x001bf0114eda2ull, 0x001bfb0f61fecull, 0x001c060df333full,
+        0x001c110d024ecull, 0x001c1c0c8f244ull, 0x001c270c9989cull, 0x001c320d21549ull,
+        0x001c3d0e265a3ull, 0x001c480fa8705ull, 0x001c5311a76c8ull, 0x001c5e142324aull,
+        0x001c69171b6eaull, 0x001c741a90209ull, 0x001c7f1e81109ull, 0x001c8a22ee14eull,
+        0x001c9527d703eull, 0x001ca02d3bb40ull, 0x001cab331bfbfull, 0x001cb63977b25ull,
+        0x001cc1404eadfull, 0x001ccc47a0c5cull, 0x001cd74f6dd0bull, 0x001ce257b5a60ull,
+        0x001ced60781cdull, 0x001cf869b50c7ull, 0x001d03736c4c7ull, 0x001d0e7d9db44ull,
+        0x001d1988491baull, 0x001d24936e5a3ull, 0x001d2f9f0d47eull, 0x001d3aab25bcbull,
+        0x001d45b7b7909ull, 0x001d50c4c29bcull, 0x001d5bd246b68ull, 0x001d66e043b94ull,
+        0x001d71eeb97c5ull, 0x001d7cfda7d86ull, 0x001d880d0ea62ull, 0x001d931cedbe4ull,
+        0x001d9e2d44f9bull, 0x001da93e14316ull, 0x001db44f5b3e7ull, 0x001dbf6119f9full,
+        0x001dca73503d4ull, 0x001dd585fde1aull, 0x001de09922c0aull, 0x001debacbeb3dull,
+        0x001df6c0d194cull, 0x001e01d55b3d4ull, 0x001e0cea5b872ull, 0x001e17ffd24c6ull,
+        0x001e2315bf670ull, 0x001e2e2c22b13ull, 0x001e3942fc051ull, 0x001e445a4b3d0ull,
+        0x001e4f7210337ull, 0x001e5a8a4ac2eull, 0x001e65a2fac5full, 0x001e70bc20173ull,
+        0x001e7bd5ba91aull, 0x001e86efca0ffull, 0x001e920a4e6d3ull, 0x001e9d2547848ull,
+        0x001ea840b530eull, 0x001eb35c974dbull, 0x001ebe78edb63ull, 0x001ec995b845eull,
+        0x001ed4b2f6d83ull, 0x001edfd0a948dull, 0x001eeaeecf736ull, 0x001ef60d6933bull,
+        0x001f012c7665aull, 0x001f0c4bf6e52ull, 0x001f176bea8e4ull, 0x001f228c513d2ull,
+        0x001f2dad2ace0ull, 0x001f38ce771d3ull, 0x001f43f036070ull, 0x001f4f1267680ull,
+        0x001f5a350b1ccull, 0x001f65582101eull, 0x001f707ba8f41ull, 0x001f7b9fa2d04ull,
+        0x001f86c40e734ull, 0x001f91e8ebba2ull, 0x001f9d0e3a81full, 0x001fa833faa7cull,
+        0x001fb35a2c08full, 0x001fbe80ce82cull, 0x001fc9a7e1f2aull, 0x001fd4cf66361ull,
+        0x001fdff75b2aaull, 0x001feb1fc0adfull, 0x001ff648969dcull, 0x00200171dcd7full,
+        0x00200c9b933a5ull, 0x002017c5b9a2full, 0x002022f04fefdull, 0x00202e1b55ff2ull,
+        0x00203946cbaf1ull, 0x00204472b0ddfull, 0x00204f9f056a2ull, 0x00205acbc9322ull,
+        0x002065f8fc147ull, 0x002071269defaull, 0x00207c54aea28ull, 0x002087832e0bcull,
+        0x002092b21c0a5ull, 0x00209de1787d0ull, 0x0020a9114342eull, 0x0020b4417c3b0ull,
+        0x0020bf722344aull, 0x0020caa3383eeull, 0x0020d5d4bb091ull, 0x0020e106ab82bull,
+        0x0020ec39098b1ull, 0x0020f76bd501eull, 0x0021029f0dc6aull, 0x00210dd2b3b91ull,
+        0x00211906c6b8full, 0x0021243b46a61ull, 0x00212f7033605ull, 0x00213aa58cc7dull,
+        0x002145db52bc8ull, 0x00215111851e8ull, 0x00215c4823ce2ull, 0x0021677f2eab9ull,
+        0x002172b6a5973ull, 0x00217dee88716ull, 0x00218926d71abull, 0x0021945f9173bull,
+        0x00219f98b75d0ull, 0x0021aad248b75ull, 0x0021b60c45637ull, 0x0021c146ad422ull,
+        0x0021cc8180347ull, 0x0021d7bcbe1b5ull, 0x0021e2f866d7dull, 0x0021ee347a4b1ull,
+        0x0021f970f8564ull, 0x002204ade0daaull, 0x00220feb33b99ull, 0x00221b28f0d48ull,
+        0x00222667180ceull, 0x002231a5a9444ull, 0x00223ce4a45c3ull, 0x0022482409367ull,
+        0x00225363d7b4cull, 0x00225ea40fb8eull, 0x002269e4b124cull, 0x00227525bbda5ull,
+        0x002280672fbbaull, 0x00228ba90caabull, 0x002296eb5289bull, 0x0022a22e013adull,
+        0x0022ad7118a07ull, 0x0022b8b4989cdull, 0x0022c3f881127ull, 0x0022cf3cd1e3bull,
+        0x0022da818af34ull, 0x0022e5c6ac239ull, 0x0022f10c35577ull, 0x0022fc5226719ull,
+        0x002307987f54cull, 0x002312df3fe3eull, 0x00231e266801dull, 0x0023296df791aull,
+        0x002334b5ee766ull, 0x00233ffe4c932ull, 0x00234b4711cb1ull, 0x002356903e018ull,
+        0x002361d9d119bull, 0x00236d23caf71ull, 0x0023786e2b7cfull, 0x002383b8f28efull,
+        0x00238f0420109ull, 0x00239a4fb3e57ull, 0x0023a59badf14ull, 0x0023b0e80e17bull,
+        0x0023bc34d43caull, 0x0023c7820043full, 0x0023d2cf92118ull, 0x0023de1d89895ull,
+        0x0023e96be68f6ull, 0x0023f4baa907eull, 0x00240009d0d6full, 0x00240b595de0cull,
+        0x002416a95009bull, 0x002421f9a7360ull, 0x00242d4a634a2ull, 0x0024389b842a9ull,
+        0x002443ed09bbcull, 0x00244f3ef3e26ull, 0x00245a914282full, 0x002465e3f5824ull,
+        0x002471370cc50ull, 0x00247c8a88300ull, 0x002487de67a83ull, 0x00249332ab126ull,
+        0x00249e875253aull, 0x0024a9dc5d50full, 0x0024b531cbef7ull, 0x0024c0879e145ull,
+        0x0024cbddd3a4bull, 0x0024d7346c85dull, 0x0024e28b689d2ull, 0x0024ede2c7cffull,
+        0x0024f93a8a03aull, 0x00250492af1dcull, 0x00250feb3703eull, 0x00251b44219b9ull,
+        0x0025269d6eca7ull, 0x002531f71e764ull, 0x00253d513084dull, 0x002548aba4dbdull,
+        0x002554067b613ull, 0x00255f61b3fafull, 0x00256abd4e8efull, 0x002576194b034ull,
+        0x00258175a93e0ull, 0x00258cd269255ull, 0x0025982f8a9f6ull, 0x0025a38d0d927ull,
+        0x0025aeeaf1e4dull, 0x0025ba49377cdull, 0x0025c5a7de40eull, 0x0025d106e6178ull,
+        0x0025dc664ee72ull, 0x0025e7c618966ull, 0x0025f326430bdull, 0x0025fe86ce2e3ull,
+        0x002609e7b9e42ull, 0x0026154906147ull, 0x002620aab2a60ull, 0x00262c0cbf7f9ull,
+        0x0026376f2c883ull, 0x002642d1f9a6cull, 0x00264e3526c26ull, 0x00265998b3c21ull,
+        0x002664fca08cfull, 0x00267060ed0a3ull, 0x00267bc599212ull, 0x0026872aa4b8eull,
+        0x002692900fb8full, 0x00269df5da089ull, 0x0026a95c038f4ull, 0x0026b4c28c346ull,
+        0x0026c02973dfaull, 0x0026cb90ba787ull, 0x0026d6f85fe69ull, 0x0026e26064119ull,
+        0x0026edc8c6e13ull, 0x0026f931883d4ull, 0x0027049aa80d8ull, 0x002710042639eull,
+        0x00271b6e02aa4ull, 0x002726d83d46aull, 0x00273242d5f70ull, 0x00273dadcca37ull,
+        0x0027491921340ull, 0x00275484d390eull, 0x00275ff0e3a24ull, 0x00276b5d51506ull,
+        0x002776ca1c83aull, 0x0027823745244ull, 0x00278da4cb1aaull, 0x00279912ae4f4ull,
+        0x0027a480eeaaaull, 0x0027afef8c153ull, 0x0027bb5e86779ull, 0x0027c6cdddba6ull,
+        0x0027d23d91c65ull, 0x0027ddada2841ull, 0x0027e91e0fdc6ull, 0x0027f48ed9b81ull,
+        0x0028000000000ull,
+};
@@ -3,27 +3,452 @@
 #include <string.h>
 #include <stdlib.h>
 
-void EBS_SquareExtract(const EBS_Image *image, const EBS_Square *square, uint64_t squareSize, uint8_t *data,
+#define XXH_STATIC_LINKING_ONLY
+#include "xxhash.h"
+
+#include "channel.h"
+#include "thread.h"
+#include "context.h"
+
+#if EBS_X86_64
+#include <immintrin.h>
+#endif
+
+// gathers the least significant bits of a word, byte k giving bit k
+static inline uint8_t EBS_ExtractGather(uint64_t word) {
+    return (uint8_t) (((word & 0x0101010101010101ull) * 0x0102040810204080ull) >> 56);
+}
+
+// gathers the low depth bits of every byte of a word, byte k giving bits k * depth and up, doubling the groups
+static inline uint64_t EBS_ExtractGatherDepth(uint64_t word, uint64_t depth) {
+    word &= 0x0101010101010101ull * ((1ull << depth) - 1);
+    word = (word | word >> (8 - depth)) & 0x0001000100010001ull * ((1ull << 2 * depth) - 1);
+    word = (word | word >> 2 * (8 - depth)) & 0x0000000100000001ull * ((1ull << 4 * depth) - 1);
+    return (word | word >> 4 * (8 - depth)) & ((1ull << 8 * depth) - 1);
+}
+
+static inline uint64_t EBS_ExtractLoad(const uint8_t *row) {
+    uint64_t word = 0;
+#if EBS_LITTLE_ENDIAN
+    memcpy(&word, row, sizeof(word));
+#else
+    for (uint64_t k = 0; k < 8; ++k) {
+        word |= (uint64_t) row[k] << (8 * k);
+    }
+#endif
+    return word;
+}
+
+void EBS_ExtractRowScalar(uint8_t *data, const uint8_t *row, uint64_t size) {
+    for (uint64_t x = 0; x < size; x += 8) {
+        data[x / 8] = EBS_ExtractGather(EBS_ExtractLoad(row + x));
+    }
+}
+
+// every 8 bytes of the row give depth bytes of the message
+static inline void EBS_ExtractRowDepth(uint8_t *data, const uint8_t *row, uint64_t size, uint64_t depth) {
+    for (uint64_t x = 0; x < size; x += 8, data += depth) {
+        const uint64_t bits = EBS_ExtractGatherDepth(EBS_ExtractLoad(row + x), depth);
+        for (uint64_t k = 0; k < depth; ++k) {
+            data[k] = (uint8_t) (bits >> (8 * k));
+        }
+    }
+}
+
+void EBS_ExtractRowScalar2(uint8_t *data, const uint8_t *row, uint64_t size) {
+    EBS_ExtractRowDepth(data, row, size, 2);
+}
+
+void EBS_ExtractRowScalar3(uint8_t *data, const uint8_t *row, uint64_t size) {
+    EBS_ExtractRowDepth(data, row, size, 3);
+}
+
+void EBS_ExtractRowScalar4(uint8_t *data, const uint8_t *row, uint64_t size) {
+    EBS_ExtractRowDepth(data, row, size, 4);
+}
+
+// gathers the low depth bits of 4 16-bit lanes of a word, lane k giving bits k * depth and up
+static inline uint64_t EBS_ExtractGatherLanes(uint64_t word, uint64_t depth) {
+    word &= 0x0001000100010001ull * ((1ull << depth) - 1);
+    word = (word | word >> (16 - depth)) & 0x0000000100000001ull * ((1ull << 2 * depth) - 1);
+    return (word | word >> 2 * (16 - depth)) & ((1ull << 4 * depth) - 1);
+}
+
+// 4 16-bit samples, sample k in lane k whatever the byte order
+static inline uint64_t EBS_ExtractLoadLanes(const uint8_t *row) {
+    uint64_t word = 0;
+#if EBS_LITTLE_ENDIAN
+    memcpy(&word, row, sizeof(word));
+#else
+    for (uint64_t k = 0; k < 4; ++k) {
+        uint16_t sample;
+        memcpy(&sample, row + 2 * k, sizeof(sample));
+        word |= (uint64_t) sample << (16 * k);
+    }
+#endif
+    return word;
+}
+
+void EBS_ExtractRow16(uint8_t *data, const uint8_t *row, uint64_t size, uint64_t depth) {
+    // every 8 samples of the row give depth bytes of the message
+    for (uint64_t x = 0; x < size; x += 8, data += depth) {
+        const uint64_t bits = EBS_ExtractGatherLanes(EBS_ExtractLoadLanes(row + 2 * x), depth) |
+                              EBS_ExtractGatherLanes(EBS_ExtractLoadLanes(row + 2 * x + 8), depth) << 4 * depth;
+        for (uint64_t k = 0; k < depth; ++k) {
+            data[k] = (uint8_t) (bits >> (8 * k));
+        }
+    }
+}
+
+#if EBS_X86_64
+
+void EBS_ExtractRowSSE2(uint8_t *data, const uint8_t *row, uint64_t size) {
+    uint64_t x = 0;
+    for (; x + 16 <= size; x += 16) {
+        // the shift moves every least significant bit to the top of its byte, where movemask picks it up
+        const __m128i v = _mm_loadu_si128((const __m128i *) (row + x));
+        const uint16_t bits = (uint16_t) _mm_movemask_epi8(_mm_slli_epi16(v, 7));
+        memcpy(data + x / 8, &bits, sizeof(bits));
+    }
+    EBS_ExtractRowScalar(data + x / 8, row + x, size - x);
+}
+
+EBS_TARGET("avx2")
+void EBS_ExtractRowAVX2(uint8_t *data, const uint8_t *row, uint64_t size) {
+    uint64_t x = 0;
+    for (; x + 32 <= size; x += 32) {
+        const __m256i v = _mm256_loadu_si256((const __m256i *) (row + x));
+        const uint32_t bits = (uint32_t) _mm256_movemask_epi8(_mm256_slli_epi16(v, 7));
+        memcpy(data + x / 8, &bits, sizeof(bits));
+    }
+    // the SSE2 kernel is legacy encoded, the upper halves have to be cleared before it or every instruction stalls
+    _mm256_zeroupper();
+    EBS_ExtractRowSSE2(data + x / 8, row + x, size - x);
+}
+
+#endif
+
+EBS_ExtractRowKernel EBS_ExtractRowKernelSelect(uint32_t cpuFeatures, uint64_t depth) {
+    if (depth == 2) return EBS_ExtractRowScalar2;
+    if (depth == 3) return EBS_ExtractRowScalar3;
+    if (depth == 4) return EBS_ExtractRowScalar4;
+#if EBS_X86_64
+    // SSE2 is part of x86-64 itself
+    return cpuFeatures & EBS_CpuAVX2 ? EBS_ExtractRowAVX2 : EBS_ExtractRowSSE2;
+#else
+    (void) cpuFeatures;
+    return EBS_ExtractRowScalar;
+#endif
+}
+
+EBS_ExtractRowKernel EBS_ExtractRowKernelGet(uint64_t depth) {
+    static EBS_ExtractRowKernel cache[5] = {NULL};
+    EBS_ExtractRowKernel kernel = EBS_KernelLoad(EBS_ExtractRowKernel, cache[depth]);
+    if (kernel == NULL) {
+        kernel = EBS_ExtractRowKernelSelect(EBS_CpuFeatures(), depth);
+        EBS_KernelStore(cache[depth], kernel);
+    }
+    return kernel;
+}
+
+// adds the low bits of a sample to the pending bits, writing out the message byte they complete
+static inline uint8_t *EBS_ExtractPending(uint8_t *data, uint64_t *pending, uint64_t *pendingBits, uint8_t sample,
+                                          uint64_t depth) {
+    *pending |= (uint64_t) (sample & ((1u << depth) - 1)) << *pendingBits;
+    *pendingBits += depth;
+    if (*pendingBits < 8) return data;
+    *data = (uint8_t) *pending;
+    *pending >>= 8;
+    *pendingBits -= 8;
+    return data + 1;
+}
+
+// the low byte of sample x of a row, all the bits any depth writes to
+static inline uint8_t EBS_ExtractSample(const uint8_t *row, uint64_t x, uint64_t sampleSize) {
+    if (sampleSize == 1) return row[x];
+    uint16_t sample;
+    memcpy(&sample, row + 2 * x, sizeof(sample));
+    return (uint8_t) sample;
+}
+
+void EBS_SquareExtract(const EBS_Image *image, const EBS_Square *square, uint64_t squareSize, uint64_t depth,
+                       uint64_t channelMask, EBS_CipherStream *stream, uint64_t offset, uint8_t *data,
                        uint64_t dataSize) {
-    const uint64_t realWidth = image->width * image->channel;
-    uint64_t index = 0, bit = 0;
-    uint8_t *yStart = image->pixels + square->y * realWidth + square->x * image->channel;
-    for (uint64_t y = 0; y < squareSize; ++y, yStart += realWidth) {
-        uint8_t *xStart = yStart;
-        for (uint64_t x = 0; x < squareSize; ++x) {
-            for (uint64_t c = 0; c < image->channel; ++c, ++xStart) {
-                data[index] |= (*xStart & 1) << bit;
-                if (++bit == 8) {
-                    bit = 0;
-                    ++index;
-                    if (index == dataSize) return;
-                }
-            }
+    const EBS_ExtractRowKernel kernel = EBS_ExtractRowKernelGet(depth);
+    // the channels of 16-bit samples are masked as two channels of bytes each, so that packing keeps them whole
+    const uint64_t sampleSize = EBS_ImageSampleSize(image);
+    const uint64_t channel = image->channel * sampleSize;
+    const uint64_t realWidth = EBS_ImageStride(image);
+    const uint64_t rowSize = squareSize * EBS_ChannelCount(image->channel, channelMask);
+    if (sampleSize != 1) channelMask = EBS_ChannelMaskBytes(image->channel, channelMask, EBS_CHANNEL_SAMPLE_BOTH);
+    channelMask = EBS_ChannelMaskResolve(channel, channelMask);
+    const EBS_ChannelPackKernel pack = EBS_ChannelPackKernelGet(channel, channelMask);
+    uint8_t packed[EBS_CHANNEL_PACKED_ROW];
+
+    // depth message bits per sample of the square, row after row, stopping wherever the message or the square ends
+    uint64_t size = rowSize * squareSize * depth / 8;
+    if (dataSize < size) size = dataSize;
+    const uint64_t samples = (size * 8 + depth - 1) / depth;
+
+    // a row may end inside a message byte, its first bits wait in pending for the next row
+    // with a mask the selected channels of a row are packed first and read as a narrower row
+    // with a key the bytes written are decrypted in place every chunk, while they're still in cache
+    const uint8_t *pixels = image->pixels + EBS_SquareY(*square, image, squareSize) * realWidth +
+                            EBS_SquareX(*square, image, squareSize) * channel;
+    uint8_t *const begin = data;
+    uint64_t pending = 0, pendingBits = 0, decrypted = 0;
+    for (uint64_t sample = 0; sample < samples; sample += rowSize, pixels += realWidth) {
+        if (stream != NULL && (uint64_t) (data - begin) - decrypted >= EBS_CIPHER_CHUNK) {
+            EBS_CipherApply(stream, offset + decrypted, begin + decrypted, begin + decrypted,
+                            (uint64_t) (data - begin) - decrypted);
+            decrypted = (uint64_t) (data - begin);
         }
+
+        const uint64_t rowSamples = samples - sample < rowSize ? samples - sample : rowSize;
+        const uint8_t *row = pixels;
+        if (channelMask != 0) {
+            pack(packed, pixels, squareSize, channel, channelMask);
+            row = packed;
+        }
+        uint64_t x = 0;
+        for (; pendingBits != 0 && x < rowSamples; ++x) {
+            data = EBS_ExtractPending(data, &pending, &pendingBits, EBS_ExtractSample(row, x, sampleSize), depth);
+        }
+
+        const uint64_t whole = (rowSamples - x) / 8 * 8;
+        if (sampleSize == 1) {
+            kernel(data, row + x, whole);
+        } else {
+            EBS_ExtractRow16(data, row + 2 * x, whole, depth);
+        }
+        data += whole / 8 * depth;
+
+        // the samples cover the message bytes exactly, bar the bits of a last sample past the message
+        for (x += whole; x < rowSamples; ++x) {
+            data = EBS_ExtractPending(data, &pending, &pendingBits, EBS_ExtractSample(row, x, sampleSize), depth);
+        }
+    }
+    if (stream != NULL) {
+        EBS_CipherApply(stream, offset + decrypted, begin + decrypted, begin + decrypted, size - decrypted);
     }
 }
 
 EBS_Message EBS_MessageExtract(EBS_ImageList *imageList, uint64_t squareSize, int *errorCode) {
+    const EBS_Options options = {
+            .squareSize = squareSize,
+            .threadCount = 1
+    };
+    return EBS_MessageExtractWithOptions(imageList, &options, errorCode);
+}
+
+typedef struct EBS_ExtractContext {
+    const EBS_ComputedImageList *computedImageList;
+    // the bytes of the message from dataOffset on, all of it in memory or the part a writer is given next
+    uint8_t *data;
+    uint64_t dataOffset;
+    const EBS_SquarePiece *pieces;
+    uint64_t pieceCount;
+    uint64_t piecesPerTask;
+    uint64_t taskBase;
+    uint64_t squareSize;
+    uint64_t depth;
+    uint64_t channelMask;
+    // a stream of keystream per worker, NULL without a key
+    EBS_CipherStream *streams;
+    uint64_t headerSize;
+} EBS_ExtractContext;
+
+static void EBS_ExtractTaskRun(void *context, uint64_t task, uint64_t worker) {
+    const EBS_ExtractContext *extractContext = context;
+    EBS_CipherStream *stream = extractContext->streams == NULL ? NULL : extractContext->streams + worker;
+    task += extractContext->taskBase;
+    const uint64_t begin = task * extractContext->piecesPerTask;
+    const uint64_t end = begin + extractContext->piecesPerTask < extractContext->pieceCount ?
+                         begin + extractContext->piecesPerTask : extractContext->pieceCount;
+    // the header piece was read before the message could be allocated
+    for (uint64_t i = begin == 0 ? 1 : begin; i < end; ++i) {
+        const EBS_SquarePiece *piece = extractContext->pieces + i;
+        uint8_t *data = extractContext->data + (piece->offset - extractContext->dataOffset);
+        EBS_SquareExtract(&extractContext->computedImageList->computedImages[piece->computedImageIndex].image,
+                          piece->square, extractContext->squareSize, extractContext->depth,
+                          extractContext->channelMask, stream, extractContext->headerSize + piece->offset, data,
+                          piece->size);
+    }
+}
+
+// the tasks are run a batch of as many as there are workers at a time, their bytes then hashed in the order of the
+// message while they are still in cache, a message in memory is written where it goes and one for a writer goes
+// through a buffer holding the bytes of the largest batch, given to the writer once hashed
+static bool EBS_ExtractBatches(EBS_ExtractContext *context, uint64_t taskCount, uint64_t workers, uint8_t *data,
+                               EBS_Writer writer, void *writerContext, uint64_t messageSize, uint64_t *checksum,
+                               int *errorCode) {
+    EBS_Context *scratch = context->computedImageList->context;
+    uint8_t *buffer = NULL;
+    if (data == NULL) {
+        uint64_t bufferSize = 1;
+        for (uint64_t task = 0; task < taskCount; task += workers) {
+            uint64_t begin, end;
+            EBS_SquarePiecesBytes(context->pieces, context->pieceCount, context->piecesPerTask, task, task + workers,
+                                  &begin, &end);
+            if (end - begin > bufferSize) bufferSize = end - begin;
+        }
+        buffer = (uint8_t *) EBS_ScratchGet(scratch, EBS_SCRATCH_STREAM, bufferSize);
+        if (buffer == NULL) {
+            *errorCode = EBS_ErrorOOM;
+            return false;
+        }
+    }
+    XXH3_state_t state;
+    XXH3_INITSTATE(&state);
+    XXH3_64bits_reset_withSeed(&state, messageSize);
+
+    for (uint64_t task = 0; task < taskCount; task += workers) {
+        uint64_t begin, end;
+        EBS_SquarePiecesBytes(context->pieces, context->pieceCount, context->piecesPerTask, task, task + workers,
+                              &begin, &end);
+        const uint8_t *bytes = buffer;
+        if (data != NULL) {
+            bytes = data + begin;
+        } else {
+            context->data = buffer;
+            context->dataOffset = begin;
+        }
+        context->taskBase = task;
+        const uint64_t count = taskCount - task < workers ? taskCount - task : workers;
+        EBS_ParallelFor(scratch, workers, count, EBS_ExtractTaskRun, context);
+        if (checksum != NULL) XXH3_64bits_update(&state, bytes, end - begin);
+        if (data == NULL && end != begin && writer(writerContext, buffer, end - begin) != end - begin) {
+            EBS_ScratchRelease(scratch, buffer);
+            *errorCode = EBS_ErrorStream;
+            return false;
+        }
+    }
+
+    if (checksum != NULL) *checksum = XXH3_64bits_digest(&state);
+    EBS_ScratchRelease(scratch, buffer);
+    return true;
+}
+
+static void EBS_ExtractMessageRelease(EBS_Context *context, EBS_Message *message) {
+    EBS_ScratchRelease(context, message->data);
+    message->data = NULL;
+    message->size = 0;
+}
+
+// the message is either allocated whole or, with a writer, given to it a few tasks at a time and never kept
+static EBS_Message EBS_ExtractMessage(const EBS_ComputedImageList *computedImageList, EBS_Writer writer,
+                                      void *writerContext, uint64_t squareSize, uint64_t depth, uint64_t channelMask,
+                                      const EBS_Cipher *cipher, bool checksum, uint64_t threadCount,
+                                      int *errorCode) {
+    EBS_Message message = {
+            .size = 0,
+            .data = NULL
+    };
+
+    // the message size, then the checksum if there's one, bytes past the header square are left at 0
+    uint64_t header[2] = {0, 0};
+    const uint64_t headerSize = EBS_HeaderSize(checksum);
+    {
+        EBS_SquareMerge squareMerge;
+        if (!EBS_SquareMergeInit(&squareMerge, computedImageList)) {
+            *errorCode = EBS_ErrorOOM;
+            return message;
+        }
+        const uint64_t maxComputedImageIndex = EBS_SquareMergeTop(&squareMerge);
+        if (maxComputedImageIndex == computedImageList->size) {
+            EBS_SquareMergeFree(&squareMerge);
+            *errorCode = EBS_ErrorInvalidMessage;
+            return message;
+        }
+        EBS_ComputedImage *maxComputedImage = computedImageList->computedImages + maxComputedImageIndex;
+        EBS_CipherStream cipherStream;
+        EBS_SquareExtract(&maxComputedImage->image, maxComputedImage->squareList.squares, squareSize, depth,
+                          channelMask, EBS_CipherStreamInit(&cipherStream, cipher), 0, (uint8_t *) header,
+                          headerSize);
+        EBS_SquareMergeFree(&squareMerge);
+    }
+    message.size = header[0];
+
+    const uint64_t capacity = EBS_ComputedImageListCalcCapacity(computedImageList, checksum);
+    if (message.size > capacity) {
+        message.size = 0;
+        *errorCode = EBS_ErrorInvalidMessage;
+        return message;
+    }
+
+    // every byte of the message is written whole, so it doesn't have to be cleared first, with a context the
+    // message stays in its arena until the next extraction
+    EBS_Context *scratch = computedImageList->context;
+    if (writer == NULL) message.data = (uint8_t *) EBS_ScratchGet(scratch, EBS_SCRATCH_MESSAGE, message.size);
+    EBS_ExtractContext context = {
+            .computedImageList = computedImageList,
+            .data = message.data,
+            .squareSize = squareSize,
+            .depth = depth,
+            .channelMask = channelMask,
+            .headerSize = headerSize
+    };
+    EBS_SquarePiece *pieces = EBS_SquarePiecesCreate(computedImageList, headerSize, message.size,
+                                                     &context.pieceCount);
+    uint64_t taskCount = 0;
+    if (pieces != NULL) {
+        context.pieces = pieces;
+        context.piecesPerTask = EBS_SquarePiecesPerTask(context.pieceCount, message.size);
+        taskCount = (context.pieceCount + context.piecesPerTask - 1) / context.piecesPerTask;
+    }
+    if ((writer == NULL && message.data == NULL) || pieces == NULL) {
+        EBS_ScratchRelease(scratch, pieces);
+        EBS_ExtractMessageRelease(scratch, &message);
+        *errorCode = EBS_ErrorOOM;
+        return message;
+    }
+
+    // every square knows where its bytes go, so they are gathered by as many threads
+    const uint64_t workers = EBS_ParallelWorkers(threadCount, taskCount);
+    if (cipher != NULL) {
+        context.streams = EBS_CipherStreamsCreate(scratch, cipher, workers);
+        if (context.streams == NULL) {
+            EBS_ScratchRelease(scratch, pieces);
+            EBS_ExtractMessageRelease(scratch, &message);
+            *errorCode = EBS_ErrorOOM;
+            return message;
+        }
+    }
+    uint64_t messageChecksum = 0;
+    if (writer == NULL && !checksum) {
+        EBS_ParallelFor(scratch, workers, taskCount, EBS_ExtractTaskRun, &context);
+    } else if (!EBS_ExtractBatches(&context, taskCount, workers, message.data, writer, writerContext, message.size,
+                                   checksum ? &messageChecksum : NULL, errorCode)) {
+        EBS_ScratchRelease(scratch, context.streams);
+        EBS_ScratchRelease(scratch, pieces);
+        return message;
+    }
+    EBS_ScratchRelease(scratch, context.streams);
+    EBS_ScratchRelease(scratch, pieces);
+
+    if (checksum) {
+        if (messageChecksum != header[1]) {
+            EBS_ExtractMessageRelease(scratch, &message);
+            *errorCode = EBS_ErrorChecksum;
+            return message;
+        }
+    }
+
+    *errorCode = EBS_OK;
+    return message;
+}
+
+EBS_Message EBS_ComputedImageListExtract(const EBS_ComputedImageList *computedImageList, uint64_t squareSize,
+                                         uint64_t depth, uint64_t channelMask, const EBS_Cipher *cipher,
+                                         bool checksum, uint64_t threadCount, int *errorCode) {
+    return EBS_ExtractMessage(computedImageList, NULL, NULL, squareSize, depth, channelMask, cipher, checksum,
+                              threadCount, errorCode);
+}
+
+// the checks and the ordering shared by extracting a message into memory or to a writer
+static EBS_Message EBS_ExtractWithOptions(EBS_ImageList *imageList, EBS_Writer writer, void *writerContext,
+                                          const EBS_Options *options, int *errorCode) {
+    const uint64_t squareSize = options->squareSize;
     EBS_Message message = {
             .size = 0,
             .data = NULL
@@ -34,59 +459,80 @@ EBS_Message EBS_MessageExtract(EBS_ImageList *imageList, uint64_t squareSize, in
         return message;
     }
 
+    const uint64_t depth = EBS_OptionsDepth(options);
+    if (!EBS_DepthCheck(depth)) {
+        *errorCode = EBS_ErrorBadDepth;
+        return message;
+    }
+
     if (!EBS_ImageListCheck(imageList)) {
         *errorCode = EBS_ErrorInvalidImage;
         return message;
     }
 
-    EBS_ComputedImageList computedImageList = EBS_ComputedImageListCreate(imageList, squareSize);
+    if (!EBS_ChannelMaskCheck(imageList, options->channelMask)) {
+        *errorCode = EBS_ErrorBadChannelMask;
+        return message;
+    }
+
+    // the lists stay in row-major order until the header tells how many squares have to be ordered
+    EBS_ComputedImageList computedImageList = EBS_ComputedImageListCreate(imageList, options, 0);
     if (computedImageList.computedImages == NULL) {
         *errorCode = EBS_ErrorOOM;
         return message;
     }
 
-    uint64_t messageIndex = 0;
-    uint64_t squareIndex[computedImageList.size];
-    memset(squareIndex, 0, computedImageList.size * sizeof(uint64_t));
-
+    EBS_Cipher cipher;
+    const EBS_Cipher *messageCipher = EBS_CipherFromOptions(&cipher, options);
     {
-        const uint64_t maxComputedImageIndex = EBS_ComputedImageListFindMaxEntropy(&computedImageList, squareIndex);
+        EBS_CipherStream cipherStream;
+        // the header square is the highest square of the highest list, the one an ordered list would start with
+        uint64_t maxComputedImageIndex = computedImageList.size, maxSquareIndex = 0;
+        uint32_t maxEntropy = 0;
+        for (uint64_t i = 0; i < computedImageList.size; ++i) {
+            const EBS_SquareList *squareList = &computedImageList.computedImages[i].squareList;
+            if (squareList->size == 0) continue;
+            const uint64_t index = EBS_SquareListFindMax(squareList);
+            if (maxComputedImageIndex == computedImageList.size ||
+                EBS_SquareEntropy(squareList->squares[index]) > maxEntropy) {
+                maxEntropy = EBS_SquareEntropy(squareList->squares[index]);
+                maxComputedImageIndex = i;
+                maxSquareIndex = index;
+            }
+        }
+        if (maxComputedImageIndex == computedImageList.size) {
+            EBS_ComputedImageListFree(&computedImageList);
+            *errorCode = EBS_ErrorInvalidMessage;
+            return message;
+        }
         EBS_ComputedImage *maxComputedImage = computedImageList.computedImages + maxComputedImageIndex;
-        EBS_SquareExtract(&maxComputedImage->image, maxComputedImage->squareList.squares, squareSize,
+        EBS_SquareExtract(&maxComputedImage->image, maxComputedImage->squareList.squares + maxSquareIndex, squareSize,
+                          depth, options->channelMask, EBS_CipherStreamInit(&cipherStream, messageCipher), 0,
                           (uint8_t *) &message.size, sizeof(message.size));
-        ++squareIndex[maxComputedImageIndex];
     }
 
-    const uint64_t capacity = EBS_ComputedImageListCalcCapacity(&computedImageList);
-    if (message.size > capacity) {
+    const uint64_t squareLimit = EBS_MessageSquareCount(imageList, squareSize, depth, options->channelMask,
+                                                        message.size);
+    if (!EBS_ComputedImageListOrder(&computedImageList, squareLimit, options->threadCount)) {
         message.size = 0;
         EBS_ComputedImageListFree(&computedImageList);
-        *errorCode = EBS_ErrorInvalidMessage;
+        *errorCode = EBS_ErrorOOM;
         return message;
     }
 
-    message.data = (uint8_t *) calloc(message.size, sizeof(uint8_t));
-
-    while (true) {
-        const uint64_t maxComputedImageIndex = EBS_ComputedImageListFindMaxEntropy(&computedImageList, squareIndex);
-        EBS_ComputedImage *maxComputedImage = computedImageList.computedImages + maxComputedImageIndex;
-
-        const EBS_Square *square = maxComputedImage->squareList.squares + squareIndex[maxComputedImageIndex];
-        uint64_t messagePieceSize = maxComputedImage->squareList.squareCapacity;
-        if (messagePieceSize > message.size - messageIndex) {
-            messagePieceSize = message.size - messageIndex;
-            EBS_SquareExtract(&maxComputedImage->image, square, squareSize, message.data + messageIndex,
-                              messagePieceSize);
-            break;
-        }
-        EBS_SquareExtract(&maxComputedImage->image, square, squareSize, message.data + messageIndex, messagePieceSize);
-
-        ++squareIndex[maxComputedImageIndex];
-        messageIndex += messagePieceSize;
-    }
+    message = EBS_ExtractMessage(&computedImageList, writer, writerContext, squareSize, depth, options->channelMask,
+                                 messageCipher, options->checksum, options->threadCount, errorCode);
 
     EBS_ComputedImageListFree(&computedImageList);
-
-    *errorCode = EBS_OK;
     return message;
 }
+
+EBS_Message EBS_MessageExtractWithOptions(EBS_ImageList *imageList, const EBS_Options *options, int *errorCode) {
+    return EBS_ExtractWithOptions(imageList, NULL, NULL, options, errorCode);
+}
+
+uint64_t EBS_MessageExtractStream(EBS_ImageList *imageList, EBS_Writer writer, void *writerContext,
+                                  const EBS_Options *options, int *errorCode) {
+    const EBS_Message message = EBS_ExtractWithOptions(imageList, writer, writerContext, options, errorCode);
+    return *errorCode == EBS_OK ? message.size : 0;
+}
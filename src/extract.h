@@ -2,6 +2,37 @@
 
 #include "../include/EBS/EBS.h"
 #include "shared.h"
+#include "cipher.h"
+#include "cpu.h"
 
-void EBS_SquareExtract(const EBS_Image *image, const EBS_Square *square, uint64_t squareSize, uint8_t *data,
+typedef void (*EBS_ExtractRowKernel)(uint8_t *data, const uint8_t *row, uint64_t size);
+
+void EBS_ExtractRowScalar(uint8_t *data, const uint8_t *row, uint64_t size);
+
+void EBS_ExtractRowScalar2(uint8_t *data, const uint8_t *row, uint64_t size);
+
+void EBS_ExtractRowScalar3(uint8_t *data, const uint8_t *row, uint64_t size);
+
+void EBS_ExtractRowScalar4(uint8_t *data, const uint8_t *row, uint64_t size);
+
+void EBS_ExtractRow16(uint8_t *data, const uint8_t *row, uint64_t size, uint64_t depth);
+
+#if EBS_X86_64
+
+void EBS_ExtractRowSSE2(uint8_t *data, const uint8_t *row, uint64_t size);
+
+void EBS_ExtractRowAVX2(uint8_t *data, const uint8_t *row, uint64_t size);
+
+#endif
+
+EBS_ExtractRowKernel EBS_ExtractRowKernelSelect(uint32_t cpuFeatures, uint64_t depth);
+
+EBS_ExtractRowKernel EBS_ExtractRowKernelGet(uint64_t depth);
+
+void EBS_SquareExtract(const EBS_Image *image, const EBS_Square *square, uint64_t squareSize, uint64_t depth,
+                       uint64_t channelMask, EBS_CipherStream *stream, uint64_t offset, uint8_t *data,
                        uint64_t dataSize);
+
+EBS_Message EBS_ComputedImageListExtract(const EBS_ComputedImageList *computedImageList, uint64_t squareSize,
+                                         uint64_t depth, uint64_t channelMask, const EBS_Cipher *cipher,
+                                         bool checksum, uint64_t threadCount, int *errorCode);
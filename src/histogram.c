@@ -0,0 +1,342 @@
+#include "histogram.h"
+
+#include <string.h>
+#include <stdbool.h>
+
+#if EBS_X86_64
+#include <immintrin.h>
+#endif
+
+static const uint64_t EBS_QuantizeMask = 0x7f7f7f7f7f7f7f7full;
+
+// byte j of a 3-channel row goes to sub-histogram j % 3 + 3 * (j / 3 % 2), so it repeats every 24 bytes
+static const uint8_t EBS_TripleSub[24] = {
+        0, 1, 2, 3, 4, 5, 0, 1,
+        2, 3, 4, 5, 0, 1, 2, 3,
+        4, 5, 0, 1, 2, 3, 4, 5,
+};
+
+uint64_t EBS_HistogramSubCount(uint64_t channel) {
+    return channel == 3 ? 6 : 4;
+}
+
+void EBS_HistogramClear(EBS_SubHistograms sub, uint64_t channel) {
+    memset(sub, 0, EBS_HistogramSubCount(channel) * sizeof(sub[0]));
+}
+
+static inline void EBS_HistogramAddWord(EBS_SubHistograms sub, uint64_t word) {
+    // with 1, 2 or 4 channels byte j goes to sub-histogram j % 4, so neighbouring samples never share a counter
+    ++sub[0][word & 0xff];
+    ++sub[1][(word >> 8) & 0xff];
+    ++sub[2][(word >> 16) & 0xff];
+    ++sub[3][(word >> 24) & 0xff];
+    ++sub[0][(word >> 32) & 0xff];
+    ++sub[1][(word >> 40) & 0xff];
+    ++sub[2][(word >> 48) & 0xff];
+    ++sub[3][word >> 56];
+}
+
+static inline void EBS_HistogramAddRGBWord(EBS_SubHistograms sub, uint64_t word) {
+    // two RGBA pixels, the alpha bytes are left out
+    ++sub[0][word & 0xff];
+    ++sub[1][(word >> 8) & 0xff];
+    ++sub[2][(word >> 16) & 0xff];
+    ++sub[0][(word >> 32) & 0xff];
+    ++sub[1][(word >> 40) & 0xff];
+    ++sub[2][(word >> 48) & 0xff];
+}
+
+static inline void EBS_HistogramAddTripleWord(EBS_SubHistograms sub, uint64_t word, const uint8_t *index) {
+    for (uint64_t k = 0; k < 8; ++k) {
+        ++sub[index[k]][(word >> (8 * k)) & 0xff];
+    }
+}
+
+static inline void EBS_HistogramAddTriple(EBS_SubHistograms sub, uint64_t word0, uint64_t word1, uint64_t word2) {
+    EBS_HistogramAddTripleWord(sub, word0, EBS_TripleSub);
+    EBS_HistogramAddTripleWord(sub, word1, EBS_TripleSub + 8);
+    EBS_HistogramAddTripleWord(sub, word2, EBS_TripleSub + 16);
+}
+
+static inline uint64_t EBS_HistogramLoadWord(const uint8_t *pixels) {
+    uint64_t word;
+    memcpy(&word, pixels, sizeof(word));
+    return (word >> 1) & EBS_QuantizeMask;
+}
+
+static inline void EBS_HistogramRestQuad(EBS_SubHistograms sub, const uint8_t *row, uint64_t x, uint64_t size) {
+    for (; x + 8 <= size; x += 8) {
+        EBS_HistogramAddWord(sub, EBS_HistogramLoadWord(row + x));
+    }
+    for (; x < size; ++x) {
+        ++sub[x % 4][row[x] >> 1];
+    }
+}
+
+static inline void EBS_HistogramRestTriple(EBS_SubHistograms sub, const uint8_t *row, uint64_t x, uint64_t size) {
+    for (; x + 24 <= size; x += 24) {
+        EBS_HistogramAddTriple(sub, EBS_HistogramLoadWord(row + x), EBS_HistogramLoadWord(row + x + 8),
+                               EBS_HistogramLoadWord(row + x + 16));
+    }
+    for (; x < size; ++x) {
+        ++sub[EBS_TripleSub[x % 24]][row[x] >> 1];
+    }
+}
+
+static inline void EBS_HistogramRestRGB(EBS_SubHistograms sub, const uint8_t *row, uint64_t x, uint64_t size) {
+    for (; x + 8 <= size; x += 8) {
+        EBS_HistogramAddRGBWord(sub, EBS_HistogramLoadWord(row + x));
+    }
+    for (; x < size; ++x) {
+        if (x % 4 != 3) ++sub[x % 4][row[x] >> 1];
+    }
+}
+
+void EBS_HistogramMerge(uint16_t *histogram, EBS_SubHistograms sub, uint64_t channel) {
+    memset(histogram, 0, channel * EBS_HISTOGRAM_BINS * sizeof(uint16_t));
+    const uint64_t subCount = EBS_HistogramSubCount(channel);
+    for (uint64_t j = 0; j < subCount; ++j) {
+        uint16_t *channelHistogram = histogram + (j % channel) * EBS_HISTOGRAM_BINS;
+        for (uint64_t i = 0; i < EBS_HISTOGRAM_BINS; ++i) {
+            channelHistogram[i] = (uint16_t) (channelHistogram[i] + sub[j][i]);
+        }
+    }
+}
+
+void EBS_HistogramFold(uint16_t *histogram, uint64_t depth) {
+    // the bins count value >> 1, adding up runs of 2^(depth - 1) of them counts value >> depth
+    const uint64_t shift = depth - 1;
+    if (shift == 0) return;
+    const uint64_t bins = EBS_HISTOGRAM_BINS >> shift;
+    for (uint64_t i = 0; i < bins; ++i) {
+        uint16_t count = 0;
+        for (uint64_t j = i << shift; j < (i + 1) << shift; ++j) {
+            count = (uint16_t) (count + histogram[j]);
+        }
+        histogram[i] = count;
+    }
+    memset(histogram + bins, 0, (EBS_HISTOGRAM_BINS - bins) * sizeof(uint16_t));
+}
+
+void EBS_HistogramRowQuadScalar(EBS_SubHistograms sub, const uint8_t *row, uint64_t size) {
+    EBS_HistogramRestQuad(sub, row, 0, size);
+}
+
+void EBS_HistogramRowTripleScalar(EBS_SubHistograms sub, const uint8_t *row, uint64_t size) {
+    EBS_HistogramRestTriple(sub, row, 0, size);
+}
+
+void EBS_HistogramRowRGBScalar(EBS_SubHistograms sub, const uint8_t *row, uint64_t size) {
+    EBS_HistogramRestRGB(sub, row, 0, size);
+}
+
+#if EBS_X86_64
+
+EBS_TARGET("sse4.2")
+static inline __m128i EBS_HistogramQuantize128(const uint8_t *pixels) {
+    const __m128i v = _mm_loadu_si128((const __m128i *) pixels);
+    return _mm_and_si128(_mm_srli_epi16(v, 1), _mm_set1_epi8(0x7f));
+}
+
+EBS_TARGET("sse4.2")
+static inline void EBS_HistogramRestQuadSSE42(EBS_SubHistograms sub, const uint8_t *row, uint64_t x, uint64_t size) {
+    for (; x + 16 <= size; x += 16) {
+        const __m128i q = EBS_HistogramQuantize128(row + x);
+        EBS_HistogramAddWord(sub, (uint64_t) _mm_cvtsi128_si64(q));
+        EBS_HistogramAddWord(sub, (uint64_t) _mm_extract_epi64(q, 1));
+    }
+    EBS_HistogramRestQuad(sub, row, x, size);
+}
+
+EBS_TARGET("sse4.2")
+static inline void EBS_HistogramRestTripleSSE42(EBS_SubHistograms sub, const uint8_t *row, uint64_t x,
+                                                uint64_t size) {
+    for (; x + 48 <= size; x += 48) {
+        const __m128i q0 = EBS_HistogramQuantize128(row + x);
+        const __m128i q1 = EBS_HistogramQuantize128(row + x + 16);
+        const __m128i q2 = EBS_HistogramQuantize128(row + x + 32);
+        EBS_HistogramAddTriple(sub, (uint64_t) _mm_cvtsi128_si64(q0), (uint64_t) _mm_extract_epi64(q0, 1),
+                               (uint64_t) _mm_cvtsi128_si64(q1));
+        EBS_HistogramAddTriple(sub, (uint64_t) _mm_extract_epi64(q1, 1), (uint64_t) _mm_cvtsi128_si64(q2),
+                               (uint64_t) _mm_extract_epi64(q2, 1));
+    }
+    EBS_HistogramRestTriple(sub, row, x, size);
+}
+
+EBS_TARGET("sse4.2")
+static inline void EBS_HistogramRestRGBSSE42(EBS_SubHistograms sub, const uint8_t *row, uint64_t x, uint64_t size) {
+    for (; x + 16 <= size; x += 16) {
+        const __m128i q = EBS_HistogramQuantize128(row + x);
+        EBS_HistogramAddRGBWord(sub, (uint64_t) _mm_cvtsi128_si64(q));
+        EBS_HistogramAddRGBWord(sub, (uint64_t) _mm_extract_epi64(q, 1));
+    }
+    EBS_HistogramRestRGB(sub, row, x, size);
+}
+
+EBS_TARGET("sse4.2")
+void EBS_HistogramRowQuadSSE42(EBS_SubHistograms sub, const uint8_t *row, uint64_t size) {
+    EBS_HistogramRestQuadSSE42(sub, row, 0, size);
+}
+
+EBS_TARGET("sse4.2")
+void EBS_HistogramRowTripleSSE42(EBS_SubHistograms sub, const uint8_t *row, uint64_t size) {
+    EBS_HistogramRestTripleSSE42(sub, row, 0, size);
+}
+
+EBS_TARGET("sse4.2")
+void EBS_HistogramRowRGBSSE42(EBS_SubHistograms sub, const uint8_t *row, uint64_t size) {
+    EBS_HistogramRestRGBSSE42(sub, row, 0, size);
+}
+
+EBS_TARGET("avx2")
+static inline __m256i EBS_HistogramQuantize256(const uint8_t *pixels) {
+    const __m256i v = _mm256_loadu_si256((const __m256i *) pixels);
+    return _mm256_and_si256(_mm256_srli_epi16(v, 1), _mm256_set1_epi8(0x7f));
+}
+
+EBS_TARGET("avx2")
+static inline void EBS_HistogramExtract256(uint64_t words[4], __m256i q) {
+    const __m128i low = _mm256_castsi256_si128(q);
+    const __m128i high = _mm256_extracti128_si256(q, 1);
+    words[0] = (uint64_t) _mm_cvtsi128_si64(low);
+    words[1] = (uint64_t) _mm_extract_epi64(low, 1);
+    words[2] = (uint64_t) _mm_cvtsi128_si64(high);
+    words[3] = (uint64_t) _mm_extract_epi64(high, 1);
+}
+
+EBS_TARGET("avx2")
+void EBS_HistogramRowQuadAVX2(EBS_SubHistograms sub, const uint8_t *row, uint64_t size) {
+    uint64_t x = 0;
+    for (; x + 32 <= size; x += 32) {
+        uint64_t words[4];
+        EBS_HistogramExtract256(words, EBS_HistogramQuantize256(row + x));
+        EBS_HistogramAddWord(sub, words[0]);
+        EBS_HistogramAddWord(sub, words[1]);
+        EBS_HistogramAddWord(sub, words[2]);
+        EBS_HistogramAddWord(sub, words[3]);
+    }
+    // the SSE code after this one, in here or in the caller, is slowed down by dirty upper halves
+    _mm256_zeroupper();
+    EBS_HistogramRestQuadSSE42(sub, row, x, size);
+}
+
+EBS_TARGET("avx2")
+void EBS_HistogramRowTripleAVX2(EBS_SubHistograms sub, const uint8_t *row, uint64_t size) {
+    uint64_t x = 0;
+    for (; x + 96 <= size; x += 96) {
+        uint64_t words[12];
+        EBS_HistogramExtract256(words, EBS_HistogramQuantize256(row + x));
+        EBS_HistogramExtract256(words + 4, EBS_HistogramQuantize256(row + x + 32));
+        EBS_HistogramExtract256(words + 8, EBS_HistogramQuantize256(row + x + 64));
+        EBS_HistogramAddTriple(sub, words[0], words[1], words[2]);
+        EBS_HistogramAddTriple(sub, words[3], words[4], words[5]);
+        EBS_HistogramAddTriple(sub, words[6], words[7], words[8]);
+        EBS_HistogramAddTriple(sub, words[9], words[10], words[11]);
+    }
+    _mm256_zeroupper();
+    EBS_HistogramRestTripleSSE42(sub, row, x, size);
+}
+
+EBS_TARGET("avx2")
+void EBS_HistogramRowRGBAVX2(EBS_SubHistograms sub, const uint8_t *row, uint64_t size) {
+    uint64_t x = 0;
+    for (; x + 32 <= size; x += 32) {
+        uint64_t words[4];
+        EBS_HistogramExtract256(words, EBS_HistogramQuantize256(row + x));
+        EBS_HistogramAddRGBWord(sub, words[0]);
+        EBS_HistogramAddRGBWord(sub, words[1]);
+        EBS_HistogramAddRGBWord(sub, words[2]);
+        EBS_HistogramAddRGBWord(sub, words[3]);
+    }
+    _mm256_zeroupper();
+    EBS_HistogramRestRGBSSE42(sub, row, x, size);
+}
+
+#endif
+
+EBS_HistogramRowKernel EBS_HistogramRowKernelSelect(uint32_t cpuFeatures, uint64_t channel) {
+    const bool triple = channel == 3;
+#if EBS_X86_64
+    if (cpuFeatures & EBS_CpuAVX2) return triple ? EBS_HistogramRowTripleAVX2 : EBS_HistogramRowQuadAVX2;
+    if (cpuFeatures & EBS_CpuSSE42) return triple ? EBS_HistogramRowTripleSSE42 : EBS_HistogramRowQuadSSE42;
+#else
+    (void) cpuFeatures;
+#endif
+    return triple ? EBS_HistogramRowTripleScalar : EBS_HistogramRowQuadScalar;
+}
+
+EBS_HistogramRowKernel EBS_HistogramRowRGBKernelSelect(uint32_t cpuFeatures) {
+#if EBS_X86_64
+    if (cpuFeatures & EBS_CpuAVX2) return EBS_HistogramRowRGBAVX2;
+    if (cpuFeatures & EBS_CpuSSE42) return EBS_HistogramRowRGBSSE42;
+#else
+    (void) cpuFeatures;
+#endif
+    return EBS_HistogramRowRGBScalar;
+}
+
+EBS_HistogramRowKernel EBS_HistogramRowRGBKernelGet(void) {
+    static EBS_HistogramRowKernel cache = NULL;
+    EBS_HistogramRowKernel rgb = EBS_KernelLoad(EBS_HistogramRowKernel, cache);
+    if (rgb == NULL) {
+        rgb = EBS_HistogramRowRGBKernelSelect(EBS_CpuFeatures());
+        EBS_KernelStore(cache, rgb);
+    }
+    return rgb;
+}
+
+EBS_HistogramRowKernel EBS_HistogramRowKernelGet(uint64_t channel) {
+    // the kernels for 3 channels and for any other count are cached apart
+    static EBS_HistogramRowKernel quadCache = NULL, tripleCache = NULL;
+    if (channel == 3) {
+        EBS_HistogramRowKernel triple = EBS_KernelLoad(EBS_HistogramRowKernel, tripleCache);
+        if (triple == NULL) {
+            triple = EBS_HistogramRowKernelSelect(EBS_CpuFeatures(), 3);
+            EBS_KernelStore(tripleCache, triple);
+        }
+        return triple;
+    }
+    EBS_HistogramRowKernel quad = EBS_KernelLoad(EBS_HistogramRowKernel, quadCache);
+    if (quad == NULL) {
+        quad = EBS_HistogramRowKernelSelect(EBS_CpuFeatures(), 1);
+        EBS_KernelStore(quadCache, quad);
+    }
+    return quad;
+}
+
+void EBS_HistogramSquare(uint16_t *histogram, const uint8_t *start, uint64_t rowSize, uint64_t squareSize,
+                         uint64_t channel) {
+    const EBS_HistogramRowKernel kernel = EBS_HistogramRowKernelGet(channel);
+    EBS_SubHistograms sub;
+    EBS_HistogramClear(sub, channel);
+
+    const uint64_t size = squareSize * channel;
+    for (uint64_t y = 0; y < squareSize; ++y, start += rowSize) {
+        kernel(sub, start, size);
+    }
+
+    EBS_HistogramMerge(histogram, sub, channel);
+}
+
+void EBS_HistogramChannel(uint16_t *histogram, const uint8_t *start, uint64_t rowSize, uint64_t squareSize,
+                          uint64_t channel) {
+    EBS_SubHistograms sub;
+    memset(sub, 0, 4 * sizeof(sub[0]));
+
+    for (uint64_t y = 0; y < squareSize; ++y, start += rowSize) {
+        const uint8_t *p = start;
+        uint64_t x = 0;
+        for (; x + 4 <= squareSize; x += 4, p += 4 * channel) {
+            ++sub[0][p[0] >> 1];
+            ++sub[1][p[channel] >> 1];
+            ++sub[2][p[2 * channel] >> 1];
+            ++sub[3][p[3 * channel] >> 1];
+        }
+        for (; x < squareSize; ++x, p += channel) {
+            ++sub[0][*p >> 1];
+        }
+    }
+
+    // merging a single channel folds all four copies together
+    EBS_HistogramMerge(histogram, sub, 1);
+}
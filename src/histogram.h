@@ -0,0 +1,59 @@
+#pragma once
+
+#include <inttypes.h>
+
+#include "cpu.h"
+
+#define EBS_HISTOGRAM_BINS 128
+
+#define EBS_HISTOGRAM_MAX_CHANNELS 4
+
+#define EBS_SUB_HISTOGRAMS 6
+
+typedef uint16_t EBS_SubHistograms[EBS_SUB_HISTOGRAMS][EBS_HISTOGRAM_BINS];
+
+typedef void (*EBS_HistogramRowKernel)(EBS_SubHistograms sub, const uint8_t *row, uint64_t size);
+
+uint64_t EBS_HistogramSubCount(uint64_t channel);
+
+void EBS_HistogramClear(EBS_SubHistograms sub, uint64_t channel);
+
+void EBS_HistogramMerge(uint16_t *histogram, EBS_SubHistograms sub, uint64_t channel);
+
+void EBS_HistogramFold(uint16_t *histogram, uint64_t depth);
+
+EBS_HistogramRowKernel EBS_HistogramRowKernelSelect(uint32_t cpuFeatures, uint64_t channel);
+
+EBS_HistogramRowKernel EBS_HistogramRowKernelGet(uint64_t channel);
+
+EBS_HistogramRowKernel EBS_HistogramRowRGBKernelSelect(uint32_t cpuFeatures);
+
+EBS_HistogramRowKernel EBS_HistogramRowRGBKernelGet(void);
+
+void EBS_HistogramSquare(uint16_t *histogram, const uint8_t *start, uint64_t rowSize, uint64_t squareSize,
+                         uint64_t channel);
+
+void EBS_HistogramChannel(uint16_t *histogram, const uint8_t *start, uint64_t rowSize, uint64_t squareSize,
+                          uint64_t channel);
+
+void EBS_HistogramRowQuadScalar(EBS_SubHistograms sub, const uint8_t *row, uint64_t size);
+
+void EBS_HistogramRowTripleScalar(EBS_SubHistograms sub, const uint8_t *row, uint64_t size);
+
+void EBS_HistogramRowRGBScalar(EBS_SubHistograms sub, const uint8_t *row, uint64_t size);
+
+#if EBS_X86_64
+
+void EBS_HistogramRowQuadSSE42(EBS_SubHistograms sub, const uint8_t *row, uint64_t size);
+
+void EBS_HistogramRowTripleSSE42(EBS_SubHistograms sub, const uint8_t *row, uint64_t size);
+
+void EBS_HistogramRowRGBSSE42(EBS_SubHistograms sub, const uint8_t *row, uint64_t size);
+
+void EBS_HistogramRowQuadAVX2(EBS_SubHistograms sub, const uint8_t *row, uint64_t size);
+
+void EBS_HistogramRowTripleAVX2(EBS_SubHistograms sub, const uint8_t *row, uint64_t size);
+
+void EBS_HistogramRowRGBAVX2(EBS_SubHistograms sub, const uint8_t *row, uint64_t size);
+
+#endif
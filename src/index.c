@@ -0,0 +1,220 @@
+#if !defined(_WIN32)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "index.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define XXH_STATIC_LINKING_ONLY
+#include "xxhash.h"
+
+#include "channel.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <process.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// "EBSINDEX" read in native byte order, so files written on a machine of the other endianness are rejected
+static const uint64_t EBS_IndexMagic = 0x5845444e49534245ull;
+
+#define EBS_INDEX_CHUNK 4096
+
+// the path of an index file fits in the directory and this many more bytes, the path it's written aside to in this
+// many more again
+#define EBS_INDEX_PATH_EXTRA 96
+#define EBS_INDEX_TEMPORARY_EXTRA 64
+
+bool EBS_IndexKey(const EBS_Image *image, uint64_t squareSize, uint64_t depth, uint64_t channelMask, uint64_t *key) {
+    XXH3_state_t stateBuffer;
+    XXH3_state_t *state = &stateBuffer;
+    XXH3_INITSTATE(state);
+    XXH3_64bits_reset_withSeed(state, squareSize);
+    const uint64_t shape[] = {image->width, image->height, image->channel, depth,
+                              EBS_ChannelMaskResolve(image->channel, channelMask)};
+    XXH3_64bits_update(state, shape, sizeof(shape));
+
+    // the low bits carry messages, so they are masked out to keep the key of a cover stable
+    const uint64_t mask = 0x0101010101010101ull * (uint8_t) (0xff << depth);
+    uint64_t words[EBS_INDEX_CHUNK / sizeof(uint64_t)] = {0};
+    const uint64_t imageSize = EBS_ImageRowSize(image) * image->height;
+    for (uint64_t offset = 0; offset < imageSize; offset += EBS_INDEX_CHUNK) {
+        const uint64_t chunk = imageSize - offset < EBS_INDEX_CHUNK ? imageSize - offset : EBS_INDEX_CHUNK;
+        EBS_ImageRead(image, offset, (uint8_t *) words, chunk);
+        for (uint64_t i = 0; i < (chunk + 7) / 8; ++i) {
+            words[i] &= mask;
+        }
+        XXH3_64bits_update(state, words, chunk);
+    }
+
+    *key = XXH3_64bits_digest(state);
+    return true;
+}
+
+uint64_t EBS_IndexPathSize(const char *directory) {
+    return strlen(directory) + EBS_INDEX_PATH_EXTRA;
+}
+
+uint64_t EBS_IndexPathsSize(const char *directory) {
+    return 2 * EBS_IndexPathSize(directory) + EBS_INDEX_TEMPORARY_EXTRA;
+}
+
+void EBS_IndexPath(char *path, const char *directory, uint64_t key, uint64_t squareSize, uint64_t depth,
+                   uint64_t channelMask) {
+    snprintf(path, EBS_IndexPathSize(directory), "%s/%016" PRIx64 "-%" PRIu64 "-%" PRIu64 "-%" PRIx64 ".ebsi",
+             directory, key, squareSize, depth, channelMask);
+}
+
+bool EBS_IndexValidate(const void *data, uint64_t dataSize, const EBS_Image *image, uint64_t squareSize,
+                       uint64_t depth, uint64_t channelMask, uint64_t key, EBS_SquareList *squareList) {
+    EBS_IndexHeader header;
+    if (dataSize < sizeof(header)) return false;
+    memcpy(&header, data, sizeof(header));
+
+    if (header.magic != EBS_IndexMagic || header.version != EBS_INDEX_VERSION || header.key != key ||
+        header.squareSize != squareSize || header.depth != depth ||
+        header.channelMask != EBS_ChannelMaskResolve(image->channel, channelMask) || header.width != image->width ||
+        header.height != image->height || header.channel != image->channel || header.size != squareList->size ||
+        dataSize != sizeof(header) + header.size * sizeof(EBS_IndexEntry)) {
+        return false;
+    }
+
+    const uint8_t *entries = (const uint8_t *) data + sizeof(header);
+    if (XXH3_64bits(entries, header.size * sizeof(EBS_IndexEntry)) != header.checksum) return false;
+
+    // the squares have to come in the order a sort would give them, which also rules out repeated squares
+    EBS_IndexEntry previous = {0};
+    for (uint64_t i = 0; i < header.size; ++i) {
+        EBS_IndexEntry entry;
+        memcpy(&entry, entries + i * sizeof(entry), sizeof(entry));
+        if (entry.index >= header.size) return false;
+        if (i > 0 && (entry.entropy > previous.entropy ||
+                      (entry.entropy == previous.entropy && entry.index <= previous.index))) {
+            return false;
+        }
+        squareList->squares[i] = EBS_SquareMake(entry.entropy, entry.index);
+        previous = entry;
+    }
+    return true;
+}
+
+bool EBS_IndexLoad(const char *directory, char *paths, const EBS_Image *image, uint64_t squareSize, uint64_t depth,
+                   uint64_t channelMask, uint64_t key, EBS_SquareList *squareList) {
+    char *path = paths;
+    EBS_IndexPath(path, directory, key, squareSize, depth, EBS_ChannelMaskResolve(image->channel, channelMask));
+    bool loaded = false;
+
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER fileSize;
+    if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0) {
+        HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mapping != NULL) {
+            const void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            if (data != NULL) {
+                loaded = EBS_IndexValidate(data, (uint64_t) fileSize.QuadPart, image, squareSize, depth, channelMask,
+                                           key, squareList);
+                UnmapViewOfFile(data);
+            }
+            CloseHandle(mapping);
+        }
+    }
+    CloseHandle(file);
+#else
+    const int file = open(path, O_RDONLY);
+    if (file < 0) return false;
+    struct stat status;
+    if (fstat(file, &status) == 0 && status.st_size > 0) {
+        void *data = mmap(NULL, (size_t) status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+        if (data != MAP_FAILED) {
+            loaded = EBS_IndexValidate(data, (uint64_t) status.st_size, image, squareSize, depth, channelMask, key,
+                                       squareList);
+            munmap(data, (size_t) status.st_size);
+        }
+    }
+    close(file);
+#endif
+
+    return loaded;
+}
+
+// the entries of a list a chunk at a time, from its first square on
+static uint64_t EBS_IndexEntries(const EBS_SquareList *squareList, uint64_t first, EBS_IndexEntry *entries) {
+    const uint64_t count = squareList->size - first < EBS_INDEX_CHUNK / sizeof(EBS_IndexEntry) ?
+                           squareList->size - first : EBS_INDEX_CHUNK / sizeof(EBS_IndexEntry);
+    for (uint64_t i = 0; i < count; ++i) {
+        entries[i] = (EBS_IndexEntry) {
+                .index = (uint32_t) EBS_SquareIndex(squareList->squares[first + i]),
+                .entropy = EBS_SquareEntropy(squareList->squares[first + i])
+        };
+    }
+    return count;
+}
+
+bool EBS_IndexSave(const char *directory, char *paths, const EBS_Image *image, uint64_t squareSize, uint64_t depth,
+                   uint64_t channelMask, uint64_t key, const EBS_SquareList *squareList) {
+    channelMask = EBS_ChannelMaskResolve(image->channel, channelMask);
+    if (squareList->size > UINT32_MAX) return false;
+
+    // the entries are made a chunk at a time, once for the checksum of the header and once more to be written
+    EBS_IndexEntry entries[EBS_INDEX_CHUNK / sizeof(EBS_IndexEntry)];
+    XXH3_state_t state;
+    XXH3_INITSTATE(&state);
+    XXH3_64bits_reset(&state);
+    for (uint64_t i = 0; i < squareList->size;) {
+        const uint64_t count = EBS_IndexEntries(squareList, i, entries);
+        XXH3_64bits_update(&state, entries, count * sizeof(EBS_IndexEntry));
+        i += count;
+    }
+    const EBS_IndexHeader header = {
+            .magic = EBS_IndexMagic,
+            .version = EBS_INDEX_VERSION,
+            .key = key,
+            .squareSize = squareSize,
+            .depth = depth,
+            .channelMask = channelMask,
+            .width = image->width,
+            .height = image->height,
+            .channel = image->channel,
+            .size = squareList->size,
+            .checksum = XXH3_64bits_digest(&state)
+    };
+
+    // written aside and renamed, so other threads and processes never map a partial file
+    char *path = paths;
+    char *temporaryPath = paths + EBS_IndexPathSize(directory);
+    EBS_IndexPath(path, directory, key, squareSize, depth, channelMask);
+#if defined(_WIN32)
+    const unsigned long process = (unsigned long) _getpid();
+#else
+    const unsigned long process = (unsigned long) getpid();
+#endif
+    snprintf(temporaryPath, EBS_IndexPathSize(directory) + EBS_INDEX_TEMPORARY_EXTRA, "%s.%lx.%p", path, process,
+             (const void *) squareList);
+    FILE *file = fopen(temporaryPath, "wb");
+    bool saved = file != NULL;
+    if (saved) {
+        saved = fwrite(&header, sizeof(header), 1, file) == 1;
+        for (uint64_t i = 0; saved && i < squareList->size;) {
+            const uint64_t count = EBS_IndexEntries(squareList, i, entries);
+            saved = fwrite(entries, sizeof(EBS_IndexEntry), count, file) == count;
+            i += count;
+        }
+        saved = fclose(file) == 0 && saved;
+    }
+#if defined(_WIN32)
+    saved = saved && MoveFileExA(temporaryPath, path, MOVEFILE_REPLACE_EXISTING);
+#else
+    saved = saved && rename(temporaryPath, path) == 0;
+#endif
+    if (!saved && file != NULL) remove(temporaryPath);
+    return saved;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "../include/EBS/EBS.h"
+#include "shared.h"
+
+#include <stdbool.h>
+
+// bumped whenever the entropy key or the order of the squares changes, older files are then recomputed
+#define EBS_INDEX_VERSION 3
+
+typedef struct EBS_IndexHeader {
+    uint64_t magic;
+    uint64_t version;
+    uint64_t key;
+    uint64_t squareSize;
+    uint64_t depth;
+    uint64_t channelMask;
+    uint64_t width;
+    uint64_t height;
+    uint64_t channel;
+    uint64_t size;
+    uint64_t checksum;
+} EBS_IndexHeader;
+
+typedef struct EBS_IndexEntry {
+    uint32_t index;
+    uint32_t entropy;
+} EBS_IndexEntry;
+
+bool EBS_IndexKey(const EBS_Image *image, uint64_t squareSize, uint64_t depth, uint64_t channelMask, uint64_t *key);
+
+uint64_t EBS_IndexPathSize(const char *directory);
+
+// the room EBS_IndexLoad and EBS_IndexSave are given for the path of the index file and the one it's written to
+uint64_t EBS_IndexPathsSize(const char *directory);
+
+void EBS_IndexPath(char *path, const char *directory, uint64_t key, uint64_t squareSize, uint64_t depth,
+                   uint64_t channelMask);
+
+bool EBS_IndexValidate(const void *data, uint64_t dataSize, const EBS_Image *image, uint64_t squareSize,
+                       uint64_t depth, uint64_t channelMask, uint64_t key, EBS_SquareList *squareList);
+
+bool EBS_IndexLoad(const char *directory, char *paths, const EBS_Image *image, uint64_t squareSize, uint64_t depth,
+                   uint64_t channelMask, uint64_t key, EBS_SquareList *squareList);
+
+bool EBS_IndexSave(const char *directory, char *paths, const EBS_Image *image, uint64_t squareSize, uint64_t depth,
+                   uint64_t channelMask, uint64_t key, const EBS_SquareList *squareList);
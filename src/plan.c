@@ -0,0 +1,73 @@
+#include "plan.h"
+
+#include "embed.h"
+#include "extract.h"
+#include "context.h"
+
+EBS_Plan *EBS_PlanCreate(EBS_ImageList *imageList, const EBS_Options *options, int *errorCode) {
+    const uint64_t squareSize = options->squareSize;
+    if (!EBS_SquareSizeCheck(squareSize)) {
+        *errorCode = EBS_ErrorBadSquareSize;
+        return NULL;
+    }
+
+    const uint64_t depth = EBS_OptionsDepth(options);
+    if (!EBS_DepthCheck(depth)) {
+        *errorCode = EBS_ErrorBadDepth;
+        return NULL;
+    }
+
+    if (!EBS_ImageListCheck(imageList)) {
+        *errorCode = EBS_ErrorInvalidImage;
+        return NULL;
+    }
+
+    if (!EBS_ChannelMaskCheck(imageList, options->channelMask)) {
+        *errorCode = EBS_ErrorBadChannelMask;
+        return NULL;
+    }
+
+    EBS_Plan *plan = (EBS_Plan *) EBS_Allocate(options->context, sizeof(EBS_Plan));
+    if (plan == NULL) {
+        *errorCode = EBS_ErrorOOM;
+        return NULL;
+    }
+
+    // any message may follow, so every square is ordered up front
+    plan->squareSize = squareSize;
+    plan->depth = depth;
+    plan->channelMask = options->channelMask;
+    plan->threadCount = options->threadCount;
+    plan->messageCipher = EBS_CipherFromOptions(&plan->cipher, options);
+    plan->checksum = options->checksum;
+    plan->computedImageList = EBS_ComputedImageListCreateOwned(imageList, options, EBS_SQUARE_LIST_ORDER_ALL);
+    if (plan->computedImageList.computedImages == NULL) {
+        EBS_Deallocate(options->context, plan);
+        *errorCode = EBS_ErrorOOM;
+        return NULL;
+    }
+
+    *errorCode = EBS_OK;
+    return plan;
+}
+
+void EBS_PlanEmbed(const EBS_Plan *plan, const EBS_Message *message, int *errorCode) {
+    EBS_ComputedImageListEmbed(&plan->computedImageList, message, plan->squareSize, plan->depth, plan->channelMask,
+                               plan->messageCipher, plan->checksum, plan->threadCount, errorCode);
+}
+
+EBS_Message EBS_PlanExtract(const EBS_Plan *plan, int *errorCode) {
+    return EBS_ComputedImageListExtract(&plan->computedImageList, plan->squareSize, plan->depth, plan->channelMask,
+                                        plan->messageCipher, plan->checksum, plan->threadCount, errorCode);
+}
+
+uint64_t EBS_PlanCapacity(const EBS_Plan *plan) {
+    return EBS_ComputedImageListCalcCapacity(&plan->computedImageList, plan->checksum);
+}
+
+void EBS_PlanFree(EBS_Plan *plan) {
+    if (plan == NULL) return;
+    EBS_Context *context = plan->computedImageList.context;
+    EBS_ComputedImageListFree(&plan->computedImageList);
+    EBS_Deallocate(context, plan);
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "../include/EBS/EBS.h"
+#include "shared.h"
+#include "cipher.h"
+
+struct EBS_Plan {
+    uint64_t squareSize;
+    uint64_t depth;
+    uint64_t channelMask;
+    uint64_t threadCount;
+    EBS_Cipher cipher;
+    // the cipher above, or NULL without a key
+    const EBS_Cipher *messageCipher;
+    bool checksum;
+    EBS_ComputedImageList computedImageList;
+};
@@ -1,68 +1,360 @@
 #include "shared.h"
 
 #include <string.h>
-#include <math.h>
 #include <stdlib.h>
 
 #include "xxhash.h"
 
-void EBS_SquareCalcEntropy(const EBS_Image *image, EBS_Square *square, uint64_t squareSize) {
-    double entropy = 0.;
-    const uint64_t channel = image->channel, width = image->width;
-    const uint64_t real_width = width * channel;
-
-    uint16_t map[128];
-    const uint8_t *start = image->pixels + (square->y * width + square->x) * channel;
-    for (uint64_t c = 0; c < channel; ++c, ++start) {
-        memset(map, 0, sizeof(map));
-        const uint8_t *y_start = start;
-        for (uint64_t y = 0; y < squareSize; ++y, y_start += real_width) {
-            const uint8_t *x_start = y_start;
-            for (uint64_t x = 0; x < squareSize; ++x, x_start += channel) {
-                ++(map[(*x_start) >> 1]);
+#include "histogram.h"
+#include "channel.h"
+#include "entropy.h"
+#include "thread.h"
+#include "index.h"
+#include "context.h"
+
+// the entropy of 16-bit samples is counted on their high bytes, which no depth writes to, read as channels of their
+// own, the histograms then hold the 7 high bits of every sample
+static const EBS_Image *EBS_EntropyImage(const EBS_Image *image, EBS_Image *bytes, uint64_t *depth,
+                                         uint64_t *channelMask) {
+    if (EBS_ImageSampleSize(image) == 1) return image;
+    *bytes = EBS_ImageBytes(image);
+    *depth = 1;
+    *channelMask = EBS_ChannelMaskBytes(image->channel, *channelMask, EBS_CHANNEL_SAMPLE_HIGH);
+    return bytes;
+}
+
+void EBS_SquareCalcEntropy(const EBS_Image *image, EBS_Square *square, uint64_t squareSize, uint64_t depth,
+                           uint64_t channelMask, const uint64_t *entropyTable) {
+    EBS_Image bytes;
+    image = EBS_EntropyImage(image, &bytes, &depth, &channelMask);
+    uint64_t sum = 0;
+    const uint64_t channel = image->channel;
+    const uint64_t real_width = EBS_ImageStride(image);
+    const uint64_t selected = EBS_ChannelCount(channel, channelMask);
+    channelMask = EBS_ChannelMaskResolve(channel, channelMask);
+
+    const uint8_t *start = image->pixels + EBS_SquareY(*square, image, squareSize) * real_width +
+                           EBS_SquareX(*square, image, squareSize) * channel;
+    if (selected <= EBS_HISTOGRAM_MAX_CHANNELS) {
+        // one sweep fills the histograms of every channel
+        uint16_t maps[EBS_HISTOGRAM_MAX_CHANNELS][EBS_HISTOGRAM_BINS];
+        if (channelMask == 0) {
+            EBS_HistogramSquare(maps[0], start, real_width, squareSize, channel);
+        } else if (EBS_ChannelRGB(channel, channelMask)) {
+            // the RGB of RGBA is counted in place, skipping the alpha bytes
+            const EBS_HistogramRowKernel kernel = EBS_HistogramRowRGBKernelGet();
+            EBS_SubHistograms sub;
+            EBS_HistogramClear(sub, channel);
+            for (uint64_t y = 0; y < squareSize; ++y, start += real_width) {
+                kernel(sub, start, squareSize * channel);
             }
+            EBS_HistogramMerge(maps[0], sub, channel);
+        } else {
+            // the selected channels of each row are packed together and counted as a narrower image
+            uint8_t packed[256 * EBS_HISTOGRAM_MAX_CHANNELS];
+            const EBS_ChannelPackKernel pack = EBS_ChannelPackKernelGet(channel, channelMask);
+            const EBS_HistogramRowKernel kernel = EBS_HistogramRowKernelGet(selected);
+            EBS_SubHistograms sub;
+            EBS_HistogramClear(sub, selected);
+            for (uint64_t y = 0; y < squareSize; ++y, start += real_width) {
+                pack(packed, start, squareSize, channel, channelMask);
+                kernel(sub, packed, squareSize * selected);
+            }
+            EBS_HistogramMerge(maps[0], sub, selected);
+        }
+        for (uint64_t c = 0; c < selected; ++c) {
+            EBS_HistogramFold(maps[c], depth);
+            sum += EBS_EntropySum(entropyTable, maps[c]);
         }
-        for (uint64_t i = 0; i < 128; ++i) {
-            if (map[i] == 0) continue;
-            const double p = (double) map[i] / (double) (squareSize * squareSize);
-            entropy += -p * log2(p);
+    } else {
+        uint16_t map[EBS_HISTOGRAM_BINS];
+        for (uint64_t c = 0; c < channel; ++c, ++start) {
+            if (channelMask != 0 && (c >= 64 || !(channelMask >> c & 1))) continue;
+            EBS_HistogramChannel(map, start, real_width, squareSize, channel);
+            EBS_HistogramFold(map, depth);
+            sum += EBS_EntropySum(entropyTable, map);
         }
     }
-    square->entropy = entropy / (double) channel;
+    *square = EBS_SquareMake(EBS_EntropyKey(entropyTable, squareSize * squareSize, selected, sum),
+                             EBS_SquareIndex(*square));
 }
 
 int EBS_SquareCompare(const void *square1, const void *square2) {
-    const double entropy1 = ((EBS_Square *) square1)->entropy;
-    const double entropy2 = ((EBS_Square *) square2)->entropy;
-    if (entropy1 > entropy2) {
-        return -1;
-    } else if (entropy1 < entropy2) {
-        return 1;
-    } else {
-        return 0;
+    // the highest entropy first, equal entropies in the row-major order the squares were computed in
+    const uint64_t key1 = ((const EBS_Square *) square1)->key;
+    const uint64_t key2 = ((const EBS_Square *) square2)->key;
+    if (key1 != key2) {
+        return key1 > key2 ? 1 : -1;
+    }
+    return 0;
+}
+
+static void EBS_SquareListCalcBand(const EBS_Image *image, EBS_Square *squares, uint64_t y, uint64_t squareSize,
+                                   uint64_t depth, uint64_t channelMask, uint16_t (*band)[EBS_HISTOGRAM_BINS],
+                                   const uint64_t *entropyTable) {
+    const uint64_t channel = image->channel;
+    const uint64_t realWidth = EBS_ImageStride(image);
+    const uint64_t squareWidth = image->width / squareSize;
+    const uint64_t selected = EBS_ChannelCount(channel, channelMask);
+    const bool rgb = EBS_ChannelRGB(channel, channelMask);
+    channelMask = EBS_ChannelMaskResolve(channel, channelMask);
+    // other masks pack the selected channels of a row into the scratch past the histograms, the kernel then reads
+    // rows of that many channels
+    const bool packs = channelMask != 0 && !rgb;
+    const uint64_t layout = packs ? selected : channel;
+    const uint64_t segmentSize = squareSize * layout;
+    const uint64_t subCount = EBS_HistogramSubCount(layout);
+    const EBS_HistogramRowKernel kernel = rgb ? EBS_HistogramRowRGBKernelGet() : EBS_HistogramRowKernelGet(layout);
+    const EBS_ChannelPackKernel pack = EBS_ChannelPackKernelGet(channel, channelMask);
+    uint8_t *packed = (uint8_t *) (band + squareWidth * subCount);
+    const bool prefetch = y + 2 * squareSize <= image->height;
+
+    memset(band, 0, squareWidth * subCount * sizeof(*band));
+
+    // walk every row of the band once, left to right, feeding each square its segment of the row
+    const uint8_t *row = image->pixels + y * realWidth;
+    for (uint64_t r = 0; r < squareSize; ++r, row += realWidth) {
+        const uint8_t *next = row + squareSize * realWidth;
+        const uint8_t *segments = row;
+        if (packs) {
+            pack(packed, row, squareWidth * squareSize, channel, channelMask);
+            segments = packed;
+        }
+        uint64_t prefetched = 0;
+        for (uint64_t k = 0; k < squareWidth; ++k) {
+            if (prefetch) {
+                for (; prefetched < (k + 1) * squareSize * channel; prefetched += EBS_CACHE_LINE) {
+                    EBS_Prefetch(next + prefetched);
+                }
+            }
+            kernel(band + k * subCount, segments + k * segmentSize, segmentSize);
+        }
+    }
+
+    for (uint64_t k = 0; k < squareWidth; ++k) {
+        uint16_t maps[EBS_HISTOGRAM_MAX_CHANNELS][EBS_HISTOGRAM_BINS];
+        EBS_HistogramMerge(maps[0], band + k * subCount, layout);
+        uint64_t sum = 0;
+        for (uint64_t c = 0; c < selected; ++c) {
+            EBS_HistogramFold(maps[c], depth);
+            sum += EBS_EntropySum(entropyTable, maps[c]);
+        }
+        squares[k] = EBS_SquareMake(EBS_EntropyKey(entropyTable, squareSize * squareSize, selected, sum),
+                                    y / squareSize * squareWidth + k);
     }
 }
 
-EBS_SquareList EBS_SquareListCreate(const EBS_Image *image, uint64_t squareSize) {
+EBS_SquareList EBS_SquareListShape(const EBS_Image *image, uint64_t squareSize, uint64_t depth,
+                                   uint64_t channelMask) {
     EBS_SquareList squareList;
     const uint64_t squareWidth = image->width / squareSize;
     const uint64_t squareHeight = image->height / squareSize;
     squareList.size = squareWidth * squareHeight;
-    squareList.squareCapacity = squareSize * squareSize * image->channel / 8;
+    squareList.squareCapacity = squareSize * squareSize * EBS_ChannelCount(image->channel, channelMask) * depth / 8;
+    squareList.squares = NULL;
+    return squareList;
+}
+
+EBS_SquareList EBS_SquareListInit(const EBS_Image *image, uint64_t squareSize, uint64_t depth,
+                                  uint64_t channelMask) {
+    EBS_SquareList squareList = EBS_SquareListShape(image, squareSize, depth, channelMask);
     squareList.squares = (EBS_Square *) calloc(squareList.size, sizeof(EBS_Square));
-    if (squareList.squares == NULL) return squareList;
+    return squareList;
+}
+
+uint64_t EBS_SquareListScratchSize(const EBS_Image *image, uint64_t squareSize, uint64_t channelMask) {
+    EBS_Image bytes;
+    uint64_t depth = 1;
+    image = EBS_EntropyImage(image, &bytes, &depth, &channelMask);
+    const uint64_t selected = EBS_ChannelCount(image->channel, channelMask);
+    if (selected > EBS_HISTOGRAM_MAX_CHANNELS) return 0;
+    const bool packs = EBS_ChannelMaskResolve(image->channel, channelMask) != 0 &&
+                       !EBS_ChannelRGB(image->channel, channelMask);
+    const uint64_t histograms = image->width / squareSize * EBS_HistogramSubCount(packs ? selected : image->channel);
+    if (!packs) return histograms;
+    // room for a packed row, counted in histograms
+    const uint64_t rowSize = image->width * selected;
+    return histograms + (rowSize + sizeof(uint16_t[EBS_HISTOGRAM_BINS]) - 1) / sizeof(uint16_t[EBS_HISTOGRAM_BINS]);
+}
 
-    uint64_t i = 0;
-    for (uint64_t y = 0; y < image->height - image->height % squareSize; y += squareSize) {
-        for (uint64_t x = 0; x < image->width - image->width % squareSize; x += squareSize) {
-            squareList.squares[i] = (EBS_Square) {.x = x, .y = y};
-            EBS_SquareCalcEntropy(image, squareList.squares + i, squareSize);
-            ++i;
+void EBS_SquareListCalc(const EBS_Image *image, EBS_SquareList *squareList, uint64_t squareSize, uint64_t depth,
+                        uint64_t channelMask, uint64_t bandBegin, uint64_t bandEnd, uint16_t (*scratch)[EBS_HISTOGRAM_BINS],
+                        const uint64_t *entropyTable) {
+    EBS_Image bytes;
+    image = EBS_EntropyImage(image, &bytes, &depth, &channelMask);
+    const uint64_t squareWidth = image->width / squareSize;
+    const uint64_t selected = EBS_ChannelCount(image->channel, channelMask);
+    for (uint64_t band = bandBegin; band < bandEnd; ++band) {
+        EBS_Square *squares = squareList->squares + band * squareWidth;
+        if (selected <= EBS_HISTOGRAM_MAX_CHANNELS) {
+            EBS_SquareListCalcBand(image, squares, band * squareSize, squareSize, depth, channelMask, scratch,
+                                   entropyTable);
+            continue;
+        }
+        for (uint64_t k = 0; k < squareWidth; ++k) {
+            squares[k] = EBS_SquareMake(0, band * squareWidth + k);
+            EBS_SquareCalcEntropy(image, squares + k, squareSize, depth, channelMask, entropyTable);
         }
     }
+}
+
+// lists shorter than this are insertion sorted, the radix counters would cost more than the sort
+#define EBS_RADIX_MIN_SIZE 64
+
+#define EBS_RADIX_BITS 8
+
+#define EBS_RADIX_PASSES (32 / EBS_RADIX_BITS)
+
+static inline uint32_t EBS_SquareRadixDigit(const EBS_Square *square, uint64_t pass) {
+    // the high half of the key, where the entropy is inverted so that an ascending sort puts the highest first
+    return (uint32_t) (square->key >> (32 + pass * EBS_RADIX_BITS)) & ((1u << EBS_RADIX_BITS) - 1);
+}
+
+static void EBS_SquareListInsertionSort(EBS_Square *squares, uint64_t size) {
+    for (uint64_t i = 1; i < size; ++i) {
+        const EBS_Square square = squares[i];
+        uint64_t j = i;
+        for (; j > 0 && squares[j - 1].key > square.key; --j) {
+            squares[j] = squares[j - 1];
+        }
+        squares[j] = square;
+    }
+}
+
+bool EBS_SquareListSort(EBS_SquareList *squareList, EBS_Square *buffer) {
+    // squares are created in row-major order and every pass is stable, so equal entropies stay ordered by position
+    const uint64_t size = squareList->size;
+    if (size < EBS_RADIX_MIN_SIZE) {
+        EBS_SquareListInsertionSort(squareList->squares, size);
+        return true;
+    }
+
+    uint64_t counts[EBS_RADIX_PASSES][1 << EBS_RADIX_BITS] = {{0}};
+    for (uint64_t i = 0; i < size; ++i) {
+        for (uint64_t pass = 0; pass < EBS_RADIX_PASSES; ++pass) {
+            ++counts[pass][EBS_SquareRadixDigit(squareList->squares + i, pass)];
+        }
+    }
+
+    // a buffer from the caller holds as many squares as the list, NULL allocates one
+    EBS_Square *allocated = NULL;
+    if (buffer == NULL) {
+        buffer = allocated = (EBS_Square *) malloc(size * sizeof(EBS_Square));
+        if (buffer == NULL) return false;
+    }
+
+    EBS_Square *source = squareList->squares, *destination = buffer;
+    for (uint64_t pass = 0; pass < EBS_RADIX_PASSES; ++pass) {
+        uint64_t *count = counts[pass];
+        // a digit shared by every square doesn't change the order
+        if (count[EBS_SquareRadixDigit(source, pass)] == size) continue;
+
+        uint64_t offset = 0;
+        for (uint64_t digit = 0; digit < (1 << EBS_RADIX_BITS); ++digit) {
+            const uint64_t digitCount = count[digit];
+            count[digit] = offset;
+            offset += digitCount;
+        }
+        for (uint64_t i = 0; i < size; ++i) {
+            destination[count[EBS_SquareRadixDigit(source + i, pass)]++] = source[i];
+        }
+
+        EBS_Square *swap = source;
+        source = destination;
+        destination = swap;
+    }
+
+    if (source != squareList->squares) {
+        memcpy(squareList->squares, source, size * sizeof(EBS_Square));
+    }
+    free(allocated);
+    return true;
+}
+
+static uint64_t EBS_SquareListSelectThreshold(const EBS_Square *squares, uint64_t size, uint64_t *count) {
+    // walks the inverted key digit by digit, keeping only the squares that share the digits found so far
+    uint32_t prefix = 0, prefixMask = 0;
+    for (uint64_t pass = EBS_RADIX_PASSES; pass-- > 0;) {
+        uint64_t digitCounts[1 << EBS_RADIX_BITS] = {0};
+        for (uint64_t i = 0; i < size; ++i) {
+            if (((uint32_t) (squares[i].key >> 32) & prefixMask) != prefix) continue;
+            ++digitCounts[EBS_SquareRadixDigit(squares + i, pass)];
+        }
+
+        uint64_t digit = 0;
+        for (; *count > digitCounts[digit]; ++digit) {
+            *count -= digitCounts[digit];
+        }
+        prefix |= (uint32_t) digit << (pass * EBS_RADIX_BITS);
+        prefixMask |= ((1u << EBS_RADIX_BITS) - 1) << (pass * EBS_RADIX_BITS);
+    }
+    return ~prefix;
+}
 
-    qsort(squareList.squares, squareList.size, sizeof(EBS_Square), EBS_SquareCompare);
+static bool EBS_SquareListSelect(EBS_SquareList *squareList, uint64_t squareLimit, EBS_Square *buffer) {
+    // the threshold entropy is the lowest one that makes the cut, count is how many of its squares do
+    EBS_Square *squares = squareList->squares;
+    uint64_t count = squareLimit;
+    const uint32_t threshold = EBS_SquareListSelectThreshold(squares, squareList->size, &count);
 
+    // chosen squares move to the front in their original order, the others are only swapped around
+    uint64_t chosen = 0;
+    for (uint64_t i = 0; i < squareList->size && chosen < squareLimit; ++i) {
+        const uint32_t entropy = EBS_SquareEntropy(squares[i]);
+        if (entropy < threshold || (entropy == threshold && count == 0)) continue;
+        if (entropy == threshold) --count;
+
+        const EBS_Square square = squares[i];
+        squares[i] = squares[chosen];
+        squares[chosen++] = square;
+    }
+
+    EBS_SquareList front = {
+            .size = squareLimit,
+            .squareCapacity = squareList->squareCapacity,
+            .squares = squares
+    };
+    return EBS_SquareListSort(&front, buffer);
+}
+
+bool EBS_SquareListOrder(EBS_SquareList *squareList, uint64_t squareLimit, EBS_Square *buffer) {
+    // selecting costs a few passes over the entropies, past this share of the list a full sort is cheaper
+    if (squareLimit >= squareList->size / 4) return EBS_SquareListSort(squareList, buffer);
+    if (squareLimit == 0) return true;
+    return EBS_SquareListSelect(squareList, squareLimit, buffer);
+}
+
+uint64_t EBS_SquareListFindMax(const EBS_SquareList *squareList) {
+    uint64_t maxIndex = 0;
+    for (uint64_t i = 1; i < squareList->size; ++i) {
+        if (EBS_SquareEntropy(squareList->squares[i]) > EBS_SquareEntropy(squareList->squares[maxIndex])) {
+            maxIndex = i;
+        }
+    }
+    return maxIndex;
+}
+
+EBS_SquareList EBS_SquareListCreate(const EBS_Image *image, uint64_t squareSize, uint64_t depth,
+                                    uint64_t channelMask) {
+    EBS_SquareList squareList = EBS_SquareListInit(image, squareSize, depth, channelMask);
+    if (squareList.squares == NULL) return squareList;
+
+    const uint64_t *entropyTable = EBS_EntropyTableGet(NULL, squareSize);
+    uint16_t (*scratch)[EBS_HISTOGRAM_BINS] = calloc(EBS_SquareListScratchSize(image, squareSize, channelMask) + 1,
+                                                     sizeof(*scratch));
+    if (entropyTable == NULL || scratch == NULL) {
+        free(scratch);
+        EBS_SquareListFree(&squareList);
+        return squareList;
+    }
+
+    EBS_SquareListCalc(image, &squareList, squareSize, depth, channelMask, 0, image->height / squareSize, scratch,
+                       entropyTable);
+    free(scratch);
+
+    if (!EBS_SquareListSort(&squareList, NULL)) {
+        EBS_SquareListFree(&squareList);
+    }
     return squareList;
 }
 
@@ -73,6 +365,50 @@ void EBS_SquareListFree(EBS_SquareList *squareList) {
     squareList->squareCapacity = 0;
 }
 
+void EBS_ImageRead(const EBS_Image *image, uint64_t offset, uint8_t *buffer, uint64_t size) {
+    // bytes of the pixels as if the rows were packed, so that a view hashes the same as a copy of its pixels
+    const uint64_t rowSize = EBS_ImageRowSize(image), stride = EBS_ImageStride(image);
+    if (stride == rowSize) {
+        memcpy(buffer, image->pixels + offset, size);
+        return;
+    }
+    while (size != 0) {
+        const uint64_t column = offset % rowSize;
+        const uint64_t count = rowSize - column < size ? rowSize - column : size;
+        memcpy(buffer, image->pixels + offset / rowSize * stride + column, count);
+        buffer += count;
+        offset += count;
+        size -= count;
+    }
+}
+
+#define EBS_IMAGE_HASH_CHUNK 4096
+
+// hashes the pixels without the 4 low bits any depth can write to, so embedding doesn't change where an image sorts
+static XXH128_hash_t EBS_ImageHash(const EBS_Image *image, bool wide) {
+    const uint64_t mask = 0xf0f0f0f0f0f0f0f0ull;
+    const uint64_t imageSize = EBS_ImageRowSize(image) * image->height;
+    uint64_t words[EBS_IMAGE_HASH_CHUNK / sizeof(uint64_t)];
+    XXH128_hash_t hash = {0, 0};
+    for (uint64_t offset = 0; offset < imageSize; offset += EBS_IMAGE_HASH_CHUNK) {
+        const uint64_t chunk = imageSize - offset < EBS_IMAGE_HASH_CHUNK ? imageSize - offset : EBS_IMAGE_HASH_CHUNK;
+        // only the bytes of a last partial word are never copied, clearing the whole buffer costs more than small
+        // images take to hash
+        words[(chunk - 1) / 8] = 0;
+        EBS_ImageRead(image, offset, (uint8_t *) words, chunk);
+        for (uint64_t i = 0; i < (chunk + 7) / 8; ++i) {
+            words[i] &= mask;
+        }
+        // every chunk is seeded with the hash so far
+        if (wide) {
+            hash = XXH3_128bits_withSeed(words, chunk, hash.low64 ^ hash.high64);
+        } else {
+            hash.low64 = XXH3_64bits_withSeed(words, chunk, hash.low64);
+        }
+    }
+    return hash;
+}
+
 int EBS_ImageCompare(const void *image1, const void *image2) {
     const EBS_Image *ebsImage1 = image1;
     const EBS_Image *ebsImage2 = image2;
@@ -87,82 +423,670 @@ int EBS_ImageCompare(const void *image1, const void *image2) {
     if (ebsImage1->channel != ebsImage2->channel) {
         return ebsImage1->channel > ebsImage2->channel ? 1 : -1;
     }
+    if (EBS_ImageSampleSize(ebsImage1) != EBS_ImageSampleSize(ebsImage2)) {
+        return EBS_ImageSampleSize(ebsImage1) > EBS_ImageSampleSize(ebsImage2) ? 1 : -1;
+    }
 
-    // if the sizes are the same, compare the content
-    const uint64_t imageSize = ebsImage1->width * ebsImage1->height * ebsImage1->channel;
-
-    // 64 bits first, in most cases it's enough
-    const XXH64_hash_t hash64_1 = XXH3_64bits(ebsImage1->pixels, imageSize);
-    const XXH64_hash_t hash64_2 = XXH3_64bits(ebsImage2->pixels, imageSize);
+    // if the sizes are the same, compare the content, 64 bits first, in most cases it's enough
+    const XXH64_hash_t hash64_1 = EBS_ImageHash(ebsImage1, false).low64;
+    const XXH64_hash_t hash64_2 = EBS_ImageHash(ebsImage2, false).low64;
     if (hash64_1 != hash64_2) {
         return hash64_1 > hash64_2 ? 1 : -1;
     }
 
     // 128 bits if the 64-bit hashes are identical
-    const XXH128_hash_t hash128_1 = XXH3_128bits(ebsImage1->pixels, imageSize);
-    const XXH128_hash_t hash128_2 = XXH3_128bits(ebsImage2->pixels, imageSize);
+    const XXH128_hash_t hash128_1 = EBS_ImageHash(ebsImage1, true);
+    const XXH128_hash_t hash128_2 = EBS_ImageHash(ebsImage2, true);
     return XXH128_cmp(&hash128_1, &hash128_2);
 }
 
-EBS_ComputedImageList EBS_ComputedImageListCreate(EBS_ImageList *imageList, uint64_t squareSize) {
-    EBS_ComputedImageList computedImageList;
-    computedImageList.size = imageList->size;
-    computedImageList.computedImages = (EBS_ComputedImage *) calloc(computedImageList.size, sizeof(EBS_ComputedImage));
+// images are hashed this many at a time
+#define EBS_IMAGE_KEY_TASK 256
+
+// what images are sorted by, computed once per image instead of once per comparison
+typedef struct EBS_ImageKey {
+    uint64_t width;
+    uint64_t height;
+    uint64_t channel;
+    uint64_t sampleSize;
+    uint64_t hash;
+    const EBS_Image *image;
+} EBS_ImageKey;
+
+typedef struct EBS_ImageKeyContext {
+    const EBS_ImageList *imageList;
+    EBS_ImageKey *keys;
+} EBS_ImageKeyContext;
+
+static void EBS_ImageKeyTaskRun(void *context, uint64_t task, uint64_t worker) {
+    (void) worker;
+    const EBS_ImageKeyContext *keyContext = context;
+    const uint64_t end = (task + 1) * EBS_IMAGE_KEY_TASK < keyContext->imageList->size ?
+                         (task + 1) * EBS_IMAGE_KEY_TASK : keyContext->imageList->size;
+    for (uint64_t i = task * EBS_IMAGE_KEY_TASK; i < end; ++i) {
+        const EBS_Image *image = keyContext->imageList->images + i;
+        keyContext->keys[i] = (EBS_ImageKey) {
+                .width = image->width,
+                .height = image->height,
+                .channel = image->channel,
+                .sampleSize = EBS_ImageSampleSize(image),
+                .hash = EBS_ImageHash(image, false).low64,
+                .image = image
+        };
+    }
+}
+
+static int EBS_ImageKeyCompare(const void *key1, const void *key2) {
+    // the order of EBS_ImageCompare, then the order the images were given in, so that equal images sort the same
+    // way every time
+    const EBS_ImageKey *imageKey1 = key1;
+    const EBS_ImageKey *imageKey2 = key2;
+    if (imageKey1->width != imageKey2->width) return imageKey1->width > imageKey2->width ? 1 : -1;
+    if (imageKey1->height != imageKey2->height) return imageKey1->height > imageKey2->height ? 1 : -1;
+    if (imageKey1->channel != imageKey2->channel) return imageKey1->channel > imageKey2->channel ? 1 : -1;
+    if (imageKey1->sampleSize != imageKey2->sampleSize) return imageKey1->sampleSize > imageKey2->sampleSize ? 1 : -1;
+    if (imageKey1->hash != imageKey2->hash) return imageKey1->hash > imageKey2->hash ? 1 : -1;
+
+    const XXH128_hash_t hash128_1 = EBS_ImageHash(imageKey1->image, true);
+    const XXH128_hash_t hash128_2 = EBS_ImageHash(imageKey2->image, true);
+    const int compare = XXH128_cmp(&hash128_1, &hash128_2);
+    if (compare != 0) return compare;
+    return imageKey1->image > imageKey2->image ? 1 : -1;
+}
+
+static bool EBS_ImageListSort(EBS_ImageList *imageList, EBS_ComputedImage *computedImages, EBS_Context *context,
+                              uint64_t threadCount) {
+    // every image is hashed once, then only the keys are compared
+    EBS_ImageKeyContext keyContext = {
+            .imageList = imageList,
+            .keys = (EBS_ImageKey *) EBS_ScratchGet(context, EBS_SCRATCH_KEYS, imageList->size * sizeof(EBS_ImageKey))
+    };
+    if (keyContext.keys == NULL) return false;
+    const uint64_t taskCount = (imageList->size + EBS_IMAGE_KEY_TASK - 1) / EBS_IMAGE_KEY_TASK;
+    EBS_ParallelFor(context, EBS_ParallelWorkers(threadCount, taskCount), taskCount, EBS_ImageKeyTaskRun,
+                    &keyContext);
+    qsort(keyContext.keys, imageList->size, sizeof(EBS_ImageKey), EBS_ImageKeyCompare);
+
+    // the keys point into the caller's array, so the images go through the computed images before it's sorted
+    for (uint64_t i = 0; i < imageList->size; ++i) {
+        computedImages[i].image = *keyContext.keys[i].image;
+    }
+    for (uint64_t i = 0; i < imageList->size; ++i) {
+        imageList->images[i] = computedImages[i].image;
+    }
+    EBS_ScratchRelease(context, keyContext.keys);
+    return true;
+}
+
+// bands are grouped into tasks of roughly this many bytes of pixels
+#define EBS_TASK_BYTES (1 << 20)
+
+// bands of one image, or whole images in a row when they are small enough to share a task
+typedef struct EBS_BandTask {
+    uint64_t image;
+    uint64_t imageEnd;
+    uint64_t bandBegin;
+    uint64_t bandEnd;
+} EBS_BandTask;
+
+typedef struct EBS_ComputeContext {
+    EBS_ComputedImageList *computedImageList;
+    uint64_t squareSize;
+    uint64_t depth;
+    uint64_t channelMask;
+    const uint64_t *entropyTable;
+    const EBS_BandTask *tasks;
+    uint16_t (*scratch)[EBS_HISTOGRAM_BINS];
+    uint64_t scratchSize;
+} EBS_ComputeContext;
+
+static uint64_t EBS_BandsPerTask(const EBS_Image *image, uint64_t squareSize) {
+    const uint64_t bandSize = squareSize * EBS_ImageRowSize(image);
+    return bandSize >= EBS_TASK_BYTES ? 1 : EBS_TASK_BYTES / bandSize;
+}
+
+static void EBS_BandTaskRun(void *context, uint64_t task, uint64_t worker) {
+    const EBS_ComputeContext *computeContext = context;
+    const EBS_BandTask *bandTask = computeContext->tasks + task;
+    for (uint64_t i = bandTask->image; i < bandTask->imageEnd; ++i) {
+        EBS_ComputedImage *computedImage = computeContext->computedImageList->computedImages + i;
+        const uint64_t bands = computedImage->image.height / computeContext->squareSize;
+        EBS_SquareListCalc(&computedImage->image, &computedImage->squareList, computeContext->squareSize,
+                           computeContext->depth, computeContext->channelMask, bandTask->bandBegin,
+                           bandTask->bandEnd < bands ? bandTask->bandEnd : bands,
+                           computeContext->scratch + worker * computeContext->scratchSize,
+                           computeContext->entropyTable);
+    }
+}
+
+// lists are grouped into tasks of roughly this many squares
+#define EBS_ORDER_TASK_SQUARES (1 << 16)
+
+typedef struct EBS_OrderContext {
+    EBS_ComputedImageList *computedImageList;
+    uint64_t squareLimit;
+    const bool *ordered;
+    const uint64_t *taskBegins;
+    EBS_Square *buffers;
+    uint64_t bufferSize;
+} EBS_OrderContext;
+
+static void EBS_OrderTaskRun(void *context, uint64_t task, uint64_t worker) {
+    const EBS_OrderContext *orderContext = context;
+    for (uint64_t i = orderContext->taskBegins[task]; i < orderContext->taskBegins[task + 1]; ++i) {
+        if (orderContext->ordered != NULL && orderContext->ordered[i]) continue;
+        EBS_SquareList *squareList = &orderContext->computedImageList->computedImages[i].squareList;
+        // a list that couldn't be ordered is dropped and reported once all tasks are done
+        if (!EBS_SquareListOrder(squareList, orderContext->squareLimit,
+                                 orderContext->buffers + worker * orderContext->bufferSize)) {
+            squareList->squares = NULL;
+        }
+    }
+}
+
+// counts the tasks, and with taskBegins gives the first list of each, then the end of the last one
+static uint64_t EBS_OrderTasks(const EBS_ComputedImageList *computedImageList, const bool *ordered,
+                               uint64_t *taskBegins) {
+    // a list joins the task before it until that task holds enough squares, so a large list still gets a task alone
+    uint64_t taskCount = 0, squares = EBS_ORDER_TASK_SQUARES;
+    for (uint64_t i = 0; i < computedImageList->size; ++i) {
+        if (ordered != NULL && ordered[i]) continue;
+        if (squares >= EBS_ORDER_TASK_SQUARES) {
+            if (taskBegins != NULL) taskBegins[taskCount] = i;
+            ++taskCount;
+            squares = 0;
+        }
+        squares += computedImageList->computedImages[i].squareList.size;
+    }
+    if (taskBegins != NULL) taskBegins[taskCount] = computedImageList->size;
+    return taskCount;
+}
+
+static bool EBS_ComputedImageListOrderRemaining(EBS_ComputedImageList *computedImageList, uint64_t squareLimit,
+                                                uint64_t threadCount, const bool *ordered) {
+    // the first list of every task, then a sort buffer per worker as large as the largest list, in one allocation
+    uint64_t bufferSize = 0;
+    for (uint64_t i = 0; i < computedImageList->size; ++i) {
+        const uint64_t size = computedImageList->computedImages[i].squareList.size;
+        if (size > bufferSize) bufferSize = size;
+    }
+    const uint64_t taskCount = EBS_OrderTasks(computedImageList, ordered, NULL);
+    const uint64_t workerCount = EBS_ParallelWorkers(threadCount, taskCount);
+    uint64_t *taskBegins = (uint64_t *) EBS_ScratchGet(
+            computedImageList->context, EBS_SCRATCH_SORT,
+            (taskCount + 1) * sizeof(uint64_t) + workerCount * bufferSize * sizeof(EBS_Square));
+    if (taskBegins == NULL) return false;
+    EBS_OrderTasks(computedImageList, ordered, taskBegins);
+
+    EBS_OrderContext context = {
+            .computedImageList = computedImageList,
+            .squareLimit = squareLimit,
+            .ordered = ordered,
+            .taskBegins = taskBegins,
+            .buffers = (EBS_Square *) (taskBegins + taskCount + 1),
+            .bufferSize = bufferSize
+    };
+    EBS_ParallelFor(computedImageList->context, workerCount, taskCount, EBS_OrderTaskRun, &context);
+    EBS_ScratchRelease(computedImageList->context, taskBegins);
+
+    for (uint64_t i = 0; i < computedImageList->size; ++i) {
+        if (computedImageList->computedImages[i].squareList.squares == NULL) return false;
+    }
+    return true;
+}
+
+bool EBS_ComputedImageListOrder(EBS_ComputedImageList *computedImageList, uint64_t squareLimit,
+                                uint64_t threadCount) {
+    return EBS_ComputedImageListOrderRemaining(computedImageList, squareLimit, threadCount, NULL);
+}
+
+typedef struct EBS_IndexContext {
+    EBS_ComputedImageList *computedImageList;
+    const char *directory;
+    uint64_t squareSize;
+    uint64_t depth;
+    uint64_t channelMask;
+    uint64_t *keys;
+    bool *hashed;
+    bool *loaded;
+    // the room for the paths of the index files, for every worker
+    char *paths;
+    uint64_t pathsSize;
+} EBS_IndexContext;
+
+static void EBS_IndexLoadTaskRun(void *context, uint64_t task, uint64_t worker) {
+    const EBS_IndexContext *indexContext = context;
+    EBS_ComputedImage *computedImage = indexContext->computedImageList->computedImages + task;
+    indexContext->hashed[task] = EBS_IndexKey(&computedImage->image, indexContext->squareSize, indexContext->depth,
+                                              indexContext->channelMask, indexContext->keys + task);
+    indexContext->loaded[task] = indexContext->hashed[task] &&
+                                 EBS_IndexLoad(indexContext->directory,
+                                               indexContext->paths + worker * indexContext->pathsSize,
+                                               &computedImage->image,
+                                               indexContext->squareSize, indexContext->depth,
+                                               indexContext->channelMask, indexContext->keys[task],
+                                               &computedImage->squareList);
+}
+
+static void EBS_IndexSaveTaskRun(void *context, uint64_t task, uint64_t worker) {
+    const EBS_IndexContext *indexContext = context;
+    if (!indexContext->hashed[task] || indexContext->loaded[task]) return;
+    // the index is only a cache, an image that can't be saved is computed again next time
+    const EBS_ComputedImage *computedImage = indexContext->computedImageList->computedImages + task;
+    EBS_IndexSave(indexContext->directory, indexContext->paths + worker * indexContext->pathsSize,
+                  &computedImage->image, indexContext->squareSize, indexContext->depth, indexContext->channelMask,
+                  indexContext->keys[task], &computedImage->squareList);
+}
+
+static void *EBS_ComputedImageListAllocate(const EBS_ComputedImageList *computedImageList, uint64_t slot,
+                                           uint64_t size) {
+    if (computedImageList->scratch) return EBS_ScratchGet(computedImageList->context, slot, size);
+    return EBS_Allocate(computedImageList->context, size);
+}
+
+static void EBS_ComputedImageListDeallocate(const EBS_ComputedImageList *computedImageList, void *pointer) {
+    if (computedImageList->scratch) {
+        EBS_ScratchRelease(computedImageList->context, pointer);
+    } else {
+        EBS_Deallocate(computedImageList->context, pointer);
+    }
+}
+
+static void EBS_IndexContextRelease(EBS_Context *context, EBS_IndexContext *indexContext) {
+    EBS_ScratchRelease(context, indexContext->keys);
+    indexContext->keys = NULL;
+    indexContext->hashed = NULL;
+    indexContext->loaded = NULL;
+    indexContext->paths = NULL;
+}
+
+static EBS_ComputedImageList EBS_ComputedImageListMake(EBS_ImageList *imageList, const EBS_Options *options,
+                                                       uint64_t squareLimit, bool scratch) {
+    const uint64_t squareSize = options->squareSize;
+    const uint64_t depth = EBS_OptionsDepth(options);
+    const uint64_t channelMask = options->channelMask;
+    EBS_Context *context = options->context;
+    EBS_ComputedImageList computedImageList = {
+            .size = imageList->size,
+            .computedImages = NULL,
+            .squares = NULL,
+            .context = context,
+            .scratch = scratch
+    };
+    computedImageList.computedImages = (EBS_ComputedImage *) EBS_ComputedImageListAllocate(
+            &computedImageList, EBS_SCRATCH_IMAGES, computedImageList.size * sizeof(EBS_ComputedImage));
     if (computedImageList.computedImages == NULL) return computedImageList;
 
-    qsort(imageList->images, imageList->size, sizeof(EBS_Image), EBS_ImageCompare);
+    if (!EBS_ImageListSort(imageList, computedImageList.computedImages, context, options->threadCount)) {
+        EBS_ComputedImageListFree(&computedImageList);
+        return computedImageList;
+    }
+
+    const uint64_t *entropyTable = EBS_EntropyTableGet(context, squareSize);
+    if (entropyTable == NULL) {
+        EBS_ComputedImageListFree(&computedImageList);
+        return computedImageList;
+    }
 
+    // the lists share one block, in the order of the images
+    uint64_t squareCount = 0;
     for (uint64_t i = 0; i < imageList->size; ++i) {
         const EBS_Image *image = imageList->images + i;
-        EBS_SquareList squareList = EBS_SquareListCreate(image, squareSize);
-        EBS_ComputedImage computedImage = {
+        computedImageList.computedImages[i] = (EBS_ComputedImage) {
                 .image = *image,
-                .squareList = squareList
+                .squareList = EBS_SquareListShape(image, squareSize, depth, channelMask)
         };
-        if (computedImage.squareList.squares == NULL) {
+        squareCount += computedImageList.computedImages[i].squareList.size;
+    }
+    computedImageList.squares = (EBS_Square *) EBS_ComputedImageListAllocate(
+            &computedImageList, EBS_SCRATCH_SQUARES, squareCount * sizeof(EBS_Square));
+    if (computedImageList.squares == NULL) {
+        EBS_ComputedImageListFree(&computedImageList);
+        return computedImageList;
+    }
+    squareCount = 0;
+    for (uint64_t i = 0; i < imageList->size; ++i) {
+        EBS_SquareList *squareList = &computedImageList.computedImages[i].squareList;
+        squareList->squares = computedImageList.squares + squareCount;
+        squareCount += squareList->size;
+    }
+
+    EBS_IndexContext indexContext = {
+            .computedImageList = &computedImageList,
+            .directory = options->indexDirectory,
+            .squareSize = squareSize,
+            .depth = depth,
+            .channelMask = channelMask,
+            .keys = NULL,
+            .hashed = NULL,
+            .loaded = NULL,
+            .paths = NULL,
+            .pathsSize = 0
+    };
+    const uint64_t indexWorkers = EBS_ParallelWorkers(options->threadCount, computedImageList.size);
+    if (indexContext.directory != NULL) {
+        // the keys, then which images were hashed and loaded, then the paths of every worker, in one allocation
+        const uint64_t count = computedImageList.size + 1;
+        const uint64_t size = count * (sizeof(uint64_t) + 2 * sizeof(bool));
+        indexContext.pathsSize = EBS_IndexPathsSize(indexContext.directory);
+        indexContext.keys = (uint64_t *) EBS_ScratchGet(context, EBS_SCRATCH_INDEX,
+                                                        size + indexWorkers * indexContext.pathsSize);
+        if (indexContext.keys == NULL) {
             EBS_ComputedImageListFree(&computedImageList);
             return computedImageList;
         }
-        computedImageList.computedImages[i] = computedImage;
+        memset(indexContext.keys, 0, size);
+        indexContext.hashed = (bool *) (indexContext.keys + count);
+        indexContext.loaded = indexContext.hashed + count;
+        indexContext.paths = (char *) indexContext.keys + size;
+        EBS_ParallelFor(context, indexWorkers, computedImageList.size, EBS_IndexLoadTaskRun, &indexContext);
+        // saved lists are fully ordered, whatever the caller needs this time
+        squareLimit = EBS_SQUARE_LIST_ORDER_ALL;
+    }
+
+    uint64_t taskLimit = 0, scratchSize = 1;
+    for (uint64_t i = 0; i < imageList->size; ++i) {
+        if (indexContext.loaded != NULL && indexContext.loaded[i]) continue;
+        const EBS_Image *image = imageList->images + i;
+        const uint64_t bandsPerTask = EBS_BandsPerTask(image, squareSize);
+        taskLimit += (image->height / squareSize + bandsPerTask - 1) / bandsPerTask;
+        const uint64_t imageScratchSize = EBS_SquareListScratchSize(image, squareSize, channelMask);
+        if (imageScratchSize > scratchSize) scratchSize = imageScratchSize;
+    }
+
+    EBS_BandTask *tasks = (EBS_BandTask *) EBS_ScratchGet(context, EBS_SCRATCH_BANDS,
+                                                          (taskLimit + 1) * sizeof(EBS_BandTask));
+    if (tasks == NULL) {
+        EBS_IndexContextRelease(context, &indexContext);
+        EBS_ComputedImageListFree(&computedImageList);
+        return computedImageList;
     }
 
+    // images of fewer bands than a task holds join the task before them, so that a list of thumbnails isn't a task
+    // per image
+    uint64_t taskCount = 0, groupBytes = 0;
+    bool grouping = false;
+    for (uint64_t i = 0; i < imageList->size; ++i) {
+        if (indexContext.loaded != NULL && indexContext.loaded[i]) continue;
+        const EBS_Image *image = imageList->images + i;
+        const uint64_t bands = image->height / squareSize;
+        const uint64_t bandsPerTask = EBS_BandsPerTask(image, squareSize);
+        if (bands <= bandsPerTask) {
+            const uint64_t imageBytes = bands * squareSize * EBS_ImageRowSize(image);
+            if (grouping && tasks[taskCount - 1].imageEnd == i && groupBytes + imageBytes <= EBS_TASK_BYTES) {
+                tasks[taskCount - 1].imageEnd = i + 1;
+                groupBytes += imageBytes;
+            } else {
+                tasks[taskCount++] = (EBS_BandTask) {
+                        .image = i,
+                        .imageEnd = i + 1,
+                        .bandBegin = 0,
+                        .bandEnd = UINT64_MAX
+                };
+                groupBytes = imageBytes;
+                grouping = true;
+            }
+            continue;
+        }
+
+        grouping = false;
+        for (uint64_t band = 0; band < bands; band += bandsPerTask) {
+            tasks[taskCount++] = (EBS_BandTask) {
+                    .image = i,
+                    .imageEnd = i + 1,
+                    .bandBegin = band,
+                    .bandEnd = band + bandsPerTask < bands ? band + bandsPerTask : bands
+            };
+        }
+    }
+
+    // every task writes its own bands, so the result doesn't depend on the number of threads
+    const uint64_t workerCount = EBS_ParallelWorkers(options->threadCount, taskCount);
+    // every band clears the histograms it uses, so they don't need to start at 0
+    uint16_t (*histograms)[EBS_HISTOGRAM_BINS] = EBS_ScratchGet(context, EBS_SCRATCH_HISTOGRAMS,
+                                                                workerCount * scratchSize * sizeof(*histograms));
+    if (histograms == NULL) {
+        EBS_ScratchRelease(context, tasks);
+        EBS_IndexContextRelease(context, &indexContext);
+        EBS_ComputedImageListFree(&computedImageList);
+        return computedImageList;
+    }
+
+    EBS_ComputeContext computeContext = {
+            .computedImageList = &computedImageList,
+            .squareSize = squareSize,
+            .depth = depth,
+            .channelMask = channelMask,
+            .entropyTable = entropyTable,
+            .tasks = tasks,
+            .scratch = histograms,
+            .scratchSize = scratchSize
+    };
+    EBS_ParallelFor(context, workerCount, taskCount, EBS_BandTaskRun, &computeContext);
+
+    EBS_ScratchRelease(context, tasks);
+    EBS_ScratchRelease(context, histograms);
+    bool ordered = EBS_ComputedImageListOrderRemaining(&computedImageList, squareLimit, options->threadCount,
+                                                       indexContext.loaded);
+    if (ordered && indexContext.directory != NULL) {
+        EBS_ParallelFor(context, indexWorkers, computedImageList.size, EBS_IndexSaveTaskRun, &indexContext);
+    }
+
+    EBS_IndexContextRelease(context, &indexContext);
+    if (!ordered) {
+        EBS_ComputedImageListFree(&computedImageList);
+    }
     return computedImageList;
 }
 
+EBS_ComputedImageList EBS_ComputedImageListCreate(EBS_ImageList *imageList, const EBS_Options *options,
+                                                  uint64_t squareLimit) {
+    // only needed until the call returns, so the lists are kept in the arenas of the context
+    return EBS_ComputedImageListMake(imageList, options, squareLimit, true);
+}
+
+EBS_ComputedImageList EBS_ComputedImageListCreateOwned(EBS_ImageList *imageList, const EBS_Options *options,
+                                                       uint64_t squareLimit) {
+    // kept across calls, so the lists can't be in arenas the next call reuses
+    return EBS_ComputedImageListMake(imageList, options, squareLimit, false);
+}
+
 void EBS_ComputedImageListFree(EBS_ComputedImageList *computedImageList) {
-    for (uint64_t i = 0; i < computedImageList->size; ++i) {
-        EBS_SquareListFree(&computedImageList->computedImages[i].squareList);
+    if (computedImageList->computedImages != NULL) {
+        EBS_ComputedImageListDeallocate(computedImageList, computedImageList->squares);
+        EBS_ComputedImageListDeallocate(computedImageList, computedImageList->computedImages);
     }
-    free(computedImageList->computedImages);
     computedImageList->computedImages = NULL;
+    computedImageList->squares = NULL;
     computedImageList->size = 0;
 }
 
 uint64_t EBS_ComputedImageListFindMaxEntropy(const EBS_ComputedImageList *computedImageList, const uint64_t *squareIndex) {
-    uint64_t maxComputedImageIndex = 0;
-    double maxEntropy = 0.;
-    if (squareIndex) {
-        for (uint64_t i = 0; i < computedImageList->size; ++i) {
-            if (computedImageList->computedImages[i].squareList.size == squareIndex[i]) continue;
-            const double entropy = computedImageList->computedImages[i].squareList.squares[squareIndex[i]].entropy;
-            if (entropy > maxEntropy) {
-                maxEntropy = entropy;
-                maxComputedImageIndex = i;
-            }
+    // starts past the end so the first list with a square left is taken even if all its entropies are 0
+    uint64_t maxComputedImageIndex = computedImageList->size;
+    uint32_t maxEntropy = 0;
+    for (uint64_t i = 0; i < computedImageList->size; ++i) {
+        const EBS_SquareList *squareList = &computedImageList->computedImages[i].squareList;
+        const uint64_t index = squareIndex ? squareIndex[i] : 0;
+        // the lists share one block, an empty one would read the square of the next
+        if (squareList->size == index) continue;
+        const uint32_t entropy = EBS_SquareEntropy(squareList->squares[index]);
+        if (maxComputedImageIndex == computedImageList->size || entropy > maxEntropy) {
+            maxEntropy = entropy;
+            maxComputedImageIndex = i;
         }
+    }
+    return maxComputedImageIndex;
+}
+
+static inline bool EBS_SquareMergeBefore(const EBS_SquareMergeNode *node1, const EBS_SquareMergeNode *node2) {
+    // same order as EBS_ComputedImageListFindMaxEntropy, equal entropies go to the lowest image index
+    if (node1->entropy != node2->entropy) return node1->entropy > node2->entropy;
+    return node1->computedImageIndex < node2->computedImageIndex;
+}
+
+static void EBS_SquareMergeSiftDown(EBS_SquareMerge *squareMerge, uint64_t index) {
+    EBS_SquareMergeNode *heap = squareMerge->heap;
+    const EBS_SquareMergeNode node = heap[index];
+    while (true) {
+        uint64_t child = 2 * index + 1;
+        if (child >= squareMerge->heapSize) break;
+        if (child + 1 < squareMerge->heapSize && EBS_SquareMergeBefore(heap + child + 1, heap + child)) ++child;
+        if (!EBS_SquareMergeBefore(heap + child, &node)) break;
+        heap[index] = heap[child];
+        index = child;
+    }
+    heap[index] = node;
+}
+
+bool EBS_SquareMergeInit(EBS_SquareMerge *squareMerge, const EBS_ComputedImageList *computedImageList) {
+    const uint64_t size = computedImageList->size;
+    squareMerge->computedImageList = computedImageList;
+    // the heap follows the indices in one allocation
+    squareMerge->squareIndex = (uint64_t *) EBS_ScratchGet(
+            computedImageList->context, EBS_SCRATCH_MERGE,
+            (size + 1) * (sizeof(uint64_t) + sizeof(EBS_SquareMergeNode)));
+    squareMerge->heapSize = 0;
+    if (squareMerge->squareIndex == NULL) {
+        squareMerge->heap = NULL;
+        return false;
+    }
+    memset(squareMerge->squareIndex, 0, (size + 1) * sizeof(uint64_t));
+    squareMerge->heap = (EBS_SquareMergeNode *) (squareMerge->squareIndex + size + 1);
+
+    for (uint64_t i = 0; i < size; ++i) {
+        const EBS_SquareList *squareList = &computedImageList->computedImages[i].squareList;
+        if (squareList->size == 0) continue;
+        squareMerge->heap[squareMerge->heapSize++] = (EBS_SquareMergeNode) {
+                .computedImageIndex = i,
+                .entropy = EBS_SquareEntropy(squareList->squares[0])
+        };
+    }
+    for (uint64_t i = squareMerge->heapSize / 2; i-- > 0;) {
+        EBS_SquareMergeSiftDown(squareMerge, i);
+    }
+    return true;
+}
+
+uint64_t EBS_SquareMergeTop(const EBS_SquareMerge *squareMerge) {
+    return squareMerge->heapSize == 0 ? squareMerge->computedImageList->size : squareMerge->heap[0].computedImageIndex;
+}
+
+void EBS_SquareMergePop(EBS_SquareMerge *squareMerge) {
+    if (squareMerge->heapSize == 0) return;
+
+    EBS_SquareMergeNode *top = squareMerge->heap;
+    const EBS_SquareList *squareList =
+            &squareMerge->computedImageList->computedImages[top->computedImageIndex].squareList;
+    const uint64_t index = ++squareMerge->squareIndex[top->computedImageIndex];
+    if (index == squareList->size) {
+        *top = squareMerge->heap[--squareMerge->heapSize];
     } else {
-        for (uint64_t i = 0; i < computedImageList->size; ++i) {
-            const double entropy = computedImageList->computedImages[i].squareList.squares->entropy;
-            if (entropy > maxEntropy) {
-                maxEntropy = entropy;
-                maxComputedImageIndex = i;
-            }
+        top->entropy = EBS_SquareEntropy(squareList->squares[index]);
+    }
+    EBS_SquareMergeSiftDown(squareMerge, 0);
+}
+
+void EBS_SquareMergeFree(EBS_SquareMerge *squareMerge) {
+    EBS_ScratchRelease(squareMerge->computedImageList->context, squareMerge->squareIndex);
+    squareMerge->squareIndex = NULL;
+    squareMerge->heap = NULL;
+    squareMerge->heapSize = 0;
+}
+
+EBS_SquarePiece *EBS_SquarePiecesCreate(const EBS_ComputedImageList *computedImageList, uint64_t headerSize,
+                                        uint64_t messageSize, uint64_t *pieceCount) {
+    // the first piece is the header square holding the message size, no list holds fewer bytes than the smallest
+    // square, so this many pieces always do
+    uint64_t count = 1, minCapacity = UINT64_MAX;
+    for (uint64_t i = 0; i < computedImageList->size; ++i) {
+        const EBS_SquareList *squareList = &computedImageList->computedImages[i].squareList;
+        count += squareList->size;
+        if (squareList->size != 0 && squareList->squareCapacity < minCapacity) minCapacity = squareList->squareCapacity;
+    }
+    if (minCapacity != 0 && messageSize / minCapacity + 2 < count) count = messageSize / minCapacity + 2;
+
+    EBS_SquareMerge squareMerge;
+    EBS_SquarePiece *pieces = (EBS_SquarePiece *) EBS_ScratchGet(computedImageList->context, EBS_SCRATCH_PIECES,
+                                                                  count * sizeof(EBS_SquarePiece));
+    if (pieces == NULL || !EBS_SquareMergeInit(&squareMerge, computedImageList)) {
+        EBS_ScratchRelease(computedImageList->context, pieces);
+        return NULL;
+    }
+
+    // the caller made sure the message fits, squares never overlap so the pieces can be written in any order
+    uint64_t index = 0, offset = 0;
+    do {
+        const uint64_t computedImageIndex = EBS_SquareMergeTop(&squareMerge);
+        const EBS_SquareList *squareList = &computedImageList->computedImages[computedImageIndex].squareList;
+        EBS_SquarePiece *piece = pieces + index;
+        piece->computedImageIndex = computedImageIndex;
+        piece->square = squareList->squares + squareMerge.squareIndex[computedImageIndex];
+        if (index == 0) {
+            piece->offset = 0;
+            piece->size = headerSize;
+        } else {
+            piece->offset = offset;
+            piece->size = squareList->squareCapacity < messageSize - offset ? squareList->squareCapacity :
+                          messageSize - offset;
+            offset += piece->size;
         }
+        EBS_SquareMergePop(&squareMerge);
+        ++index;
+    } while (offset < messageSize);
+
+    EBS_SquareMergeFree(&squareMerge);
+    *pieceCount = index;
+    return pieces;
+}
+
+// pieces are grouped into tasks of roughly this many bytes of the message
+#define EBS_PIECE_TASK_BYTES (1 << 16)
+
+uint64_t EBS_SquarePiecesPerTask(uint64_t pieceCount, uint64_t messageSize) {
+    const uint64_t taskCount = messageSize / EBS_PIECE_TASK_BYTES;
+    if (taskCount <= 1) return pieceCount;
+    const uint64_t perTask = pieceCount / taskCount;
+    return perTask == 0 ? 1 : perTask;
+}
+
+void EBS_SquarePiecesBytes(const EBS_SquarePiece *pieces, uint64_t pieceCount, uint64_t piecesPerTask,
+                           uint64_t taskBegin, uint64_t taskEnd, uint64_t *begin, uint64_t *end) {
+    // the header piece comes before the message, so it's left out
+    uint64_t first = taskBegin * piecesPerTask;
+    uint64_t last = taskEnd * piecesPerTask;
+    if (first == 0) first = 1;
+    if (last > pieceCount) last = pieceCount;
+    if (first >= last) {
+        *begin = *end = 0;
+        return;
     }
-    return maxComputedImageIndex;
+    *begin = pieces[first].offset;
+    *end = pieces[last - 1].offset + pieces[last - 1].size;
+}
+
+uint64_t EBS_HeaderSize(bool checksum) {
+    // the message size, followed by the checksum of the message if there's one
+    return checksum ? 2 * sizeof(uint64_t) : sizeof(uint64_t);
 }
 
-uint64_t EBS_ComputedImageListCalcCapacity(const EBS_ComputedImageList *computedImageList) {
+uint64_t EBS_MessageSquareCount(const EBS_ImageList *imageList, uint64_t squareSize, uint64_t depth,
+                                uint64_t channelMask, uint64_t messageSize) {
+    uint64_t minChannel = UINT64_MAX;
+    for (uint64_t i = 0; i < imageList->size; ++i) {
+        const uint64_t selected = EBS_ChannelCount(imageList->images[i].channel, channelMask);
+        if (selected < minChannel) minChannel = selected;
+    }
+    if (minChannel == UINT64_MAX) return 0;
+
+    // every square holds at least as much as the smallest one, plus the header square and the final lookup
+    const uint64_t minSquareCapacity = squareSize * squareSize * minChannel * depth / 8;
+    const uint64_t pieces = messageSize / minSquareCapacity + (messageSize % minSquareCapacity != 0);
+    return pieces == 0 ? 2 : pieces + 1;
+}
+
+uint64_t EBS_ComputedImageListCalcCapacity(const EBS_ComputedImageList *computedImageList, bool checksum) {
+    if (computedImageList->size == 0) return 0;
     uint64_t capacity = 0;
     for (uint64_t i = 0; i < computedImageList->size; ++i) {
         const EBS_SquareList *squareList = &computedImageList->computedImages[i].squareList;
@@ -170,7 +1094,11 @@ uint64_t EBS_ComputedImageListCalcCapacity(const EBS_ComputedImageList *computed
     }
     {
         const uint64_t maxComputedImageIndex = EBS_ComputedImageListFindMaxEntropy(computedImageList, NULL);
+        // without any square there's no room even for the header
+        if (maxComputedImageIndex == computedImageList->size) return 0;
         EBS_ComputedImage *maxComputedImage = computedImageList->computedImages + maxComputedImageIndex;
+        // a checksum has to be read back whole from the header square, or nothing can be embedded
+        if (checksum && maxComputedImage->squareList.squareCapacity < EBS_HeaderSize(true)) return 0;
         capacity -= maxComputedImage->squareList.squareCapacity;
     }
     return capacity;
@@ -186,8 +1114,58 @@ bool EBS_SquareSizeCheck(uint64_t squareSize) {
     return squareSize != 0 && squareSize % 4 == 0 && squareSize < 256;
 }
 
+uint64_t EBS_OptionsDepth(const EBS_Options *options) {
+    return options->depth == 0 ? 1 : options->depth;
+}
+
+bool EBS_DepthCheck(uint64_t depth) {
+    return depth >= 1 && depth <= 4;
+}
+
+bool EBS_ChannelMaskCheck(const EBS_ImageList *imageList, uint64_t channelMask) {
+    if (channelMask == 0) return true;
+    for (uint64_t i = 0; i < imageList->size; ++i) {
+        if (EBS_ChannelCount(imageList->images[i].channel, channelMask) == 0) return false;
+    }
+    return true;
+}
+
 bool EBS_ImageCheck(const EBS_Image *image) {
-    return image->width != 0 && image->height != 0 && image->channel != 0 && image->pixels != NULL;
+    // squares are numbered in 32 bits, the smallest square size gives the most of them
+    const uint64_t squareWidth = image->width / 4, squareHeight = image->height / 4;
+    // the channels of 16-bit samples are read as twice as many channels of bytes, which masks have to cover
+    return image->width != 0 && image->height != 0 && image->channel != 0 && image->pixels != NULL &&
+           (image->sampleBits == 0 || image->sampleBits == 8 || (image->sampleBits == 16 && image->channel <= 32)) &&
+           (image->stride == 0 || image->stride >= EBS_ImageRowSize(image)) &&
+           (squareHeight == 0 || squareWidth <= UINT32_MAX / squareHeight);
+}
+
+EBS_Image EBS_ImageView(const EBS_Image *image, uint64_t x, uint64_t y, uint64_t width, uint64_t height,
+                        int *errorCode) {
+    EBS_Image view = {
+            .width = 0,
+            .height = 0,
+            .channel = 0,
+            .pixels = NULL,
+            .stride = 0,
+            .sampleBits = 0
+    };
+    if (!EBS_ImageCheck(image) || width == 0 || height == 0 || x > image->width || width > image->width - x ||
+        y > image->height || height > image->height - y) {
+        *errorCode = EBS_ErrorInvalidImage;
+        return view;
+    }
+
+    // the rows keep the stride of the image, a view of a view is a view of the same pixels
+    const uint64_t stride = EBS_ImageStride(image);
+    view.width = width;
+    view.height = height;
+    view.channel = image->channel;
+    view.pixels = image->pixels + y * stride + x * image->channel * EBS_ImageSampleSize(image);
+    view.stride = stride;
+    view.sampleBits = image->sampleBits;
+    *errorCode = EBS_OK;
+    return view;
 }
 
 bool EBS_ImageListCheck(const EBS_ImageList *imageList) {
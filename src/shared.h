@@ -1,16 +1,66 @@
 #pragma once
 
 #include "../include/EBS/EBS.h"
+#include "histogram.h"
 
 #include <stddef.h>
 #include <stdbool.h>
 
+// orders every square of a list, with fewer only the highest squares are moved to the front in order
+#define EBS_SQUARE_LIST_ORDER_ALL UINT64_MAX
+
+// a square packed in one word, the entropy inverted in the high half and the row-major index of the square in its
+// image in the low half, so that ascending keys put the highest entropy first and equal entropies in row-major order
 typedef struct EBS_Square {
-    uint64_t x;
-    uint64_t y;
-    double entropy;
+    uint64_t key;
 } EBS_Square;
 
+static inline EBS_Square EBS_SquareMake(uint32_t entropy, uint64_t index) {
+    return (EBS_Square) {(uint64_t) (uint32_t) ~entropy << 32 | index};
+}
+
+static inline uint32_t EBS_SquareEntropy(EBS_Square square) {
+    return (uint32_t) ~(square.key >> 32);
+}
+
+static inline uint64_t EBS_SquareIndex(EBS_Square square) {
+    return (uint32_t) square.key;
+}
+
+// the bytes of a sample
+static inline uint64_t EBS_ImageSampleSize(const EBS_Image *image) {
+    return image->sampleBits == 16 ? 2 : 1;
+}
+
+// the bytes of the pixels of a row, without the padding a stride may add
+static inline uint64_t EBS_ImageRowSize(const EBS_Image *image) {
+    return image->width * image->channel * EBS_ImageSampleSize(image);
+}
+
+// the stride of the rows, which the packed rows of an image without one have too
+static inline uint64_t EBS_ImageStride(const EBS_Image *image) {
+    return image->stride != 0 ? image->stride : EBS_ImageRowSize(image);
+}
+
+// the image read as 8-bit samples, each byte of a 16-bit sample becoming a channel of its own
+static inline EBS_Image EBS_ImageBytes(const EBS_Image *image) {
+    EBS_Image bytes = *image;
+    bytes.channel = image->channel * EBS_ImageSampleSize(image);
+    bytes.stride = EBS_ImageStride(image);
+    bytes.sampleBits = 0;
+    return bytes;
+}
+
+// the top left pixel of a square
+
+static inline uint64_t EBS_SquareX(EBS_Square square, const EBS_Image *image, uint64_t squareSize) {
+    return EBS_SquareIndex(square) % (image->width / squareSize) * squareSize;
+}
+
+static inline uint64_t EBS_SquareY(EBS_Square square, const EBS_Image *image, uint64_t squareSize) {
+    return EBS_SquareIndex(square) / (image->width / squareSize) * squareSize;
+}
+
 typedef struct EBS_SquareList {
     uint64_t size;
     uint64_t squareCapacity;
@@ -25,28 +75,108 @@ typedef struct EBS_ComputedImage {
 typedef struct EBS_ComputedImageList {
     uint64_t size;
     EBS_ComputedImage *computedImages;
+    // the squares of every list, one after another
+    EBS_Square *squares;
+    // allocates the lists, in its arenas when they are only needed for one call
+    EBS_Context *context;
+    bool scratch;
 } EBS_ComputedImageList;
 
-void EBS_SquareCalcEntropy(const EBS_Image *image, EBS_Square *square, uint64_t squareSize);
+typedef struct EBS_SquareMergeNode {
+    uint64_t computedImageIndex;
+    uint32_t entropy;
+} EBS_SquareMergeNode;
+
+typedef struct EBS_SquarePiece {
+    uint64_t computedImageIndex;
+    const EBS_Square *square;
+    uint64_t offset;
+    uint64_t size;
+} EBS_SquarePiece;
+
+typedef struct EBS_SquareMerge {
+    const EBS_ComputedImageList *computedImageList;
+    uint64_t *squareIndex;
+    EBS_SquareMergeNode *heap;
+    uint64_t heapSize;
+} EBS_SquareMerge;
+
+void EBS_SquareCalcEntropy(const EBS_Image *image, EBS_Square *square, uint64_t squareSize, uint64_t depth,
+                           uint64_t channelMask, const uint64_t *entropyTable);
 
 int EBS_SquareCompare(const void *square1, const void *square2);
 
-EBS_SquareList EBS_SquareListCreate(const EBS_Image *image, uint64_t squareSize);
+EBS_SquareList EBS_SquareListShape(const EBS_Image *image, uint64_t squareSize, uint64_t depth,
+                                   uint64_t channelMask);
+
+EBS_SquareList EBS_SquareListInit(const EBS_Image *image, uint64_t squareSize, uint64_t depth,
+                                  uint64_t channelMask);
+
+uint64_t EBS_SquareListScratchSize(const EBS_Image *image, uint64_t squareSize, uint64_t channelMask);
+
+void EBS_SquareListCalc(const EBS_Image *image, EBS_SquareList *squareList, uint64_t squareSize, uint64_t depth,
+                        uint64_t channelMask, uint64_t bandBegin, uint64_t bandEnd, uint16_t (*scratch)[EBS_HISTOGRAM_BINS],
+                        const uint64_t *entropyTable);
+
+bool EBS_SquareListSort(EBS_SquareList *squareList, EBS_Square *buffer);
+
+bool EBS_SquareListOrder(EBS_SquareList *squareList, uint64_t squareLimit, EBS_Square *buffer);
+
+uint64_t EBS_SquareListFindMax(const EBS_SquareList *squareList);
+
+EBS_SquareList EBS_SquareListCreate(const EBS_Image *image, uint64_t squareSize, uint64_t depth,
+                                    uint64_t channelMask);
 
 void EBS_SquareListFree(EBS_SquareList *squareList);
 
+void EBS_ImageRead(const EBS_Image *image, uint64_t offset, uint8_t *buffer, uint64_t size);
+
 int EBS_ImageCompare(const void *image1, const void *image2);
 
-EBS_ComputedImageList EBS_ComputedImageListCreate(EBS_ImageList *imageList, uint64_t squareSize);
+EBS_ComputedImageList EBS_ComputedImageListCreate(EBS_ImageList *imageList, const EBS_Options *options,
+                                                  uint64_t squareLimit);
+
+EBS_ComputedImageList EBS_ComputedImageListCreateOwned(EBS_ImageList *imageList, const EBS_Options *options,
+                                                       uint64_t squareLimit);
+
+bool EBS_ComputedImageListOrder(EBS_ComputedImageList *computedImageList, uint64_t squareLimit,
+                                uint64_t threadCount);
 
 void EBS_ComputedImageListFree(EBS_ComputedImageList *computedImageList);
 
 uint64_t EBS_ComputedImageListFindMaxEntropy(const EBS_ComputedImageList *computedImageList, const uint64_t *squareIndex);
 
-uint64_t EBS_ComputedImageListCalcCapacity(const EBS_ComputedImageList *computedImageList);
+bool EBS_SquareMergeInit(EBS_SquareMerge *squareMerge, const EBS_ComputedImageList *computedImageList);
+
+uint64_t EBS_SquareMergeTop(const EBS_SquareMerge *squareMerge);
+
+void EBS_SquareMergePop(EBS_SquareMerge *squareMerge);
+
+void EBS_SquareMergeFree(EBS_SquareMerge *squareMerge);
+
+EBS_SquarePiece *EBS_SquarePiecesCreate(const EBS_ComputedImageList *computedImageList, uint64_t headerSize,
+                                        uint64_t messageSize, uint64_t *pieceCount);
+
+uint64_t EBS_SquarePiecesPerTask(uint64_t pieceCount, uint64_t messageSize);
+
+void EBS_SquarePiecesBytes(const EBS_SquarePiece *pieces, uint64_t pieceCount, uint64_t piecesPerTask,
+                           uint64_t taskBegin, uint64_t taskEnd, uint64_t *begin, uint64_t *end);
+
+uint64_t EBS_HeaderSize(bool checksum);
+
+uint64_t EBS_MessageSquareCount(const EBS_ImageList *imageList, uint64_t squareSize, uint64_t depth,
+                                uint64_t channelMask, uint64_t messageSize);
+
+uint64_t EBS_ComputedImageListCalcCapacity(const EBS_ComputedImageList *computedImageList, bool checksum);
 
 bool EBS_SquareSizeCheck(uint64_t squareSize);
 
+uint64_t EBS_OptionsDepth(const EBS_Options *options);
+
+bool EBS_DepthCheck(uint64_t depth);
+
+bool EBS_ChannelMaskCheck(const EBS_ImageList *imageList, uint64_t channelMask);
+
 bool EBS_ImageCheck(const EBS_Image *image);
 
 bool EBS_ImageListCheck(const EBS_ImageList *imageList);
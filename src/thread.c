@@ -0,0 +1,345 @@
+#if !defined(_WIN32)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "thread.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "context.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+typedef struct EBS_ParallelState {
+    EBS_TaskFunction function;
+    void *context;
+    uint64_t taskCount;
+    uint64_t nextTask;
+} EBS_ParallelState;
+
+typedef struct EBS_Worker {
+    EBS_ParallelState *state;
+    uint64_t index;
+    // the pool the worker waits in for loops, NULL for a worker started for one loop
+    EBS_ThreadPool *pool;
+    uint64_t job;
+#if defined(_WIN32)
+    HANDLE handle;
+#else
+    pthread_t handle;
+#endif
+} EBS_Worker;
+
+struct EBS_ThreadPool {
+#if defined(_WIN32)
+    CRITICAL_SECTION lock;
+    CONDITION_VARIABLE wake;
+    CONDITION_VARIABLE done;
+#else
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_cond_t done;
+#endif
+    // the threads of the pool, worker 0 being the calling thread it isn't one of them
+    EBS_Worker *workers;
+    uint64_t size;
+    // bumped for every loop, so that a waking worker knows whether it's a new one
+    uint64_t job;
+    EBS_ParallelState *state;
+    uint64_t workerCount;
+    uint64_t running;
+    bool stopping;
+};
+
+static uint64_t EBS_NextTask(EBS_ParallelState *state) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    return (uint64_t) _InterlockedExchangeAdd64((volatile long long *) &state->nextTask, 1);
+#else
+    return __atomic_fetch_add(&state->nextTask, 1, __ATOMIC_RELAXED);
+#endif
+}
+
+static void EBS_WorkerRun(EBS_Worker *worker) {
+    EBS_ParallelState *state = worker->state;
+    for (uint64_t task = EBS_NextTask(state); task < state->taskCount; task = EBS_NextTask(state)) {
+        state->function(state->context, task, worker->index);
+    }
+}
+
+#if defined(_WIN32)
+
+static bool EBS_PoolInit(EBS_ThreadPool *pool) {
+    InitializeCriticalSection(&pool->lock);
+    InitializeConditionVariable(&pool->wake);
+    InitializeConditionVariable(&pool->done);
+    return true;
+}
+
+static void EBS_PoolDestroy(EBS_ThreadPool *pool) {
+    DeleteCriticalSection(&pool->lock);
+}
+
+static void EBS_PoolLock(EBS_ThreadPool *pool) {
+    EnterCriticalSection(&pool->lock);
+}
+
+static void EBS_PoolUnlock(EBS_ThreadPool *pool) {
+    LeaveCriticalSection(&pool->lock);
+}
+
+static void EBS_PoolWait(EBS_ThreadPool *pool, CONDITION_VARIABLE *condition) {
+    SleepConditionVariableCS(condition, &pool->lock, INFINITE);
+}
+
+static void EBS_PoolSignal(CONDITION_VARIABLE *condition) {
+    WakeConditionVariable(condition);
+}
+
+static void EBS_PoolBroadcast(CONDITION_VARIABLE *condition) {
+    WakeAllConditionVariable(condition);
+}
+
+#else
+
+static bool EBS_PoolInit(EBS_ThreadPool *pool) {
+    if (pthread_mutex_init(&pool->lock, NULL) != 0) return false;
+    if (pthread_cond_init(&pool->wake, NULL) != 0) {
+        pthread_mutex_destroy(&pool->lock);
+        return false;
+    }
+    if (pthread_cond_init(&pool->done, NULL) != 0) {
+        pthread_cond_destroy(&pool->wake);
+        pthread_mutex_destroy(&pool->lock);
+        return false;
+    }
+    return true;
+}
+
+static void EBS_PoolDestroy(EBS_ThreadPool *pool) {
+    pthread_cond_destroy(&pool->done);
+    pthread_cond_destroy(&pool->wake);
+    pthread_mutex_destroy(&pool->lock);
+}
+
+static void EBS_PoolLock(EBS_ThreadPool *pool) {
+    pthread_mutex_lock(&pool->lock);
+}
+
+static void EBS_PoolUnlock(EBS_ThreadPool *pool) {
+    pthread_mutex_unlock(&pool->lock);
+}
+
+static void EBS_PoolWait(EBS_ThreadPool *pool, pthread_cond_t *condition) {
+    pthread_cond_wait(condition, &pool->lock);
+}
+
+static void EBS_PoolSignal(pthread_cond_t *condition) {
+    pthread_cond_signal(condition);
+}
+
+static void EBS_PoolBroadcast(pthread_cond_t *condition) {
+    pthread_cond_broadcast(condition);
+}
+
+#endif
+
+// a worker of a pool runs every loop it takes part in until the pool stops
+static void EBS_PoolWorkerRun(EBS_Worker *worker) {
+    EBS_ThreadPool *pool = worker->pool;
+    EBS_PoolLock(pool);
+    while (true) {
+        while (!pool->stopping && pool->job == worker->job) {
+            EBS_PoolWait(pool, &pool->wake);
+        }
+        if (pool->stopping) break;
+        worker->job = pool->job;
+        if (worker->index >= pool->workerCount) continue;
+
+        worker->state = pool->state;
+        EBS_PoolUnlock(pool);
+        EBS_WorkerRun(worker);
+        EBS_PoolLock(pool);
+        if (--pool->running == 0) EBS_PoolSignal(&pool->done);
+    }
+    EBS_PoolUnlock(pool);
+}
+
+static void EBS_WorkerMainRun(EBS_Worker *worker) {
+    if (worker->pool == NULL) {
+        EBS_WorkerRun(worker);
+    } else {
+        EBS_PoolWorkerRun(worker);
+    }
+}
+
+#if defined(_WIN32)
+
+static DWORD WINAPI EBS_WorkerMain(LPVOID worker) {
+    EBS_WorkerMainRun((EBS_Worker *) worker);
+    return 0;
+}
+
+static bool EBS_WorkerStart(EBS_Worker *worker) {
+    worker->handle = CreateThread(NULL, 0, EBS_WorkerMain, worker, 0, NULL);
+    return worker->handle != NULL;
+}
+
+static void EBS_WorkerJoin(EBS_Worker *worker) {
+    WaitForSingleObject(worker->handle, INFINITE);
+    CloseHandle(worker->handle);
+}
+
+uint64_t EBS_HardwareConcurrency(void) {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? info.dwNumberOfProcessors : 1;
+}
+
+#else
+
+static void *EBS_WorkerMain(void *worker) {
+    EBS_WorkerMainRun((EBS_Worker *) worker);
+    return NULL;
+}
+
+static bool EBS_WorkerStart(EBS_Worker *worker) {
+    return pthread_create(&worker->handle, NULL, EBS_WorkerMain, worker) == 0;
+}
+
+static void EBS_WorkerJoin(EBS_Worker *worker) {
+    pthread_join(worker->handle, NULL);
+}
+
+uint64_t EBS_HardwareConcurrency(void) {
+    const long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (uint64_t) count : 1;
+}
+
+#endif
+
+uint64_t EBS_ParallelWorkers(uint64_t threadCount, uint64_t taskCount) {
+    if (threadCount == 0) threadCount = EBS_HardwareConcurrency();
+    if (threadCount > taskCount) threadCount = taskCount;
+    return threadCount == 0 ? 1 : threadCount;
+}
+
+static void EBS_ThreadPoolStop(EBS_ThreadPool *pool) {
+    if (pool->size == 0) return;
+    EBS_PoolLock(pool);
+    pool->stopping = true;
+    EBS_PoolBroadcast(&pool->wake);
+    EBS_PoolUnlock(pool);
+    for (uint64_t i = 0; i < pool->size; ++i) {
+        EBS_WorkerJoin(pool->workers + i);
+    }
+    pool->size = 0;
+    pool->stopping = false;
+}
+
+// the pool of a context with at least threadCount threads when they could be started, NULL when it couldn't be made
+static EBS_ThreadPool *EBS_ThreadPoolGet(EBS_Context *context, uint64_t threadCount) {
+    EBS_ThreadPool *pool = context->pool;
+    if (pool == NULL) {
+        pool = (EBS_ThreadPool *) EBS_Allocate(context, sizeof(EBS_ThreadPool));
+        if (pool == NULL) return NULL;
+        if (!EBS_PoolInit(pool)) {
+            EBS_Deallocate(context, pool);
+            return NULL;
+        }
+        pool->workers = NULL;
+        pool->size = 0;
+        pool->job = 0;
+        pool->state = NULL;
+        pool->workerCount = 0;
+        pool->running = 0;
+        pool->stopping = false;
+        context->pool = pool;
+    }
+    if (threadCount <= pool->size) return pool;
+
+    // the threads hold on to their place in the array, so they are stopped while it grows and started again
+    EBS_ThreadPoolStop(pool);
+    pool->workers = (EBS_Worker *) EBS_ScratchGet(context, EBS_SCRATCH_WORKERS, threadCount * sizeof(EBS_Worker));
+    if (pool->workers == NULL) return pool;
+    for (uint64_t i = 0; i < threadCount; ++i) {
+        pool->workers[i] = (EBS_Worker) {.index = i + 1, .pool = pool, .job = pool->job};
+        if (!EBS_WorkerStart(pool->workers + i)) break;
+        pool->size = i + 1;
+    }
+    return pool;
+}
+
+void EBS_ThreadPoolFree(EBS_Context *context) {
+    EBS_ThreadPool *pool = context->pool;
+    if (pool == NULL) return;
+    EBS_ThreadPoolStop(pool);
+    EBS_PoolDestroy(pool);
+    EBS_Deallocate(context, pool);
+    context->pool = NULL;
+}
+
+// runs the loop on the threads of the pool, false when there's no pool to run it on
+static bool EBS_ThreadPoolRun(EBS_Context *context, uint64_t workerCount, EBS_ParallelState *state) {
+    EBS_ThreadPool *pool = EBS_ThreadPoolGet(context, workerCount - 1);
+    if (pool == NULL) return false;
+    if (workerCount > pool->size + 1) workerCount = pool->size + 1;
+
+    if (workerCount > 1) {
+        EBS_PoolLock(pool);
+        pool->state = state;
+        pool->workerCount = workerCount;
+        pool->running = workerCount - 1;
+        ++pool->job;
+        EBS_PoolBroadcast(&pool->wake);
+        EBS_PoolUnlock(pool);
+    }
+
+    EBS_Worker self = {.state = state, .index = 0};
+    EBS_WorkerRun(&self);
+
+    if (workerCount > 1) {
+        EBS_PoolLock(pool);
+        while (pool->running != 0) {
+            EBS_PoolWait(pool, &pool->done);
+        }
+        EBS_PoolUnlock(pool);
+    }
+    return true;
+}
+
+void EBS_ParallelFor(EBS_Context *context, uint64_t threadCount, uint64_t taskCount, EBS_TaskFunction function,
+                     void *taskContext) {
+    EBS_ParallelState state = {
+            .function = function,
+            .context = taskContext,
+            .taskCount = taskCount,
+            .nextTask = 0
+    };
+    const uint64_t workerCount = EBS_ParallelWorkers(threadCount, taskCount);
+    // a context keeps its threads, so that the loops of later calls don't start any
+    if (workerCount > 1 && context != NULL && EBS_ThreadPoolRun(context, workerCount, &state)) return;
+
+    // the calling thread is worker 0, a worker that fails to start just leaves its share to the others
+    EBS_Worker *workers = workerCount > 1 ? (EBS_Worker *) calloc(workerCount, sizeof(EBS_Worker)) : NULL;
+    uint64_t started = 1;
+    if (workers != NULL) {
+        for (; started < workerCount; ++started) {
+            workers[started] = (EBS_Worker) {.state = &state, .index = started};
+            if (!EBS_WorkerStart(workers + started)) break;
+        }
+    }
+
+    EBS_Worker self = {.state = &state, .index = 0};
+    EBS_WorkerRun(&self);
+
+    for (uint64_t i = 1; i < started; ++i) {
+        EBS_WorkerJoin(workers + i);
+    }
+    free(workers);
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <inttypes.h>
+
+#include "../include/EBS/EBS.h"
+
+// the threads a context keeps between calls, waiting for the next loop
+typedef struct EBS_ThreadPool EBS_ThreadPool;
+
+typedef void (*EBS_TaskFunction)(void *context, uint64_t task, uint64_t worker);
+
+uint64_t EBS_HardwareConcurrency(void);
+
+uint64_t EBS_ParallelWorkers(uint64_t threadCount, uint64_t taskCount);
+
+void EBS_ParallelFor(EBS_Context *context, uint64_t threadCount, uint64_t taskCount, EBS_TaskFunction function,
+                     void *taskContext);
+
+void EBS_ThreadPoolFree(EBS_Context *context);
@@ -0,0 +1,87 @@
+#include "channel_tests.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "unity/unity.h"
+#include "channel.h"
+
+#define TEST_PIXELS 40
+
+static void randomBytes(uint8_t *bytes, uint64_t size) {
+    for (uint64_t i = 0; i < size; ++i) {
+        bytes[i] = (uint8_t) rand();
+    }
+}
+
+static void checkKernels(EBS_ChannelPackKernel pack, EBS_ChannelUnpackKernel unpack, uint64_t channel,
+                         uint64_t channelMask) {
+    const uint64_t selected = EBS_ChannelCount(channel, channelMask);
+    uint8_t pixels[TEST_PIXELS * 8], expected[TEST_PIXELS * 8], packed[TEST_PIXELS * 8 + 1];
+    uint8_t values[TEST_PIXELS * 8];
+
+    for (uint64_t pixelCount = 0; pixelCount <= TEST_PIXELS; ++pixelCount) {
+        randomBytes(pixels, sizeof(pixels));
+        randomBytes(values, sizeof(values));
+
+        // the selected bytes in pixel order, nothing written past them
+        packed[pixelCount * selected] = 0xa5;
+        pack(packed, pixels, pixelCount, channel, channelMask);
+        uint64_t next = 0;
+        for (uint64_t i = 0; i < pixelCount * channel; ++i) {
+            if (channelMask >> (i % channel) & 1) TEST_ASSERT_EQUAL(pixels[i], packed[next++]);
+        }
+        TEST_ASSERT_EQUAL(0xa5, packed[pixelCount * selected]);
+
+        // unpacking only writes the selected channels of the pixels given
+        memcpy(expected, pixels, sizeof(pixels));
+        next = 0;
+        for (uint64_t i = 0; i < pixelCount * channel; ++i) {
+            if (channelMask >> (i % channel) & 1) expected[i] = values[next++];
+        }
+        unpack(pixels, values, pixelCount, channel, channelMask);
+        TEST_ASSERT_EQUAL_MEMORY(expected, pixels, sizeof(pixels));
+    }
+}
+
+void test_ChannelCount(void) {
+    TEST_ASSERT_EQUAL(4, EBS_ChannelCount(4, 0));
+    TEST_ASSERT_EQUAL(4, EBS_ChannelCount(4, 0xff));
+    TEST_ASSERT_EQUAL(3, EBS_ChannelCount(4, 0x7));
+    TEST_ASSERT_EQUAL(1, EBS_ChannelCount(3, 0x9));
+    TEST_ASSERT_EQUAL(0, EBS_ChannelCount(2, 0x4));
+    TEST_ASSERT_EQUAL(64, EBS_ChannelCount(70, UINT64_MAX));
+
+    // masks covering every channel are the same as no mask
+    TEST_ASSERT_EQUAL(0, EBS_ChannelMaskResolve(4, 0));
+    TEST_ASSERT_EQUAL(0, EBS_ChannelMaskResolve(4, 0xf));
+    TEST_ASSERT_EQUAL(0, EBS_ChannelMaskResolve(3, 0xff));
+    TEST_ASSERT_EQUAL(0x7, EBS_ChannelMaskResolve(4, 0xf7));
+    TEST_ASSERT_EQUAL(UINT64_MAX, EBS_ChannelMaskResolve(70, UINT64_MAX));
+}
+
+void test_ChannelPackKernels(void) {
+    const uint32_t features = EBS_CpuFeatures();
+
+    checkKernels(EBS_ChannelPackScalar, EBS_ChannelUnpackScalar, 4, 0x7);
+    checkKernels(EBS_ChannelPackScalar, EBS_ChannelUnpackScalar, 4, 0xa);
+    checkKernels(EBS_ChannelPackScalar, EBS_ChannelUnpackScalar, 3, 0x5);
+    checkKernels(EBS_ChannelPackScalar, EBS_ChannelUnpackScalar, 7, 0x4d);
+    checkKernels(EBS_ChannelPackRGBScalar, EBS_ChannelUnpackRGBScalar, 4, 0x7);
+#if EBS_X86_64
+    if (features & EBS_CpuSSE42) checkKernels(EBS_ChannelPackRGBSSE42, EBS_ChannelUnpackRGBSSE42, 4, 0x7);
+#endif
+    (void) features;
+}
+
+void test_ChannelKernelSelect(void) {
+    TEST_ASSERT(EBS_ChannelPackKernelSelect(0, 4, 0x7) == EBS_ChannelPackRGBScalar);
+    TEST_ASSERT(EBS_ChannelUnpackKernelSelect(0, 4, 0x7) == EBS_ChannelUnpackRGBScalar);
+    TEST_ASSERT(EBS_ChannelPackKernelSelect(0, 4, 0xb) == EBS_ChannelPackScalar);
+    TEST_ASSERT(EBS_ChannelUnpackKernelSelect(0, 3, 0x3) == EBS_ChannelUnpackScalar);
+#if EBS_X86_64
+    TEST_ASSERT(EBS_ChannelPackKernelSelect(EBS_CpuSSE42, 4, 0x7) == EBS_ChannelPackRGBSSE42);
+    TEST_ASSERT(EBS_ChannelUnpackKernelSelect(EBS_CpuSSE42, 4, 0xf7) == EBS_ChannelUnpackRGBSSE42);
+    TEST_ASSERT(EBS_ChannelPackKernelSelect(EBS_CpuSSE42, 5, 0x7) == EBS_ChannelPackScalar);
+#endif
+}
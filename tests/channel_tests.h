@@ -0,0 +1,7 @@
+#pragma once
+
+void test_ChannelCount(void);
+
+void test_ChannelPackKernels(void);
+
+void test_ChannelKernelSelect(void);
@@ -0,0 +1,110 @@
+#include "cipher_tests.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "unity/unity.h"
+#include "cipher.h"
+
+static void randomBytes(uint8_t *bytes, uint64_t size) {
+    for (uint64_t i = 0; i < size; ++i) {
+        bytes[i] = (uint8_t) rand();
+    }
+}
+
+void test_CipherVector(void) {
+    // the encryption example of RFC 8439, section 2.4.2, which starts at block 1
+    uint8_t key[EBS_CIPHER_KEY];
+    for (uint64_t i = 0; i < sizeof(key); ++i) {
+        key[i] = (uint8_t) i;
+    }
+    const uint8_t nonce[EBS_CIPHER_NONCE] = {0, 0, 0, 0, 0, 0, 0, 0x4a, 0, 0, 0, 0};
+    const char *plaintext = "Ladies and Gentlemen of the class of '99: If I could offer you only one tip for the "
+                            "future, sunscreen would be it.";
+    const uint8_t expected[] = {
+            0x6e, 0x2e, 0x35, 0x9a, 0x25, 0x68, 0xf9, 0x80, 0x41, 0xba, 0x07, 0x28, 0xdd, 0x0d, 0x69, 0x81,
+            0xe9, 0x7e, 0x7a, 0xec, 0x1d, 0x43, 0x60, 0xc2, 0x0a, 0x27, 0xaf, 0xcc, 0xfd, 0x9f, 0xae, 0x0b,
+            0xf9, 0x1b, 0x65, 0xc5, 0x52, 0x47, 0x33, 0xab, 0x8f, 0x59, 0x3d, 0xab, 0xcd, 0x62, 0xb3, 0x57,
+            0x16, 0x39, 0xd6, 0x24, 0xe6, 0x51, 0x52, 0xab, 0x8f, 0x53, 0x0c, 0x35, 0x9f, 0x08, 0x61, 0xd8,
+            0x07, 0xca, 0x0d, 0xbf, 0x50, 0x0d, 0x6a, 0x61, 0x56, 0xa3, 0x8e, 0x08, 0x8a, 0x22, 0xb6, 0x5e,
+            0x52, 0xbc, 0x51, 0x4d, 0x16, 0xcc, 0xf8, 0x06, 0x81, 0x8c, 0xe9, 0x1a, 0xb7, 0x79, 0x37, 0x36,
+            0x5a, 0xf9, 0x0b, 0xbf, 0x74, 0xa3, 0x5b, 0xe6, 0xb4, 0x0b, 0x8e, 0xed, 0xf2, 0x78, 0x5e, 0x42,
+            0x87, 0x4d
+    };
+    TEST_ASSERT_EQUAL(sizeof(expected), strlen(plaintext));
+
+    EBS_Cipher cipher;
+    EBS_CipherInit(&cipher, key, nonce);
+    EBS_CipherStream stream;
+    EBS_CipherStreamInit(&stream, &cipher);
+    uint8_t output[sizeof(expected)];
+    EBS_CipherApply(&stream, EBS_CIPHER_BLOCK, output, (const uint8_t *) plaintext, sizeof(output));
+    TEST_ASSERT_EQUAL_MEMORY(expected, output, sizeof(output));
+
+    // the same keystream decrypts in place
+    EBS_CipherApply(&stream, EBS_CIPHER_BLOCK, output, output, sizeof(output));
+    TEST_ASSERT_EQUAL_MEMORY(plaintext, output, sizeof(output));
+}
+
+void test_CipherKernels(void) {
+    uint8_t key[EBS_CIPHER_KEY], nonce[EBS_CIPHER_NONCE];
+    randomBytes(key, sizeof(key));
+    randomBytes(nonce, sizeof(nonce));
+    EBS_Cipher cipher;
+    EBS_CipherInit(&cipher, key, nonce);
+
+    // every kernel gives the blocks of the scalar one, also where the counter carries past 32 bits
+    const EBS_CipherKernel kernels[] = {
+            EBS_CipherBlocksScalar,
+#if EBS_X86_64
+            EBS_CipherBlocksSSE2,
+#endif
+            EBS_CipherKernelGet()
+    };
+    const uint64_t blocks[] = {0, 1, 77, 0xfffffffeull, 0x1fffffffdull};
+    for (uint64_t k = 0; k < sizeof(kernels) / sizeof(kernels[0]); ++k) {
+        for (uint64_t b = 0; b < sizeof(blocks) / sizeof(blocks[0]); ++b) {
+            uint8_t expected[EBS_CIPHER_BLOCKS * EBS_CIPHER_BLOCK + 1], keystream[sizeof(expected)];
+            memset(expected, 0xa5, sizeof(expected));
+            memset(keystream, 0xa5, sizeof(keystream));
+            for (uint64_t i = 0; i < EBS_CIPHER_BLOCKS; ++i) {
+                uint8_t block[EBS_CIPHER_BLOCKS * EBS_CIPHER_BLOCK];
+                EBS_CipherBlocksScalar(cipher.state, blocks[b] + i, block);
+                memcpy(expected + i * EBS_CIPHER_BLOCK, block, EBS_CIPHER_BLOCK);
+            }
+            kernels[k](cipher.state, blocks[b], keystream);
+            TEST_ASSERT_EQUAL_MEMORY(expected, keystream, sizeof(keystream));
+        }
+    }
+    TEST_ASSERT_TRUE(EBS_CipherKernelSelect(EBS_CpuFeatures()) == EBS_CipherKernelGet());
+}
+
+void test_CipherApply(void) {
+    uint8_t key[EBS_CIPHER_KEY], nonce[EBS_CIPHER_NONCE];
+    randomBytes(key, sizeof(key));
+    randomBytes(nonce, sizeof(nonce));
+    EBS_Cipher cipher;
+    EBS_CipherInit(&cipher, key, nonce);
+    EBS_CipherStream stream;
+    EBS_CipherStreamInit(&stream, &cipher);
+
+    static uint8_t data[3000], whole[3000], pieces[3000];
+    randomBytes(data, sizeof(data));
+    EBS_CipherApply(&stream, 5, whole, data, sizeof(data));
+
+    // pieces encrypted on their own, last first, by fresh streams or by the one kept, give the bytes of the whole
+    for (int round = 0; round < 20; ++round) {
+        uint64_t cuts[sizeof(data) + 1], cutCount = 0;
+        for (uint64_t cut = 0; cut < sizeof(data); cut += 1 + (uint64_t) rand() % 300) {
+            cuts[cutCount++] = cut;
+        }
+        cuts[cutCount] = sizeof(data);
+        memset(pieces, 0, sizeof(pieces));
+        for (uint64_t i = cutCount; i-- > 0;) {
+            if (round % 2 == 0) EBS_CipherStreamInit(&stream, &cipher);
+            EBS_CipherApply(&stream, 5 + cuts[i], pieces + cuts[i], data + cuts[i], cuts[i + 1] - cuts[i]);
+        }
+        TEST_ASSERT_EQUAL_MEMORY(whole, pieces, sizeof(pieces));
+    }
+    TEST_ASSERT_NULL(EBS_CipherStreamInit(&stream, NULL));
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+void test_CipherVector(void);
+
+void test_CipherKernels(void);
+
+void test_CipherApply(void);
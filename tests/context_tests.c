@@ -0,0 +1,241 @@
+#include "context_tests.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "unity/unity.h"
+#include "context.h"
+#include "index.h"
+
+#define CONTEXT_TEST_PIXELS (48 * 40 * 3 + 32 * 32 * 4)
+
+typedef struct CountingAllocator {
+    uint64_t allocations;
+    uint64_t deallocations;
+} CountingAllocator;
+
+static void *countingAllocate(void *user, uint64_t size) {
+    ++((CountingAllocator *) user)->allocations;
+    return malloc(size);
+}
+
+static void countingDeallocate(void *user, void *pointer) {
+    ++((CountingAllocator *) user)->deallocations;
+    free(pointer);
+}
+
+static EBS_Allocator countingAllocator(CountingAllocator *counts) {
+    *counts = (CountingAllocator) {0, 0};
+    return (EBS_Allocator) {
+            .allocate = countingAllocate,
+            .allocateAligned = NULL,
+            .deallocate = countingDeallocate,
+            .user = counts
+    };
+}
+
+static void fillContextImages(EBS_Image images[2], uint8_t *pixels) {
+    for (uint64_t i = 0; i < CONTEXT_TEST_PIXELS; ++i) {
+        pixels[i] = (uint8_t) rand();
+    }
+    images[0] = (EBS_Image) {.width = 48, .height = 40, .channel = 3, .pixels = pixels};
+    images[1] = (EBS_Image) {.width = 32, .height = 32, .channel = 4, .pixels = pixels + 48 * 40 * 3};
+}
+
+void test_ContextCreate(void) {
+    int errorCode;
+    EBS_Context *context = EBS_ContextCreate(NULL, &errorCode);
+    TEST_ASSERT_NOT_NULL(context);
+    TEST_ASSERT_EQUAL(EBS_OK, errorCode);
+    EBS_ContextFree(context);
+    EBS_ContextFree(NULL);
+
+    CountingAllocator counts;
+    const EBS_Allocator allocator = countingAllocator(&counts);
+    context = EBS_ContextCreate(&allocator, &errorCode);
+    TEST_ASSERT_NOT_NULL(context);
+
+    // arenas keep their memory and only grow
+    void *arena = EBS_ScratchGet(context, EBS_SCRATCH_SORT, 100);
+    TEST_ASSERT_NOT_NULL(arena);
+    TEST_ASSERT_EQUAL(0, (uintptr_t) arena % sizeof(uint64_t));
+    EBS_ScratchRelease(context, arena);
+    TEST_ASSERT(EBS_ScratchGet(context, EBS_SCRATCH_SORT, 50) == arena);
+    TEST_ASSERT_EQUAL(2, counts.allocations);
+    TEST_ASSERT_NOT_NULL(EBS_ScratchGet(context, EBS_SCRATCH_SORT, 1000));
+    TEST_ASSERT_EQUAL(3, counts.allocations);
+    TEST_ASSERT_EQUAL(1, counts.deallocations);
+
+    EBS_ContextFree(context);
+    TEST_ASSERT_EQUAL(counts.allocations, counts.deallocations);
+}
+
+void test_ContextReuse(void) {
+    static uint8_t pixels[CONTEXT_TEST_PIXELS], expected[CONTEXT_TEST_PIXELS];
+    EBS_Image images[2];
+    fillContextImages(images, pixels);
+    memcpy(expected, pixels, sizeof(pixels));
+    EBS_Image expectedImages[] = {
+            {.width = 48, .height = 40, .channel = 3, .pixels = expected},
+            {.width = 32, .height = 32, .channel = 4, .pixels = expected + 48 * 40 * 3},
+    };
+    EBS_ImageList imageList = {2, images}, expectedImageList = {2, expectedImages};
+
+    CountingAllocator counts;
+    const EBS_Allocator allocator = countingAllocator(&counts);
+    int errorCode;
+    EBS_Context *context = EBS_ContextCreate(&allocator, &errorCode);
+    TEST_ASSERT_NOT_NULL(context);
+    const EBS_Options options = {
+            .squareSize = 8,
+            .threadCount = 1,
+            .checksum = true
+    };
+    EBS_Options contextOptions = options;
+    contextOptions.context = context;
+
+    // the first message is the largest, the arenas it grows hold every later one
+    uint8_t data[300];
+    uint64_t allocations = 0;
+    for (uint64_t size = sizeof(data); size + 60 > 60; size -= 60) {
+        for (uint64_t i = 0; i < size; ++i) {
+            data[i] = (uint8_t) rand();
+        }
+        const EBS_Message message = {size, data};
+        EBS_MessageEmbedWithOptions(&imageList, &message, &contextOptions, &errorCode);
+        TEST_ASSERT_EQUAL(EBS_OK, errorCode);
+        EBS_MessageEmbedWithOptions(&expectedImageList, &message, &options, &errorCode);
+        TEST_ASSERT_EQUAL(EBS_OK, errorCode);
+        TEST_ASSERT_EQUAL_MEMORY(expected, pixels, sizeof(pixels));
+
+        const EBS_Message extracted = EBS_MessageExtractWithOptions(&imageList, &contextOptions, &errorCode);
+        TEST_ASSERT_EQUAL(EBS_OK, errorCode);
+        TEST_ASSERT_EQUAL(size, extracted.size);
+        TEST_ASSERT_EQUAL_MEMORY(data, extracted.data, size);
+
+        if (size != sizeof(data)) TEST_ASSERT_EQUAL(allocations, counts.allocations);
+        allocations = counts.allocations;
+    }
+    TEST_ASSERT_EQUAL(0, counts.deallocations);
+
+    EBS_ContextFree(context);
+    TEST_ASSERT_EQUAL(counts.allocations, counts.deallocations);
+}
+
+void test_ContextPlan(void) {
+    static uint8_t pixels[CONTEXT_TEST_PIXELS];
+    EBS_Image images[2];
+    fillContextImages(images, pixels);
+    EBS_ImageList imageList = {2, images};
+
+    CountingAllocator counts;
+    const EBS_Allocator allocator = countingAllocator(&counts);
+    int errorCode;
+    EBS_Context *context = EBS_ContextCreate(&allocator, &errorCode);
+    TEST_ASSERT_NOT_NULL(context);
+    const EBS_Options options = {
+            .squareSize = 8,
+            .threadCount = 1,
+            .context = context
+    };
+
+    // the plan keeps its lists out of the arenas, so calls through the same context don't overwrite them
+    EBS_Plan *plan = EBS_PlanCreate(&imageList, &options, &errorCode);
+    TEST_ASSERT_NOT_NULL(plan);
+    uint8_t data[200];
+    for (uint64_t i = 0; i < sizeof(data); ++i) {
+        data[i] = (uint8_t) rand();
+    }
+    const EBS_Message message = {sizeof(data), data};
+    EBS_PlanEmbed(plan, &message, &errorCode);
+    TEST_ASSERT_EQUAL(EBS_OK, errorCode);
+    const EBS_Message extracted = EBS_MessageExtractWithOptions(&imageList, &options, &errorCode);
+    TEST_ASSERT_EQUAL(EBS_OK, errorCode);
+    TEST_ASSERT_EQUAL_MEMORY(data, extracted.data, sizeof(data));
+    const EBS_Message planned = EBS_PlanExtract(plan, &errorCode);
+    TEST_ASSERT_EQUAL(EBS_OK, errorCode);
+    TEST_ASSERT_EQUAL(sizeof(data), planned.size);
+    TEST_ASSERT_EQUAL_MEMORY(data, planned.data, sizeof(data));
+
+    EBS_PlanFree(plan);
+    EBS_ContextFree(context);
+    TEST_ASSERT_EQUAL(counts.allocations, counts.deallocations);
+}
+
+#define CONTEXT_THREAD_IMAGES 4
+#define CONTEXT_THREAD_PIXELS (CONTEXT_THREAD_IMAGES * 512 * 512 * 3)
+
+void test_ContextThreads(void) {
+    static uint8_t pixels[CONTEXT_THREAD_PIXELS], expected[CONTEXT_THREAD_PIXELS];
+    static uint8_t data[200000];
+    for (uint64_t i = 0; i < CONTEXT_THREAD_PIXELS; ++i) {
+        pixels[i] = (uint8_t) rand();
+    }
+    memcpy(expected, pixels, sizeof(pixels));
+    EBS_Image images[CONTEXT_THREAD_IMAGES], expectedImages[CONTEXT_THREAD_IMAGES];
+    for (uint64_t i = 0; i < CONTEXT_THREAD_IMAGES; ++i) {
+        images[i] = (EBS_Image) {.width = 512, .height = 512, .channel = 3, .pixels = pixels + i * 512 * 512 * 3};
+        expectedImages[i] = (EBS_Image) {.width = 512, .height = 512, .channel = 3,
+                                         .pixels = expected + i * 512 * 512 * 3};
+    }
+    EBS_ImageList imageList = {CONTEXT_THREAD_IMAGES, images};
+    EBS_ImageList expectedImageList = {CONTEXT_THREAD_IMAGES, expectedImages};
+
+    CountingAllocator counts;
+    const EBS_Allocator allocator = countingAllocator(&counts);
+    int errorCode;
+    EBS_Context *context = EBS_ContextCreate(&allocator, &errorCode);
+    TEST_ASSERT_NOT_NULL(context);
+    const EBS_Options options = {
+            .squareSize = 8,
+            .threadCount = 4,
+            .depth = 4,
+            .checksum = true
+    };
+    EBS_Options contextOptions = options;
+    contextOptions.context = context;
+    contextOptions.indexDirectory = ".";
+
+    // the threads are started by the first call and kept by the context, as are the arenas, and the indices saved by
+    // the first call are then loaded without allocating either
+    uint64_t allocations = 0;
+    const EBS_ThreadPool *pool = NULL;
+    for (uint64_t size = sizeof(data); size + 50000 > 50000; size -= 50000) {
+        for (uint64_t i = 0; i < size; ++i) {
+            data[i] = (uint8_t) rand();
+        }
+        const EBS_Message message = {size, data};
+        EBS_MessageEmbedWithOptions(&imageList, &message, &contextOptions, &errorCode);
+        TEST_ASSERT_EQUAL(EBS_OK, errorCode);
+        EBS_MessageEmbedWithOptions(&expectedImageList, &message, &options, &errorCode);
+        TEST_ASSERT_EQUAL(EBS_OK, errorCode);
+        TEST_ASSERT_EQUAL_MEMORY(expected, pixels, sizeof(pixels));
+
+        const EBS_Message extracted = EBS_MessageExtractWithOptions(&imageList, &contextOptions, &errorCode);
+        TEST_ASSERT_EQUAL(EBS_OK, errorCode);
+        TEST_ASSERT_EQUAL(size, extracted.size);
+        TEST_ASSERT_EQUAL_MEMORY(data, extracted.data, size);
+
+        TEST_ASSERT_NOT_NULL(context->pool);
+        if (size != sizeof(data)) {
+            TEST_ASSERT_EQUAL(allocations, counts.allocations);
+            TEST_ASSERT(context->pool == pool);
+        }
+        allocations = counts.allocations;
+        pool = context->pool;
+    }
+    TEST_ASSERT_EQUAL(0, counts.deallocations);
+
+    EBS_ContextFree(context);
+    TEST_ASSERT_EQUAL(counts.allocations, counts.deallocations);
+
+    char path[512];
+    TEST_ASSERT(EBS_IndexPathsSize(".") <= sizeof(path));
+    for (uint64_t i = 0; i < CONTEXT_THREAD_IMAGES; ++i) {
+        uint64_t key;
+        TEST_ASSERT(EBS_IndexKey(images + i, 8, 4, 0, &key));
+        EBS_IndexPath(path, ".", key, 8, 4, 0);
+        TEST_ASSERT_EQUAL(0, remove(path));
+    }
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+void test_ContextCreate(void);
+
+void test_ContextReuse(void);
+
+void test_ContextPlan(void);
+
+void test_ContextThreads(void);
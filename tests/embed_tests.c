@@ -23,12 +23,9 @@ void test_SquareEmbed_single(const char *filename, uint64_t squareSize, uint64_t
             .channel = channels,
             .pixels = output
     };
-    EBS_Square square = {
-            .x = 0,
-            .y = 0
-    };
+    EBS_Square square = EBS_SquareMake(0, 0);
 
-    EBS_SquareEmbed(&image, &square, squareSize, aCase.data, aCase.size / 8);
+    EBS_SquareEmbed(&image, &square, squareSize, 1, 0, NULL, 0, aCase.data, aCase.size / 8);
     if (memcmp(aCase.result, output, aCase.size) != 0) {
         free(output);
         freeCase(&aCase);
@@ -44,3 +41,204 @@ void test_SquareEmbed(void) {
     test_SquareEmbed_single("./tests/cases/case_32x32x3", 32, 3);
     test_SquareEmbed_single("./tests/cases/case_32x32x4", 32, 4);
 }
+
+static void referenceSquareEmbed(EBS_Image *image, const EBS_Square *square, uint64_t squareSize, uint64_t depth,
+                                 const uint8_t *data, uint64_t dataSize) {
+    const uint64_t channel = image->channel;
+    uint64_t bit = 0;
+    uint8_t *yStart = image->pixels + (EBS_SquareY(*square, image, squareSize) * image->width +
+                                            EBS_SquareX(*square, image, squareSize)) * channel;
+    for (uint64_t y = 0; y < squareSize; ++y, yStart += image->width * channel) {
+        uint8_t *xStart = yStart;
+        for (uint64_t x = 0; x < squareSize * channel; ++x, ++xStart) {
+            for (uint64_t b = 0; b < depth; ++b, ++bit) {
+                if (bit == dataSize * 8) return;
+                *xStart = (uint8_t) ((*xStart & ~(1u << b)) | ((data[bit / 8] >> (bit % 8)) & 1) << b);
+            }
+        }
+    }
+}
+
+void test_SquareEmbedKernel(void) {
+    static uint8_t expected[40 * 40 * 5], output[40 * 40 * 5];
+    uint8_t data[40 * 40 * 5 * 4 / 8 + 8];
+    for (uint64_t i = 0; i < sizeof(data); ++i) {
+        data[i] = (uint8_t) rand();
+    }
+
+    // every depth, square size and channel count, with messages ending anywhere in the square or past it
+    for (uint64_t depth = 1; depth <= 4; ++depth) {
+        for (uint64_t squareSize = 4; squareSize <= 16; squareSize += 4) {
+            for (uint64_t channel = 1; channel <= 5; ++channel) {
+                const uint64_t capacity = squareSize * squareSize * channel * depth / 8;
+                for (uint64_t dataSize = 0; dataSize <= capacity + 2; dataSize += 1 + capacity / 16) {
+                    for (uint64_t i = 0; i < sizeof(output); ++i) {
+                        output[i] = (uint8_t) rand();
+                    }
+                    memcpy(expected, output, sizeof(output));
+                    EBS_Image image = {.width = 40, .height = 40, .channel = channel, .pixels = output};
+                    EBS_Image expectedImage = {.width = 40, .height = 40, .channel = channel, .pixels = expected};
+                    // the square on the second row and column
+                    const EBS_Square square = EBS_SquareMake(0, 40 / squareSize + 1);
+
+                    EBS_SquareEmbed(&image, &square, squareSize, depth, 0, NULL, 0, data, dataSize);
+                    referenceSquareEmbed(&expectedImage, &square, squareSize, depth, data, dataSize);
+                    TEST_ASSERT_EQUAL_MEMORY(expected, output, sizeof(output));
+                }
+            }
+        }
+    }
+}
+
+void test_SquareEmbedEncrypted(void) {
+    // squares holding more than a chunk of the cipher, with rows that don't end on one
+    static uint8_t expected[124 * 124 * 3], output[124 * 124 * 3];
+    static uint8_t data[124 * 124 * 3 * 4 / 8], encrypted[sizeof(data)];
+    uint8_t key[EBS_CIPHER_KEY], nonce[EBS_CIPHER_NONCE];
+    for (uint64_t i = 0; i < sizeof(data); ++i) {
+        data[i] = (uint8_t) rand();
+    }
+    for (uint64_t i = 0; i < sizeof(key); ++i) {
+        key[i] = (uint8_t) rand();
+    }
+    for (uint64_t i = 0; i < sizeof(nonce); ++i) {
+        nonce[i] = (uint8_t) rand();
+    }
+    EBS_Cipher cipher;
+    EBS_CipherInit(&cipher, key, nonce);
+
+    // writing with the key gives the pixels of writing the encrypted message
+    const uint64_t channelMasks[] = {0, 0x5};
+    for (uint64_t depth = 1; depth <= 4; ++depth) {
+        for (uint64_t m = 0; m < sizeof(channelMasks) / sizeof(channelMasks[0]); ++m) {
+            for (uint64_t i = 0; i < sizeof(output); ++i) {
+                output[i] = (uint8_t) rand();
+            }
+            memcpy(expected, output, sizeof(output));
+            EBS_Image image = {.width = 124, .height = 124, .channel = 3, .pixels = output};
+            EBS_Image expectedImage = {.width = 124, .height = 124, .channel = 3, .pixels = expected};
+            const EBS_Square square = EBS_SquareMake(0, 0);
+
+            EBS_CipherStream stream;
+            EBS_CipherApply(EBS_CipherStreamInit(&stream, &cipher), 100, encrypted, data, sizeof(data));
+            EBS_SquareEmbed(&image, &square, 124, depth, channelMasks[m], EBS_CipherStreamInit(&stream, &cipher), 100,
+                            data, sizeof(data));
+            EBS_SquareEmbed(&expectedImage, &square, 124, depth, channelMasks[m], NULL, 0, encrypted, sizeof(data));
+            TEST_ASSERT_EQUAL_MEMORY(expected, output, sizeof(output));
+        }
+    }
+}
+
+#define THREADED_IMAGES 4
+#define THREADED_PIXELS (THREADED_IMAGES * 256 * 200 * 3)
+
+void test_MessageEmbedThreaded(void) {
+    static uint8_t serial[THREADED_PIXELS], threaded[THREADED_PIXELS];
+    static uint8_t data[300000];
+    for (uint64_t i = 0; i < THREADED_PIXELS; ++i) {
+        serial[i] = (uint8_t) rand();
+    }
+    memcpy(threaded, serial, sizeof(serial));
+    for (uint64_t i = 0; i < sizeof(data); ++i) {
+        data[i] = (uint8_t) rand();
+    }
+
+    // the squares are written by several threads, the images have to come out the same
+    EBS_Image serialImages[THREADED_IMAGES], threadedImages[THREADED_IMAGES];
+    for (uint64_t i = 0; i < THREADED_IMAGES; ++i) {
+        serialImages[i] = (EBS_Image) {.width = 256, .height = 200, .channel = 3, .pixels = serial + i * 256 * 200 * 3};
+        threadedImages[i] = (EBS_Image) {.width = 256, .height = 200, .channel = 3,
+                                         .pixels = threaded + i * 256 * 200 * 3};
+    }
+    EBS_ImageList serialList = {THREADED_IMAGES, serialImages};
+    EBS_ImageList threadedList = {THREADED_IMAGES, threadedImages};
+    EBS_Options options = {
+            .squareSize = 8,
+            .threadCount = 1,
+            .depth = 4
+    };
+    int errorCode;
+    for (uint64_t size = 0; size <= sizeof(data); size += 74999) {
+        const EBS_Message message = {size, data};
+        options.threadCount = 1;
+        EBS_MessageEmbedWithOptions(&serialList, &message, &options, &errorCode);
+        TEST_ASSERT_EQUAL(EBS_OK, errorCode);
+        options.threadCount = 4;
+        EBS_MessageEmbedWithOptions(&threadedList, &message, &options, &errorCode);
+        TEST_ASSERT_EQUAL(EBS_OK, errorCode);
+        TEST_ASSERT_EQUAL_MEMORY(serial, threaded, sizeof(serial));
+    }
+}
+
+typedef struct StreamSource {
+    const uint8_t *data;
+    uint64_t size;
+    uint64_t offset;
+} StreamSource;
+
+// gives at most 1000 bytes at a time, to go through short reads
+static uint64_t streamRead(void *context, uint8_t *buffer, uint64_t size) {
+    StreamSource *source = context;
+    uint64_t count = source->size - source->offset;
+    if (count > size) count = size;
+    if (count > 1000) count = 1000;
+    memcpy(buffer, source->data + source->offset, count);
+    source->offset += count;
+    return count;
+}
+
+void test_MessageEmbedStream(void) {
+    static uint8_t whole[THREADED_PIXELS], streamed[THREADED_PIXELS];
+    static uint8_t data[300000];
+    for (uint64_t i = 0; i < THREADED_PIXELS; ++i) {
+        whole[i] = (uint8_t) rand();
+    }
+    memcpy(streamed, whole, sizeof(whole));
+    for (uint64_t i = 0; i < sizeof(data); ++i) {
+        data[i] = (uint8_t) rand();
+    }
+
+    // the message read a few tasks at a time has to give the same images as the message in memory
+    EBS_Image wholeImages[THREADED_IMAGES], streamedImages[THREADED_IMAGES];
+    for (uint64_t i = 0; i < THREADED_IMAGES; ++i) {
+        wholeImages[i] = (EBS_Image) {.width = 256, .height = 200, .channel = 3, .pixels = whole + i * 256 * 200 * 3};
+        streamedImages[i] = (EBS_Image) {.width = 256, .height = 200, .channel = 3,
+                                         .pixels = streamed + i * 256 * 200 * 3};
+    }
+    EBS_ImageList wholeList = {THREADED_IMAGES, wholeImages};
+    EBS_ImageList streamedList = {THREADED_IMAGES, streamedImages};
+    static const uint8_t key[32] = {1, 2, 3};
+    EBS_Options options = {
+            .squareSize = 8,
+            .depth = 4,
+            .key = key,
+            .checksum = true
+    };
+    int errorCode;
+    for (uint64_t threadCount = 1; threadCount <= 4; threadCount += 3) {
+        options.threadCount = threadCount;
+        for (uint64_t size = 0; size <= sizeof(data); size += 74999) {
+            const EBS_Message message = {size, data};
+            EBS_MessageEmbedWithOptions(&wholeList, &message, &options, &errorCode);
+            TEST_ASSERT_EQUAL(EBS_OK, errorCode);
+            StreamSource source = {data, size, 0};
+            EBS_MessageEmbedStream(&streamedList, size, streamRead, &source, &options, &errorCode);
+            TEST_ASSERT_EQUAL(EBS_OK, errorCode);
+            TEST_ASSERT_EQUAL(size, source.offset);
+            TEST_ASSERT_EQUAL_MEMORY(whole, streamed, sizeof(whole));
+        }
+    }
+
+    // a reader running out before the size given stops the embedding
+    StreamSource source = {data, 1000, 0};
+    EBS_MessageEmbedStream(&streamedList, 200000, streamRead, &source, &options, &errorCode);
+    TEST_ASSERT_EQUAL(EBS_ErrorStream, errorCode);
+
+    // so does a missing reader, unless the message is empty
+    memcpy(whole, streamed, sizeof(whole));
+    EBS_MessageEmbedStream(&streamedList, 100, NULL, NULL, &options, &errorCode);
+    TEST_ASSERT_EQUAL(EBS_ErrorStream, errorCode);
+    TEST_ASSERT_EQUAL_MEMORY(whole, streamed, sizeof(whole));
+    EBS_MessageEmbedStream(&streamedList, 0, NULL, NULL, &options, &errorCode);
+    TEST_ASSERT_EQUAL(EBS_OK, errorCode);
+}
@@ -1,3 +1,11 @@
 #pragma once
 
 void test_SquareEmbed(void);
+
+void test_SquareEmbedKernel(void);
+
+void test_SquareEmbedEncrypted(void);
+
+void test_MessageEmbedThreaded(void);
+
+void test_MessageEmbedStream(void);
@@ -0,0 +1,74 @@
+#include "entropy_tests.h"
+
+#include <string.h>
+
+#include "unity/unity.h"
+#include "entropy.h"
+
+void test_EntropyLog2(void) {
+    TEST_ASSERT_EQUAL(0, EBS_EntropyLog2(1));
+    TEST_ASSERT(EBS_EntropyLog2(2) == 1ull << 44);
+    TEST_ASSERT(EBS_EntropyLog2(1024) == 10ull << 44);
+    // log2(3) = 1.5849625007211562
+    TEST_ASSERT(EBS_EntropyLog2(3) >> 20 == 0x195c01a);
+}
+
+void test_EntropyTableValue(void) {
+    TEST_ASSERT(EBS_EntropyTableValue(0) == 0);
+    TEST_ASSERT(EBS_EntropyTableValue(1) == 0);
+    TEST_ASSERT(EBS_EntropyTableValue(2) == 2ull << EBS_ENTROPY_FRACTION_BITS);
+    TEST_ASSERT(EBS_EntropyTableValue(16) == 64ull << EBS_ENTROPY_FRACTION_BITS);
+    TEST_ASSERT(EBS_EntropyTableValue(3) == 0x4c1404ebull);
+
+    for (uint64_t n = 0; n < EBS_ENTROPY_STATIC_TABLE_SIZE; ++n) {
+        TEST_ASSERT(EBS_EntropyStaticTable[n] == EBS_EntropyTableValue(n));
+    }
+}
+
+void test_EntropyTableGet(void) {
+    TEST_ASSERT(EBS_EntropyTableGet(NULL, 4) == EBS_EntropyStaticTable);
+    TEST_ASSERT(EBS_EntropyTableGet(NULL, 32) == EBS_EntropyStaticTable);
+
+    const uint64_t *table = EBS_EntropyTableGet(NULL, 252);
+    TEST_ASSERT_NOT_NULL(table);
+    TEST_ASSERT(EBS_EntropyTableGet(NULL, 36) == table);
+    TEST_ASSERT_EQUAL_MEMORY(EBS_EntropyStaticTable, table, sizeof(EBS_EntropyStaticTable));
+    TEST_ASSERT(table[252 * 252] == EBS_EntropyTableValue(252 * 252));
+
+    // a context keeps a copy of its own, made through its allocator
+    int errorCode;
+    EBS_Context *context = EBS_ContextCreate(NULL, &errorCode);
+    TEST_ASSERT_NOT_NULL(context);
+    TEST_ASSERT(EBS_EntropyTableGet(context, 8) == EBS_EntropyStaticTable);
+    const uint64_t *contextTable = EBS_EntropyTableGet(context, 252);
+    TEST_ASSERT_NOT_NULL(contextTable);
+    TEST_ASSERT(contextTable != table);
+    TEST_ASSERT(EBS_EntropyTableGet(context, 36) == contextTable);
+    TEST_ASSERT_EQUAL_MEMORY(table, contextTable, (252 * 252 + 1) * sizeof(uint64_t));
+    EBS_ContextFree(context);
+}
+
+void test_EntropySum(void) {
+    uint16_t histogram[EBS_HISTOGRAM_BINS];
+    memset(histogram, 0, sizeof(histogram));
+    TEST_ASSERT(EBS_EntropySum(EBS_EntropyStaticTable, histogram) == 0);
+
+    histogram[0] = 2;
+    histogram[127] = 16;
+    histogram[64] = 1;
+    TEST_ASSERT(EBS_EntropySum(EBS_EntropyStaticTable, histogram) == 66ull << EBS_ENTROPY_FRACTION_BITS);
+}
+
+void test_EntropyKey(void) {
+    const uint64_t *table = EBS_EntropyStaticTable;
+    const uint32_t one = 1u << EBS_ENTROPY_FRACTION_BITS;
+
+    // every sample in one bin
+    TEST_ASSERT_EQUAL(0, EBS_EntropyKey(table, 16, 1, table[16]));
+    // every sample in its own bin
+    TEST_ASSERT_EQUAL(4 * one, EBS_EntropyKey(table, 16, 1, 0));
+    // two channels, one flat and one uniform
+    TEST_ASSERT_EQUAL(2 * one, EBS_EntropyKey(table, 16, 2, table[16]));
+    // half and half
+    TEST_ASSERT_EQUAL(one, EBS_EntropyKey(table, 16, 1, 2 * table[8]));
+}
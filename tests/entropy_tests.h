@@ -0,0 +1,11 @@
+#pragma once
+
+void test_EntropyLog2(void);
+
+void test_EntropyTableValue(void);
+
+void test_EntropyTableGet(void);
+
+void test_EntropySum(void);
+
+void test_EntropyKey(void);
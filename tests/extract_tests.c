@@ -2,6 +2,7 @@
 
 #include "unity/unity.h"
 #include "extract.h"
+#include "xxhash.h"
 #include "case_loader.h"
 #include <string.h>
 #include <stdlib.h>
@@ -22,12 +23,9 @@ void test_SquareExtract_single(const char *filename, uint64_t squareSize, uint64
             .channel = channels,
             .pixels = aCase.result
     };
-    EBS_Square square = {
-            .x = 0,
-            .y = 0
-    };
+    EBS_Square square = EBS_SquareMake(0, 0);
 
-    EBS_SquareExtract(&image, &square, squareSize, output, aCase.size / 8);
+    EBS_SquareExtract(&image, &square, squareSize, 1, 0, NULL, 0, output, aCase.size / 8);
     if (memcmp(aCase.data, output, aCase.size / 8) != 0) {
         free(output);
         freeCase(&aCase);
@@ -43,3 +41,392 @@ void test_SquareExtract(void) {
     test_SquareExtract_single("./tests/cases/case_32x32x3", 32, 3);
     test_SquareExtract_single("./tests/cases/case_32x32x4", 32, 4);
 }
+
+static void referenceSquareExtract(const EBS_Image *image, const EBS_Square *square, uint64_t squareSize,
+                                   uint64_t depth, uint8_t *data, uint64_t dataSize) {
+    memset(data, 0, dataSize);
+    const uint64_t channel = image->channel;
+    uint64_t bit = 0;
+    const uint8_t *yStart = image->pixels + (EBS_SquareY(*square, image, squareSize) * image->width +
+                                            EBS_SquareX(*square, image, squareSize)) * channel;
+    for (uint64_t y = 0; y < squareSize; ++y, yStart += image->width * channel) {
+        const uint8_t *xStart = yStart;
+        for (uint64_t x = 0; x < squareSize * channel; ++x, ++xStart) {
+            for (uint64_t b = 0; b < depth; ++b, ++bit) {
+                if (bit == dataSize * 8) return;
+                data[bit / 8] = (uint8_t) (data[bit / 8] | ((*xStart >> b) & 1) << (bit % 8));
+            }
+        }
+    }
+}
+
+void test_SquareExtractKernel(void) {
+    static uint8_t pixels[40 * 40 * 5];
+    uint8_t expected[40 * 40 * 5 * 4 / 8 + 8], output[40 * 40 * 5 * 4 / 8 + 8];
+    for (uint64_t i = 0; i < sizeof(pixels); ++i) {
+        pixels[i] = (uint8_t) rand();
+    }
+
+    // every depth, square size and channel count, with messages ending anywhere in the square or past it
+    for (uint64_t depth = 1; depth <= 4; ++depth) {
+        for (uint64_t squareSize = 4; squareSize <= 16; squareSize += 4) {
+            for (uint64_t channel = 1; channel <= 5; ++channel) {
+                const uint64_t capacity = squareSize * squareSize * channel * depth / 8;
+                for (uint64_t dataSize = 0; dataSize <= capacity + 2; dataSize += 1 + capacity / 16) {
+                    // the kernel has to write every byte it covers and nothing past them
+                    memset(output, 0xa5, sizeof(output));
+                    memset(expected, 0xa5, sizeof(expected));
+                    const EBS_Image image = {.width = 40, .height = 40, .channel = channel, .pixels = pixels};
+                    // the square on the second row and column
+                    const EBS_Square square = EBS_SquareMake(0, 40 / squareSize + 1);
+
+                    EBS_SquareExtract(&image, &square, squareSize, depth, 0, NULL, 0, output, dataSize);
+                    referenceSquareExtract(&image, &square, squareSize, depth, expected,
+                                           dataSize < capacity ? dataSize : capacity);
+                    TEST_ASSERT_EQUAL_MEMORY(expected, output, sizeof(output));
+                }
+            }
+        }
+    }
+}
+
+void test_ExtractRowKernels(void) {
+    uint8_t row[200], expected[100], output[100];
+    for (uint64_t i = 0; i < sizeof(row); ++i) {
+        row[i] = (uint8_t) rand();
+    }
+
+    for (uint64_t depth = 1; depth <= 4; ++depth) {
+        EBS_ExtractRowKernel kernels[3] = {EBS_ExtractRowKernelSelect(0, depth)};
+        uint64_t kernelCount = 1;
+#if EBS_X86_64
+        if (depth == 1) {
+            kernels[0] = EBS_ExtractRowScalar;
+            kernels[kernelCount++] = EBS_ExtractRowSSE2;
+            if (EBS_CpuFeatures() & EBS_CpuAVX2) kernels[kernelCount++] = EBS_ExtractRowAVX2;
+        }
+#endif
+
+        for (uint64_t size = 0; size <= sizeof(row); size += 8) {
+            memset(expected, 0, sizeof(expected));
+            for (uint64_t bit = 0; bit < size * depth; ++bit) {
+                const uint8_t sampleBit = (uint8_t) ((row[bit / depth] >> (bit % depth)) & 1);
+                expected[bit / 8] = (uint8_t) (expected[bit / 8] | sampleBit << (bit % 8));
+            }
+            for (uint64_t i = 0; i < kernelCount; ++i) {
+                memset(output, 0, sizeof(output));
+                kernels[i](output, row, size);
+                TEST_ASSERT_EQUAL_MEMORY(expected, output, sizeof(output));
+            }
+        }
+    }
+}
+
+void test_ExtractRowKernelSelect(void) {
+#if EBS_X86_64
+    TEST_ASSERT(EBS_ExtractRowKernelSelect(0, 1) == EBS_ExtractRowSSE2);
+    TEST_ASSERT(EBS_ExtractRowKernelSelect(EBS_CpuSSE42 | EBS_CpuAVX2, 1) == EBS_ExtractRowAVX2);
+#else
+    TEST_ASSERT(EBS_ExtractRowKernelSelect(0, 1) == EBS_ExtractRowScalar);
+#endif
+    TEST_ASSERT(EBS_ExtractRowKernelSelect(EBS_CpuSSE42 | EBS_CpuAVX2, 2) == EBS_ExtractRowScalar2);
+    TEST_ASSERT(EBS_ExtractRowKernelSelect(0, 3) == EBS_ExtractRowScalar3);
+    TEST_ASSERT(EBS_ExtractRowKernelSelect(0, 4) == EBS_ExtractRowScalar4);
+}
+
+#define THREADED_IMAGES 4
+#define THREADED_PIXELS (THREADED_IMAGES * 256 * 200 * 3)
+
+void test_MessageExtractThreaded(void) {
+    static uint8_t pixels[THREADED_PIXELS];
+    static uint8_t data[300000];
+    for (uint64_t i = 0; i < THREADED_PIXELS; ++i) {
+        pixels[i] = (uint8_t) rand();
+    }
+    for (uint64_t i = 0; i < sizeof(data); ++i) {
+        data[i] = (uint8_t) rand();
+    }
+
+    EBS_Image images[THREADED_IMAGES];
+    for (uint64_t i = 0; i < THREADED_IMAGES; ++i) {
+        images[i] = (EBS_Image) {.width = 256, .height = 200, .channel = 3, .pixels = pixels + i * 256 * 200 * 3};
+    }
+    EBS_ImageList imageList = {THREADED_IMAGES, images};
+    EBS_Options options = {
+            .squareSize = 8,
+            .threadCount = 1,
+            .depth = 4
+    };
+    int errorCode;
+
+    // the squares are gathered by several threads into the same message as a single one gives
+    for (uint64_t size = 0; size <= sizeof(data); size += 74999) {
+        const EBS_Message message = {size, data};
+        options.threadCount = 1;
+        EBS_MessageEmbedWithOptions(&imageList, &message, &options, &errorCode);
+        TEST_ASSERT_EQUAL(EBS_OK, errorCode);
+        for (uint64_t threadCount = 1; threadCount <= 4; threadCount += 3) {
+            options.threadCount = threadCount;
+            EBS_Message extracted = EBS_MessageExtractWithOptions(&imageList, &options, &errorCode);
+            TEST_ASSERT_EQUAL(EBS_OK, errorCode);
+            TEST_ASSERT_EQUAL(size, extracted.size);
+            TEST_ASSERT_EQUAL_MEMORY(data, extracted.data, size);
+            EBS_MessageFree(&extracted);
+        }
+    }
+}
+
+void test_MessageExtractEncrypted(void) {
+    static uint8_t pixels[THREADED_PIXELS], clear[THREADED_PIXELS];
+    static uint8_t data[100000];
+    uint8_t key[EBS_CIPHER_KEY], nonce[EBS_CIPHER_NONCE];
+    for (uint64_t i = 0; i < THREADED_PIXELS; ++i) {
+        pixels[i] = (uint8_t) rand();
+    }
+    memcpy(clear, pixels, sizeof(pixels));
+    for (uint64_t i = 0; i < sizeof(data); ++i) {
+        data[i] = (uint8_t) rand();
+    }
+    for (uint64_t i = 0; i < sizeof(key); ++i) {
+        key[i] = (uint8_t) rand();
+    }
+    for (uint64_t i = 0; i < sizeof(nonce); ++i) {
+        nonce[i] = (uint8_t) rand();
+    }
+
+    EBS_Image images[THREADED_IMAGES], clearImages[THREADED_IMAGES];
+    for (uint64_t i = 0; i < THREADED_IMAGES; ++i) {
+        images[i] = (EBS_Image) {.width = 256, .height = 200, .channel = 3, .pixels = pixels + i * 256 * 200 * 3};
+        clearImages[i] = (EBS_Image) {.width = 256, .height = 200, .channel = 3, .pixels = clear + i * 256 * 200 * 3};
+    }
+    EBS_ImageList imageList = {THREADED_IMAGES, images}, clearList = {THREADED_IMAGES, clearImages};
+    EBS_Options options = {
+            .squareSize = 8,
+            .threadCount = 1,
+            .depth = 2,
+            .key = key,
+            .nonce = nonce
+    };
+    const EBS_Message message = {sizeof(data), data};
+    int errorCode;
+    EBS_MessageEmbedWithOptions(&imageList, &message, &options, &errorCode);
+    TEST_ASSERT_EQUAL(EBS_OK, errorCode);
+
+    // the key changes the pixels written, not which ones
+    EBS_Options clearOptions = options;
+    clearOptions.key = NULL;
+    EBS_MessageEmbedWithOptions(&clearList, &message, &clearOptions, &errorCode);
+    TEST_ASSERT_EQUAL(EBS_OK, errorCode);
+    TEST_ASSERT_FALSE(memcmp(pixels, clear, sizeof(pixels)) == 0);
+    for (uint64_t i = 0; i < THREADED_PIXELS; ++i) {
+        TEST_ASSERT_EQUAL(pixels[i] & 0xfc, clear[i] & 0xfc);
+    }
+
+    for (uint64_t threadCount = 1; threadCount <= 4; threadCount += 3) {
+        options.threadCount = threadCount;
+        EBS_Message extracted = EBS_MessageExtractWithOptions(&imageList, &options, &errorCode);
+        TEST_ASSERT_EQUAL(EBS_OK, errorCode);
+        TEST_ASSERT_EQUAL(sizeof(data), extracted.size);
+        TEST_ASSERT_EQUAL_MEMORY(data, extracted.data, sizeof(data));
+        EBS_MessageFree(&extracted);
+    }
+
+    // another nonce doesn't give the message back
+    nonce[0] ^= 1;
+    EBS_Message extracted = EBS_MessageExtractWithOptions(&imageList, &options, &errorCode);
+    TEST_ASSERT_FALSE(errorCode == EBS_OK && extracted.size == sizeof(data) &&
+                      memcmp(data, extracted.data, sizeof(data)) == 0);
+    EBS_MessageFree(&extracted);
+}
+
+void test_MessageExtractChecksum(void) {
+    static uint8_t pixels[THREADED_PIXELS];
+    static uint8_t data[200000], other[60000];
+    for (uint64_t i = 0; i < THREADED_PIXELS; ++i) {
+        pixels[i] = (uint8_t) rand();
+    }
+    for (uint64_t i = 0; i < sizeof(data); ++i) {
+        data[i] = (uint8_t) rand();
+    }
+    for (uint64_t i = 0; i < sizeof(other); ++i) {
+        other[i] = (uint8_t) rand();
+    }
+
+    EBS_Image images[THREADED_IMAGES];
+    for (uint64_t i = 0; i < THREADED_IMAGES; ++i) {
+        images[i] = (EBS_Image) {.width = 256, .height = 200, .channel = 3, .pixels = pixels + i * 256 * 200 * 3};
+    }
+    EBS_ImageList imageList = {THREADED_IMAGES, images};
+    EBS_Options options = {
+            .squareSize = 8,
+            .depth = 4,
+            .checksum = true
+    };
+    int errorCode;
+    // the larger messages are split into several batches of tasks, hashed one after another
+    for (uint64_t size = 0; size <= sizeof(data); size += 49999) {
+        const EBS_Message message = {size, data};
+        options.threadCount = size / 49999 % 2 == 0 ? 1 : 4;
+        EBS_MessageEmbedWithOptions(&imageList, &message, &options, &errorCode);
+        TEST_ASSERT_EQUAL(EBS_OK, errorCode);
+        for (uint64_t threadCount = 1; threadCount <= 4; threadCount += 3) {
+            options.threadCount = threadCount;
+            EBS_Message extracted = EBS_MessageExtractWithOptions(&imageList, &options, &errorCode);
+            TEST_ASSERT_EQUAL(EBS_OK, errorCode);
+            TEST_ASSERT_EQUAL(size, extracted.size);
+            TEST_ASSERT_EQUAL_MEMORY(data, extracted.data, size);
+            EBS_MessageFree(&extracted);
+        }
+
+        // the header holds the size and the XXH3-64 of the message seeded with it, however many threads wrote it
+        EBS_ComputedImageList computedImageList = EBS_ComputedImageListCreate(&imageList, &options, 1);
+        TEST_ASSERT_NOT_NULL(computedImageList.computedImages);
+        EBS_SquareMerge squareMerge;
+        TEST_ASSERT_TRUE(EBS_SquareMergeInit(&squareMerge, &computedImageList));
+        const EBS_ComputedImage *top = computedImageList.computedImages + EBS_SquareMergeTop(&squareMerge);
+        uint64_t header[2];
+        EBS_SquareExtract(&top->image, top->squareList.squares, 8, 4, 0, NULL, 0, (uint8_t *) header,
+                          sizeof(header));
+        EBS_SquareMergeFree(&squareMerge);
+        EBS_ComputedImageListFree(&computedImageList);
+        TEST_ASSERT_EQUAL(size, header[0]);
+        TEST_ASSERT_TRUE(XXH3_64bits_withSeed(data, size, size) == header[1]);
+    }
+
+    // another message written over it without a checksum leaves the old one in the header
+    options.checksum = false;
+    const EBS_Message message = {sizeof(other), other};
+    EBS_MessageEmbedWithOptions(&imageList, &message, &options, &errorCode);
+    TEST_ASSERT_EQUAL(EBS_OK, errorCode);
+    options.checksum = true;
+    EBS_Message extracted = EBS_MessageExtractWithOptions(&imageList, &options, &errorCode);
+    TEST_ASSERT_EQUAL(EBS_ErrorChecksum, errorCode);
+    TEST_ASSERT_EQUAL(0, extracted.size);
+    TEST_ASSERT_NULL(extracted.data);
+
+    // a header square too small for the checksum can't take a message
+    EBS_Image small = {.width = 8, .height = 8, .channel = 1, .pixels = pixels};
+    EBS_ImageList smallList = {1, &small};
+    options.squareSize = 4;
+    const EBS_Message empty = {0, data};
+    EBS_MessageEmbedWithOptions(&smallList, &empty, &options, &errorCode);
+    TEST_ASSERT_EQUAL(EBS_ErrorOverflow, errorCode);
+}
+
+typedef struct StreamSink {
+    uint8_t *data;
+    uint64_t size;
+    uint64_t capacity;
+    uint64_t calls;
+} StreamSink;
+
+// appends what it's given, taking nothing once it's full
+static uint64_t streamWrite(void *context, const uint8_t *data, uint64_t size) {
+    StreamSink *sink = context;
+    ++sink->calls;
+    if (sink->capacity - sink->size < size) return 0;
+    memcpy(sink->data + sink->size, data, size);
+    sink->size += size;
+    return size;
+}
+
+void test_MessageExtractStream(void) {
+    static uint8_t pixels[THREADED_PIXELS];
+    static uint8_t data[200000], written[200000];
+    for (uint64_t i = 0; i < THREADED_PIXELS; ++i) {
+        pixels[i] = (uint8_t) rand();
+    }
+    for (uint64_t i = 0; i < sizeof(data); ++i) {
+        data[i] = (uint8_t) rand();
+    }
+
+    EBS_Image images[THREADED_IMAGES];
+    for (uint64_t i = 0; i < THREADED_IMAGES; ++i) {
+        images[i] = (EBS_Image) {.width = 256, .height = 200, .channel = 3, .pixels = pixels + i * 256 * 200 * 3};
+    }
+    EBS_ImageList imageList = {THREADED_IMAGES, images};
+    static const uint8_t key[32] = {4, 5, 6};
+    EBS_Options options = {
+            .squareSize = 8,
+            .depth = 4,
+            .key = key,
+            .checksum = true
+    };
+    int errorCode;
+    for (uint64_t size = 0; size <= sizeof(data); size += 99999) {
+        options.threadCount = 1;
+        const EBS_Message message = {size, data};
+        EBS_MessageEmbedWithOptions(&imageList, &message, &options, &errorCode);
+        TEST_ASSERT_EQUAL(EBS_OK, errorCode);
+
+        // the writer is given the message in order, a batch of squares at a time
+        for (uint64_t threadCount = 1; threadCount <= 4; threadCount += 3) {
+            options.threadCount = threadCount;
+            StreamSink sink = {written, 0, sizeof(written), 0};
+            const uint64_t extracted = EBS_MessageExtractStream(&imageList, streamWrite, &sink, &options, &errorCode);
+            TEST_ASSERT_EQUAL(EBS_OK, errorCode);
+            TEST_ASSERT_EQUAL(size, extracted);
+            TEST_ASSERT_EQUAL(size, sink.size);
+            TEST_ASSERT_EQUAL_MEMORY(data, written, size);
+            if (threadCount == 1 && size > 100000) TEST_ASSERT_TRUE(sink.calls > 1);
+        }
+    }
+
+    // a writer taking fewer bytes than given stops the extraction
+    StreamSink sink = {written, 0, 1000, 0};
+    const uint64_t extracted = EBS_MessageExtractStream(&imageList, streamWrite, &sink, &options, &errorCode);
+    TEST_ASSERT_EQUAL(EBS_ErrorStream, errorCode);
+    TEST_ASSERT_EQUAL(0, extracted);
+}
+
+void test_MessageExtractEmptyImage(void) {
+    static uint8_t tiny[2 * 2 * 3], flat[64 * 64 * 3];
+    memset(flat, 0x80, sizeof(flat));
+    uint8_t data[10] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+
+    // the first image has no square, every square of the second has an entropy of 0
+    EBS_Image images[] = {
+            {.width = 2, .height = 2, .channel = 3, .pixels = tiny},
+            {.width = 64, .height = 64, .channel = 3, .pixels = flat}
+    };
+    EBS_ImageList imageList = {2, images};
+    const EBS_Message message = {sizeof(data), data};
+    int errorCode;
+    for (int checksum = 0; checksum <= 1; ++checksum) {
+        EBS_Options options = {.squareSize = 8, .checksum = checksum};
+        memset(flat, 0x80, sizeof(flat));
+        EBS_MessageEmbedWithOptions(&imageList, &message, &options, &errorCode);
+        TEST_ASSERT_EQUAL(EBS_OK, errorCode);
+        EBS_Message extracted = EBS_MessageExtractWithOptions(&imageList, &options, &errorCode);
+        TEST_ASSERT_EQUAL(EBS_OK, errorCode);
+        TEST_ASSERT_EQUAL(sizeof(data), extracted.size);
+        TEST_ASSERT_EQUAL_MEMORY(data, extracted.data, sizeof(data));
+        EBS_MessageFree(&extracted);
+
+        EBS_Plan *plan = EBS_PlanCreate(&imageList, &options, &errorCode);
+        TEST_ASSERT_EQUAL(EBS_OK, errorCode);
+        TEST_ASSERT_EQUAL(8 * 8 * 24 - 24, EBS_PlanCapacity(plan));
+        extracted = EBS_PlanExtract(plan, &errorCode);
+        TEST_ASSERT_EQUAL(EBS_OK, errorCode);
+        TEST_ASSERT_EQUAL_MEMORY(data, extracted.data, sizeof(data));
+        EBS_MessageFree(&extracted);
+        EBS_PlanFree(plan);
+    }
+
+    // without any square there's nowhere for the header
+    EBS_ImageList emptyList = {1, images};
+    EBS_Options options = {.squareSize = 8};
+    const EBS_Message empty = {0, data};
+    EBS_MessageEmbedWithOptions(&emptyList, &empty, &options, &errorCode);
+    TEST_ASSERT_EQUAL(EBS_ErrorOverflow, errorCode);
+    EBS_Message extracted = EBS_MessageExtractWithOptions(&emptyList, &options, &errorCode);
+    TEST_ASSERT_EQUAL(EBS_ErrorInvalidMessage, errorCode);
+    TEST_ASSERT_EQUAL(0, extracted.size);
+    TEST_ASSERT_NULL(extracted.data);
+    EBS_Plan *plan = EBS_PlanCreate(&emptyList, &options, &errorCode);
+    TEST_ASSERT_EQUAL(EBS_OK, errorCode);
+    TEST_ASSERT_EQUAL(0, EBS_PlanCapacity(plan));
+    extracted = EBS_PlanExtract(plan, &errorCode);
+    TEST_ASSERT_EQUAL(EBS_ErrorInvalidMessage, errorCode);
+    EBS_PlanFree(plan);
+}
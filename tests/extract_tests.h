@@ -1,3 +1,19 @@
 #pragma once
 
 void test_SquareExtract(void);
+
+void test_SquareExtractKernel(void);
+
+void test_ExtractRowKernels(void);
+
+void test_ExtractRowKernelSelect(void);
+
+void test_MessageExtractThreaded(void);
+
+void test_MessageExtractEncrypted(void);
+
+void test_MessageExtractChecksum(void);
+
+void test_MessageExtractStream(void);
+
+void test_MessageExtractEmptyImage(void);
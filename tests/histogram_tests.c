@@ -0,0 +1,130 @@
+#include "histogram_tests.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "unity/unity.h"
+#include "histogram.h"
+
+#define TEST_WIDTH 40
+
+static void histogramReference(uint16_t *histogram, const uint8_t *start, uint64_t rowSize, uint64_t squareSize,
+                               uint64_t channel) {
+    memset(histogram, 0, EBS_HISTOGRAM_BINS * sizeof(uint16_t));
+    for (uint64_t y = 0; y < squareSize; ++y) {
+        for (uint64_t x = 0; x < squareSize; ++x) {
+            ++histogram[start[y * rowSize + x * channel] >> 1];
+        }
+    }
+}
+
+static void randomPixels(uint8_t *pixels, uint64_t size) {
+    for (uint64_t i = 0; i < size; ++i) {
+        pixels[i] = (uint8_t) rand();
+    }
+}
+
+static void checkKernel(EBS_HistogramRowKernel kernel, uint64_t channel, uint64_t counted) {
+    uint8_t pixels[TEST_WIDTH * TEST_WIDTH * EBS_HISTOGRAM_MAX_CHANNELS];
+    randomPixels(pixels, sizeof(pixels));
+
+    for (uint64_t squareSize = 1; squareSize <= TEST_WIDTH; ++squareSize) {
+        EBS_SubHistograms sub;
+        EBS_HistogramClear(sub, channel);
+        for (uint64_t y = 0; y < squareSize; ++y) {
+            kernel(sub, pixels + y * TEST_WIDTH * channel, squareSize * channel);
+        }
+        uint16_t actual[EBS_HISTOGRAM_MAX_CHANNELS][EBS_HISTOGRAM_BINS];
+        EBS_HistogramMerge(actual[0], sub, channel);
+
+        // channels past the counted ones stay empty
+        for (uint64_t c = 0; c < channel; ++c) {
+            uint16_t expected[EBS_HISTOGRAM_BINS] = {0};
+            if (c < counted) histogramReference(expected, pixels + c, TEST_WIDTH * channel, squareSize, channel);
+            TEST_ASSERT_EQUAL_MEMORY(expected, actual[c], sizeof(expected));
+        }
+    }
+}
+
+static void checkKernels(EBS_HistogramRowKernel quad, EBS_HistogramRowKernel triple, EBS_HistogramRowKernel rgb) {
+    checkKernel(quad, 1, 1);
+    checkKernel(quad, 2, 2);
+    checkKernel(triple, 3, 3);
+    checkKernel(quad, 4, 4);
+    checkKernel(rgb, 4, 3);
+}
+
+void test_HistogramSquare(void) {
+    uint8_t pixels[TEST_WIDTH * TEST_WIDTH * EBS_HISTOGRAM_MAX_CHANNELS];
+    randomPixels(pixels, sizeof(pixels));
+
+    for (uint64_t channel = 1; channel <= EBS_HISTOGRAM_MAX_CHANNELS; ++channel) {
+        for (uint64_t squareSize = 1; squareSize <= TEST_WIDTH; ++squareSize) {
+            uint16_t actual[EBS_HISTOGRAM_MAX_CHANNELS][EBS_HISTOGRAM_BINS];
+            EBS_HistogramSquare(actual[0], pixels, TEST_WIDTH * channel, squareSize, channel);
+            for (uint64_t c = 0; c < channel; ++c) {
+                uint16_t expected[EBS_HISTOGRAM_BINS];
+                histogramReference(expected, pixels + c, TEST_WIDTH * channel, squareSize, channel);
+                TEST_ASSERT_EQUAL_MEMORY(expected, actual[c], sizeof(expected));
+            }
+        }
+    }
+}
+
+void test_HistogramRowKernels(void) {
+    const uint32_t features = EBS_CpuFeatures();
+
+    checkKernels(EBS_HistogramRowQuadScalar, EBS_HistogramRowTripleScalar, EBS_HistogramRowRGBScalar);
+#if EBS_X86_64
+    if (features & EBS_CpuSSE42) {
+        checkKernels(EBS_HistogramRowQuadSSE42, EBS_HistogramRowTripleSSE42, EBS_HistogramRowRGBSSE42);
+    }
+    if (features & EBS_CpuAVX2) {
+        checkKernels(EBS_HistogramRowQuadAVX2, EBS_HistogramRowTripleAVX2, EBS_HistogramRowRGBAVX2);
+    }
+#endif
+    (void) features;
+}
+
+void test_HistogramChannel(void) {
+    uint8_t pixels[TEST_WIDTH * TEST_WIDTH * 7];
+    randomPixels(pixels, sizeof(pixels));
+
+    for (uint64_t squareSize = 1; squareSize <= TEST_WIDTH; ++squareSize) {
+        uint16_t expected[EBS_HISTOGRAM_BINS], actual[EBS_HISTOGRAM_BINS];
+        for (uint64_t c = 0; c < 7; ++c) {
+            histogramReference(expected, pixels + c, TEST_WIDTH * 7, squareSize, 7);
+            EBS_HistogramChannel(actual, pixels + c, TEST_WIDTH * 7, squareSize, 7);
+            TEST_ASSERT_EQUAL_MEMORY(expected, actual, sizeof(expected));
+        }
+    }
+}
+
+void test_HistogramRowKernelSelect(void) {
+    TEST_ASSERT(EBS_HistogramRowKernelSelect(0, 1) == EBS_HistogramRowQuadScalar);
+    TEST_ASSERT(EBS_HistogramRowKernelSelect(0, 3) == EBS_HistogramRowTripleScalar);
+    TEST_ASSERT(EBS_HistogramRowRGBKernelSelect(0) == EBS_HistogramRowRGBScalar);
+#if EBS_X86_64
+    TEST_ASSERT(EBS_HistogramRowRGBKernelSelect(EBS_CpuSSE42) == EBS_HistogramRowRGBSSE42);
+    TEST_ASSERT(EBS_HistogramRowRGBKernelSelect(EBS_CpuSSE42 | EBS_CpuAVX2) == EBS_HistogramRowRGBAVX2);
+    TEST_ASSERT(EBS_HistogramRowKernelSelect(EBS_CpuSSE42, 4) == EBS_HistogramRowQuadSSE42);
+    TEST_ASSERT(EBS_HistogramRowKernelSelect(EBS_CpuSSE42 | EBS_CpuAVX2, 2) == EBS_HistogramRowQuadAVX2);
+    TEST_ASSERT(EBS_HistogramRowKernelSelect(EBS_CpuSSE42 | EBS_CpuAVX2, 3) == EBS_HistogramRowTripleAVX2);
+#endif
+}
+
+void test_HistogramFold(void) {
+    uint8_t pixels[TEST_WIDTH * TEST_WIDTH];
+    randomPixels(pixels, sizeof(pixels));
+
+    // folding the histogram of value >> 1 gives the histogram of value >> depth
+    for (uint64_t depth = 1; depth <= 4; ++depth) {
+        uint16_t expected[EBS_HISTOGRAM_BINS] = {0}, actual[EBS_HISTOGRAM_BINS];
+        for (uint64_t i = 0; i < sizeof(pixels); ++i) {
+            ++expected[pixels[i] >> depth];
+        }
+        histogramReference(actual, pixels, TEST_WIDTH, TEST_WIDTH, 1);
+        EBS_HistogramFold(actual, depth);
+        TEST_ASSERT_EQUAL_MEMORY(expected, actual, sizeof(expected));
+    }
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+void test_HistogramSquare(void);
+
+void test_HistogramRowKernels(void);
+
+void test_HistogramChannel(void);
+
+void test_HistogramRowKernelSelect(void);
+
+void test_HistogramFold(void);
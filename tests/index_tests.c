@@ -0,0 +1,196 @@
+#include "index_tests.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "unity/unity.h"
+#include "index.h"
+#include "xxhash.h"
+
+#define INDEX_TEST_SIZE (40 * 36 * 3)
+
+static void fillIndexPixels(uint8_t *pixels) {
+    for (uint64_t i = 0; i < INDEX_TEST_SIZE; ++i) {
+        pixels[i] = (uint8_t) rand();
+    }
+}
+
+// room for the paths of an index file in the current directory
+static char indexPaths[512];
+
+static void removeIndex(const EBS_Image *image, uint64_t squareSize) {
+    uint64_t key;
+    TEST_ASSERT(EBS_IndexKey(image, squareSize, 1, 0, &key));
+    EBS_IndexPath(indexPaths, ".", key, squareSize, 1, 0);
+    remove(indexPaths);
+}
+
+void test_IndexKey(void) {
+    static uint8_t pixels[INDEX_TEST_SIZE];
+    fillIndexPixels(pixels);
+    EBS_Image image = {.width = 40, .height = 36, .channel = 3, .pixels = pixels};
+    uint64_t key, other;
+    TEST_ASSERT(EBS_IndexKey(&image, 8, 1, 0, &key));
+
+    // the least significant bits are ignored, everything else changes the key
+    pixels[1234] ^= 1;
+    TEST_ASSERT(EBS_IndexKey(&image, 8, 1, 0, &other));
+    TEST_ASSERT_EQUAL_UINT64(key, other);
+    pixels[1234] ^= 2;
+    TEST_ASSERT(EBS_IndexKey(&image, 8, 1, 0, &other));
+    TEST_ASSERT(key != other);
+    pixels[1234] ^= 2;
+
+    TEST_ASSERT(EBS_IndexKey(&image, 4, 1, 0, &other));
+    TEST_ASSERT(key != other);
+
+    // a deeper embedding ignores more bits and gets keys of its own
+    TEST_ASSERT(EBS_IndexKey(&image, 8, 3, 0, &key));
+    pixels[1234] ^= 6;
+    TEST_ASSERT(EBS_IndexKey(&image, 8, 3, 0, &other));
+    TEST_ASSERT_EQUAL_UINT64(key, other);
+    TEST_ASSERT(EBS_IndexKey(&image, 8, 2, 0, &other));
+    TEST_ASSERT(key != other);
+    pixels[1234] ^= 6;
+
+    // masks covering every channel share the key of no mask, the others get keys of their own
+    TEST_ASSERT(EBS_IndexKey(&image, 8, 1, 0, &key));
+    TEST_ASSERT(EBS_IndexKey(&image, 8, 1, 0xff, &other));
+    TEST_ASSERT_EQUAL_UINT64(key, other);
+    TEST_ASSERT(EBS_IndexKey(&image, 8, 1, 0x3, &other));
+    TEST_ASSERT(key != other);
+
+    image.width = 36;
+    image.height = 40;
+    TEST_ASSERT(EBS_IndexKey(&image, 8, 1, 0, &other));
+    TEST_ASSERT(key != other);
+}
+
+void test_IndexSaveLoad(void) {
+    static uint8_t pixels[INDEX_TEST_SIZE];
+    fillIndexPixels(pixels);
+    const EBS_Image image = {.width = 40, .height = 36, .channel = 3, .pixels = pixels};
+    uint64_t key;
+    TEST_ASSERT(EBS_IndexKey(&image, 8, 1, 0, &key));
+
+    EBS_SquareList expected = EBS_SquareListCreate(&image, 8, 1, 0);
+    EBS_SquareList actual = EBS_SquareListInit(&image, 8, 1, 0);
+    TEST_ASSERT_NOT_NULL(expected.squares);
+    TEST_ASSERT_NOT_NULL(actual.squares);
+
+    removeIndex(&image, 8);
+    TEST_ASSERT_FALSE(EBS_IndexLoad(".", indexPaths, &image, 8, 1, 0, key, &actual));
+    TEST_ASSERT(EBS_IndexSave(".", indexPaths, &image, 8, 1, 0, key, &expected));
+    TEST_ASSERT(EBS_IndexLoad(".", indexPaths, &image, 8, 1, 0, key, &actual));
+    for (uint64_t i = 0; i < expected.size; ++i) {
+        TEST_ASSERT_EQUAL(expected.squares[i].key, actual.squares[i].key);
+    }
+
+    // an index saved for another key isn't found
+    TEST_ASSERT_FALSE(EBS_IndexLoad(".", indexPaths, &image, 8, 1, 0, key + 1, &actual));
+    removeIndex(&image, 8);
+
+    EBS_SquareListFree(&expected);
+    EBS_SquareListFree(&actual);
+}
+
+void test_IndexValidate(void) {
+    static uint8_t pixels[INDEX_TEST_SIZE];
+    fillIndexPixels(pixels);
+    const EBS_Image image = {.width = 40, .height = 36, .channel = 3, .pixels = pixels};
+    uint64_t key;
+    TEST_ASSERT(EBS_IndexKey(&image, 8, 1, 0, &key));
+
+    EBS_SquareList list = EBS_SquareListCreate(&image, 8, 1, 0);
+    TEST_ASSERT_NOT_NULL(list.squares);
+    TEST_ASSERT(EBS_IndexSave(".", indexPaths, &image, 8, 1, 0, key, &list));
+
+    TEST_ASSERT(EBS_IndexPathsSize(".") <= sizeof(indexPaths));
+    char *path = indexPaths;
+    EBS_IndexPath(path, ".", key, 8, 1, 0);
+    FILE *file = fopen(path, "rb");
+    TEST_ASSERT_NOT_NULL(file);
+    // read one byte more than the index holds to check its size, words keep the entries aligned
+    uint64_t words[(sizeof(EBS_IndexHeader) + 20 * sizeof(EBS_IndexEntry)) / sizeof(uint64_t) + 1];
+    uint8_t *data = (uint8_t *) words;
+    const uint64_t dataSize = fread(data, 1, sizeof(words), file);
+    fclose(file);
+    remove(path);
+    TEST_ASSERT_EQUAL(sizeof(EBS_IndexHeader) + 20 * sizeof(EBS_IndexEntry), dataSize);
+
+    TEST_ASSERT(EBS_IndexValidate(data, dataSize, &image, 8, 1, 0, key, &list));
+    TEST_ASSERT_FALSE(EBS_IndexValidate(data, dataSize - 1, &image, 8, 1, 0, key, &list));
+    TEST_ASSERT_FALSE(EBS_IndexValidate(data, sizeof(EBS_IndexHeader) - 1, &image, 8, 1, 0, key, &list));
+    TEST_ASSERT_FALSE(EBS_IndexValidate(data, dataSize, &image, 8, 1, 0, key ^ 1, &list));
+
+    EBS_IndexHeader header;
+    memcpy(&header, data, sizeof(header));
+    EBS_IndexEntry *entries = (EBS_IndexEntry *) (data + sizeof(header));
+
+    // a flipped bit breaks the checksum
+    data[sizeof(header) + 5] ^= 1;
+    TEST_ASSERT_FALSE(EBS_IndexValidate(data, dataSize, &image, 8, 1, 0, key, &list));
+    data[sizeof(header) + 5] ^= 1;
+
+    // a consistent checksum doesn't let squares out of the image or out of order
+    const EBS_IndexEntry first = entries[0];
+    entries[0].index = 20;
+    header.checksum = XXH3_64bits(entries, 20 * sizeof(EBS_IndexEntry));
+    memcpy(data, &header, sizeof(header));
+    TEST_ASSERT_FALSE(EBS_IndexValidate(data, dataSize, &image, 8, 1, 0, key, &list));
+    entries[0] = entries[1];
+    entries[1] = first;
+    header.checksum = XXH3_64bits(entries, 20 * sizeof(EBS_IndexEntry));
+    memcpy(data, &header, sizeof(header));
+    TEST_ASSERT_FALSE(EBS_IndexValidate(data, dataSize, &image, 8, 1, 0, key, &list));
+
+    EBS_SquareListFree(&list);
+}
+
+void test_ComputedImageListCreateIndexed(void) {
+    static uint8_t pixels[2][INDEX_TEST_SIZE];
+    fillIndexPixels(pixels[0]);
+    fillIndexPixels(pixels[1]);
+    EBS_Image images[] = {
+            {.width = 40, .height = 36, .channel = 3, .pixels = pixels[0]},
+            {.width = 36, .height = 40, .channel = 3, .pixels = pixels[1]},
+    };
+    EBS_ImageList imageList = {2, images};
+    EBS_Options options = {
+            .squareSize = 4,
+            .threadCount = 2,
+            .indexDirectory = NULL
+    };
+    removeIndex(images + 0, 4);
+    removeIndex(images + 1, 4);
+
+    EBS_ComputedImageList expected = EBS_ComputedImageListCreate(&imageList, &options, EBS_SQUARE_LIST_ORDER_ALL);
+    TEST_ASSERT_NOT_NULL(expected.computedImages);
+
+    // the first run saves the indexes, the second one loads them, both give the same squares
+    options.indexDirectory = ".";
+    for (uint64_t run = 0; run < 2; ++run) {
+        EBS_ComputedImageList actual = EBS_ComputedImageListCreate(&imageList, &options, 3);
+        TEST_ASSERT_NOT_NULL(actual.computedImages);
+        for (uint64_t i = 0; i < 2; ++i) {
+            const EBS_SquareList *expectedList = &expected.computedImages[i].squareList;
+            const EBS_SquareList *actualList = &actual.computedImages[i].squareList;
+            TEST_ASSERT_EQUAL(expectedList->size, actualList->size);
+            for (uint64_t j = 0; j < expectedList->size; ++j) {
+                TEST_ASSERT_EQUAL(expectedList->squares[j].key, actualList->squares[j].key);
+            }
+
+            uint64_t key;
+            EBS_SquareList loaded = EBS_SquareListInit(images + i, 4, 1, 0);
+            TEST_ASSERT(EBS_IndexKey(images + i, 4, 1, 0, &key));
+            TEST_ASSERT(EBS_IndexLoad(".", indexPaths, images + i, 4, 1, 0, key, &loaded));
+            EBS_SquareListFree(&loaded);
+        }
+        EBS_ComputedImageListFree(&actual);
+    }
+
+    removeIndex(images + 0, 4);
+    removeIndex(images + 1, 4);
+    EBS_ComputedImageListFree(&expected);
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+void test_IndexKey(void);
+
+void test_IndexSaveLoad(void);
+
+void test_IndexValidate(void);
+
+void test_ComputedImageListCreateIndexed(void);
@@ -0,0 +1,261 @@
+#include "plan_tests.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "unity/unity.h"
+#include "plan.h"
+
+#define PLAN_TEST_PIXELS (48 * 40 * 3 + 32 * 32 * 4)
+
+static void fillPlanImages(EBS_Image images[2], uint8_t *pixels) {
+    for (uint64_t i = 0; i < PLAN_TEST_PIXELS; ++i) {
+        pixels[i] = (uint8_t) rand();
+    }
+    images[0] = (EBS_Image) {.width = 48, .height = 40, .channel = 3, .pixels = pixels};
+    images[1] = (EBS_Image) {.width = 32, .height = 32, .channel = 4, .pixels = pixels + 48 * 40 * 3};
+}
+
+void test_PlanCreate(void) {
+    static uint8_t pixels[PLAN_TEST_PIXELS];
+    EBS_Image images[2];
+    fillPlanImages(images, pixels);
+    EBS_ImageList imageList = {
+            .size = 2,
+            .images = images
+    };
+    EBS_Options options = {
+            .squareSize = 6,
+            .threadCount = 1
+    };
+    int errorCode;
+
+    TEST_ASSERT_NULL(EBS_PlanCreate(&imageList, &options, &errorCode));
+    TEST_ASSERT_EQUAL(EBS_ErrorBadSquareSize, errorCode);
+
+    options.squareSize = 8;
+    images[1].pixels = NULL;
+    TEST_ASSERT_NULL(EBS_PlanCreate(&imageList, &options, &errorCode));
+    TEST_ASSERT_EQUAL(EBS_ErrorInvalidImage, errorCode);
+    images[1].pixels = pixels + 48 * 40 * 3;
+
+    EBS_Plan *plan = EBS_PlanCreate(&imageList, &options, &errorCode);
+    TEST_ASSERT_NOT_NULL(plan);
+    TEST_ASSERT_EQUAL(EBS_OK, errorCode);
+    // 30 squares of 24 bytes and 16 squares of 32 bytes, less the header square with the highest entropy
+    const uint64_t capacity = EBS_PlanCapacity(plan);
+    TEST_ASSERT(capacity == 30 * 24 + 16 * 32 - 24 || capacity == 30 * 24 + 16 * 32 - 32);
+    EBS_PlanFree(plan);
+    EBS_PlanFree(NULL);
+
+    // squares of 4 by 4 hold 6 or 8 bytes, too few for the size and the checksum, so nothing fits with a checksum
+    options.squareSize = 4;
+    options.checksum = true;
+    plan = EBS_PlanCreate(&imageList, &options, &errorCode);
+    TEST_ASSERT_NOT_NULL(plan);
+    TEST_ASSERT_EQUAL(0, EBS_PlanCapacity(plan));
+    uint8_t data[1] = {0};
+    const EBS_Message message = {sizeof(data), data};
+    EBS_PlanEmbed(plan, &message, &errorCode);
+    TEST_ASSERT_EQUAL(EBS_ErrorOverflow, errorCode);
+    EBS_PlanFree(plan);
+
+    // squares of 24 or 32 bytes hold both, and the whole capacity can be taken
+    options.squareSize = 8;
+    plan = EBS_PlanCreate(&imageList, &options, &errorCode);
+    TEST_ASSERT_NOT_NULL(plan);
+    static uint8_t large[30 * 24 + 16 * 32];
+    const EBS_Message full = {EBS_PlanCapacity(plan), large};
+    EBS_PlanEmbed(plan, &full, &errorCode);
+    TEST_ASSERT_EQUAL(EBS_OK, errorCode);
+    EBS_PlanFree(plan);
+}
+
+void test_PlanEmbed(void) {
+    static uint8_t pixels[PLAN_TEST_PIXELS], expected[PLAN_TEST_PIXELS];
+    EBS_Image images[2];
+    fillPlanImages(images, pixels);
+    memcpy(expected, pixels, sizeof(pixels));
+    EBS_Image expectedImages[] = {
+            {.width = 48, .height = 40, .channel = 3, .pixels = expected},
+            {.width = 32, .height = 32, .channel = 4, .pixels = expected + 48 * 40 * 3},
+    };
+    EBS_ImageList imageList = {2, images}, expectedImageList = {2, expectedImages};
+    const EBS_Options options = {
+            .squareSize = 8,
+            .threadCount = 2
+    };
+    int errorCode;
+
+    EBS_Plan *plan = EBS_PlanCreate(&imageList, &options, &errorCode);
+    TEST_ASSERT_NOT_NULL(plan);
+
+    // every message gives the same images as embedding without a plan
+    uint8_t data[300];
+    for (uint64_t size = 0; size <= sizeof(data); size += 60) {
+        for (uint64_t i = 0; i < size; ++i) {
+            data[i] = (uint8_t) rand();
+        }
+        const EBS_Message message = {size, data};
+        EBS_PlanEmbed(plan, &message, &errorCode);
+        TEST_ASSERT_EQUAL(EBS_OK, errorCode);
+        EBS_MessageEmbedWithOptions(&expectedImageList, &message, &options, &errorCode);
+        TEST_ASSERT_EQUAL(EBS_OK, errorCode);
+        TEST_ASSERT_EQUAL_MEMORY(expected, pixels, sizeof(pixels));
+    }
+
+    const EBS_Message message = {EBS_PlanCapacity(plan) + 1, data};
+    EBS_PlanEmbed(plan, &message, &errorCode);
+    TEST_ASSERT_EQUAL(EBS_ErrorOverflow, errorCode);
+
+    EBS_PlanFree(plan);
+}
+
+void test_PlanExtract(void) {
+    static uint8_t pixels[PLAN_TEST_PIXELS];
+    EBS_Image images[2];
+    fillPlanImages(images, pixels);
+    EBS_ImageList imageList = {2, images};
+    const EBS_Options options = {
+            .squareSize = 8,
+            .threadCount = 1
+    };
+    int errorCode;
+
+    EBS_Plan *plan = EBS_PlanCreate(&imageList, &options, &errorCode);
+    TEST_ASSERT_NOT_NULL(plan);
+
+    uint8_t data[500];
+    for (uint64_t size = 1; size <= sizeof(data); size += 99) {
+        for (uint64_t i = 0; i < size; ++i) {
+            data[i] = (uint8_t) rand();
+        }
+        const EBS_Message message = {size, data};
+        EBS_PlanEmbed(plan, &message, &errorCode);
+        TEST_ASSERT_EQUAL(EBS_OK, errorCode);
+
+        EBS_Message extracted = EBS_PlanExtract(plan, &errorCode);
+        TEST_ASSERT_EQUAL(EBS_OK, errorCode);
+        TEST_ASSERT_EQUAL(size, extracted.size);
+        TEST_ASSERT_EQUAL_MEMORY(data, extracted.data, size);
+        EBS_MessageFree(&extracted);
+    }
+
+    EBS_PlanFree(plan);
+}
+
+void test_PlanDepth(void) {
+    static uint8_t pixels[PLAN_TEST_PIXELS];
+    EBS_Image images[2];
+    fillPlanImages(images, pixels);
+    EBS_ImageList imageList = {2, images};
+    EBS_Options options = {
+            .squareSize = 8,
+            .threadCount = 1,
+            .depth = 5
+    };
+    int errorCode;
+
+    TEST_ASSERT_NULL(EBS_PlanCreate(&imageList, &options, &errorCode));
+    TEST_ASSERT_EQUAL(EBS_ErrorBadDepth, errorCode);
+    const EBS_Message empty = {0, NULL};
+    EBS_MessageEmbedWithOptions(&imageList, &empty, &options, &errorCode);
+    TEST_ASSERT_EQUAL(EBS_ErrorBadDepth, errorCode);
+    EBS_MessageExtractWithOptions(&imageList, &options, &errorCode);
+    TEST_ASSERT_EQUAL(EBS_ErrorBadDepth, errorCode);
+
+    // a depth of 0 is the default single bit
+    options.depth = 0;
+    EBS_Plan *plan = EBS_PlanCreate(&imageList, &options, &errorCode);
+    TEST_ASSERT_NOT_NULL(plan);
+    const uint64_t capacity = EBS_PlanCapacity(plan);
+    TEST_ASSERT(capacity == 30 * 24 + 16 * 32 - 24 || capacity == 30 * 24 + 16 * 32 - 32);
+    EBS_PlanFree(plan);
+
+    uint8_t data[1500];
+    for (uint64_t i = 0; i < sizeof(data); ++i) {
+        data[i] = (uint8_t) rand();
+    }
+    for (uint64_t depth = 1; depth <= 4; ++depth) {
+        options.depth = depth;
+        plan = EBS_PlanCreate(&imageList, &options, &errorCode);
+        TEST_ASSERT_NOT_NULL(plan);
+        // every square holds depth times more, the header square may be another one
+        const uint64_t depthCapacity = EBS_PlanCapacity(plan);
+        TEST_ASSERT(depthCapacity == (30 * 24 + 16 * 32 - 24) * depth ||
+                    depthCapacity == (30 * 24 + 16 * 32 - 32) * depth);
+
+        // messages ending anywhere in a square come back through the plan and without it
+        for (uint64_t size = 1; size <= depthCapacity && size <= sizeof(data); size += 97) {
+            const EBS_Message message = {size, data};
+            EBS_PlanEmbed(plan, &message, &errorCode);
+            TEST_ASSERT_EQUAL(EBS_OK, errorCode);
+
+            EBS_Message extracted = EBS_MessageExtractWithOptions(&imageList, &options, &errorCode);
+            TEST_ASSERT_EQUAL(EBS_OK, errorCode);
+            TEST_ASSERT_EQUAL(size, extracted.size);
+            TEST_ASSERT_EQUAL_MEMORY(data, extracted.data, size);
+            EBS_MessageFree(&extracted);
+        }
+        EBS_PlanFree(plan);
+    }
+}
+
+void test_PlanChannelMask(void) {
+    static uint8_t pixels[PLAN_TEST_PIXELS], original[PLAN_TEST_PIXELS];
+    EBS_Image images[2];
+    fillPlanImages(images, pixels);
+    EBS_ImageList imageList = {2, images};
+    EBS_Options options = {
+            .squareSize = 8,
+            .threadCount = 1,
+            .channelMask = 0x8
+    };
+    int errorCode;
+
+    // the mask leaves the RGB image without a channel
+    TEST_ASSERT_NULL(EBS_PlanCreate(&imageList, &options, &errorCode));
+    TEST_ASSERT_EQUAL(EBS_ErrorBadChannelMask, errorCode);
+    const EBS_Message empty = {0, NULL};
+    EBS_MessageEmbedWithOptions(&imageList, &empty, &options, &errorCode);
+    TEST_ASSERT_EQUAL(EBS_ErrorBadChannelMask, errorCode);
+    EBS_MessageExtractWithOptions(&imageList, &options, &errorCode);
+    TEST_ASSERT_EQUAL(EBS_ErrorBadChannelMask, errorCode);
+
+    // red and green only, 16 bytes a square in both images
+    options.channelMask = 0x3;
+    options.depth = 2;
+    EBS_Plan *plan = EBS_PlanCreate(&imageList, &options, &errorCode);
+    TEST_ASSERT_NOT_NULL(plan);
+    TEST_ASSERT_EQUAL((30 + 16 - 1) * 32, EBS_PlanCapacity(plan));
+    EBS_PlanFree(plan);
+
+    // the usual RGB of RGBA, the alpha and every unselected byte keep their value
+    options.channelMask = 0x7;
+    plan = EBS_PlanCreate(&imageList, &options, &errorCode);
+    TEST_ASSERT_NOT_NULL(plan);
+    uint8_t data[1500];
+    for (uint64_t i = 0; i < sizeof(data); ++i) {
+        data[i] = (uint8_t) rand();
+    }
+    const EBS_Message message = {sizeof(data), data};
+    memcpy(original, pixels, sizeof(pixels));
+    EBS_PlanEmbed(plan, &message, &errorCode);
+    TEST_ASSERT_EQUAL(EBS_OK, errorCode);
+    for (uint64_t i = 0; i < PLAN_TEST_PIXELS; ++i) {
+        const uint8_t changed = (uint8_t) (pixels[i] ^ original[i]);
+        TEST_ASSERT_EQUAL(0, changed & ~3);
+        if (i >= 48 * 40 * 3 && (i - 48 * 40 * 3) % 4 == 3) TEST_ASSERT_EQUAL(0, changed);
+    }
+
+    EBS_Message extracted = EBS_MessageExtractWithOptions(&imageList, &options, &errorCode);
+    TEST_ASSERT_EQUAL(EBS_OK, errorCode);
+    TEST_ASSERT_EQUAL(sizeof(data), extracted.size);
+    TEST_ASSERT_EQUAL_MEMORY(data, extracted.data, sizeof(data));
+    EBS_MessageFree(&extracted);
+    extracted = EBS_PlanExtract(plan, &errorCode);
+    TEST_ASSERT_EQUAL(EBS_OK, errorCode);
+    TEST_ASSERT_EQUAL_MEMORY(data, extracted.data, sizeof(data));
+    EBS_MessageFree(&extracted);
+    EBS_PlanFree(plan);
+}
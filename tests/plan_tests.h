@@ -0,0 +1,11 @@
+#pragma once
+
+void test_PlanCreate(void);
+
+void test_PlanEmbed(void);
+
+void test_PlanExtract(void);
+
+void test_PlanDepth(void);
+
+void test_PlanChannelMask(void);
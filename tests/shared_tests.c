@@ -1,9 +1,12 @@
 #include "shared_tests.h"
 
 #include <stdlib.h>
+#include <string.h>
 
 #include "unity/unity.h"
 #include "shared.h"
+#include "channel.h"
+#include "entropy.h"
 
 void test_SquareCalcEntropy(void) {
     uint8_t pixels[] = {
@@ -22,36 +25,110 @@ void test_SquareCalcEntropy(void) {
             .channel = 1,
             .pixels = pixels
     };
-    EBS_Square square = {
-            .x = 4,
-            .y = 4,
-    };
-    EBS_SquareCalcEntropy(&image, &square, 4);
-    TEST_ASSERT(3.875 == square.entropy);
+    // the bottom right square of the 2x2
+    EBS_Square square = EBS_SquareMake(0, 3);
+    const uint64_t *entropyTable = EBS_EntropyTableGet(NULL, 4);
+    const uint32_t expected = (uint32_t) (3.875 * (1 << EBS_ENTROPY_FRACTION_BITS));
+    EBS_SquareCalcEntropy(&image, &square, 4, 1, 0, entropyTable);
+    TEST_ASSERT_EQUAL(expected, EBS_SquareEntropy(square));
+    TEST_ASSERT_EQUAL(3, EBS_SquareIndex(square));
 
     image.channel = 2;
     image.height = 4;
-    square.x = 0;
-    square.y = 0;
-    square.entropy = 0;
-    EBS_SquareCalcEntropy(&image, &square, 4);
-    TEST_ASSERT(3.875 == square.entropy);
+    square = EBS_SquareMake(0, 0);
+    EBS_SquareCalcEntropy(&image, &square, 4, 1, 0, entropyTable);
+    TEST_ASSERT_EQUAL(expected, EBS_SquareEntropy(square));
 }
 
 void test_SquareCompare(void) {
-    EBS_Square square1, square2;
-
-    square1.entropy = 3.14;
-    square2.entropy = 3.14;
+    EBS_Square square1 = EBS_SquareMake(314, 0), square2 = EBS_SquareMake(314, 0);
     TEST_ASSERT_EQUAL(0, EBS_SquareCompare(&square1, &square2));
 
-    square1.entropy = 5;
-    square2.entropy = 3.14;
+    square1 = EBS_SquareMake(500, 0);
     TEST_ASSERT_EQUAL(-1, EBS_SquareCompare(&square1, &square2));
 
-    square1.entropy = 3.14;
-    square2.entropy = 5;
+    square1 = EBS_SquareMake(314, 0);
+    square2 = EBS_SquareMake(500, 0);
     TEST_ASSERT_EQUAL(1, EBS_SquareCompare(&square1, &square2));
+
+    // ties are broken by the row-major index
+    square1 = EBS_SquareMake(314, 2);
+    square2 = EBS_SquareMake(314, 40);
+    TEST_ASSERT_EQUAL(-1, EBS_SquareCompare(&square1, &square2));
+    square2 = EBS_SquareMake(314, 1);
+    TEST_ASSERT_EQUAL(1, EBS_SquareCompare(&square1, &square2));
+
+    // the full range of entropies and indices is kept
+    square1 = EBS_SquareMake(UINT32_MAX, UINT32_MAX);
+    TEST_ASSERT_EQUAL(UINT32_MAX, EBS_SquareEntropy(square1));
+    TEST_ASSERT_EQUAL(UINT32_MAX, EBS_SquareIndex(square1));
+    TEST_ASSERT_EQUAL(-1, EBS_SquareCompare(&square1, &square2));
+}
+
+void test_SquareListSort(void) {
+    static EBS_Square squares[1000], expected[1000];
+    const uint64_t sizes[] = {0, 1, 2, 63, 64, 1000};
+    // masks giving unique keys, heavy ties, a constant high half and a constant key
+    const uint32_t masks[] = {0xffffffff, 0x7, 0x0000ffff, 0x0};
+
+    for (uint64_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s) {
+        for (uint64_t m = 0; m < sizeof(masks) / sizeof(masks[0]); ++m) {
+            for (uint64_t i = 0; i < sizes[s]; ++i) {
+                squares[i] = EBS_SquareMake(((uint32_t) rand() * 2654435761u) & masks[m], i);
+            }
+            memcpy(expected, squares, sizeof(squares));
+            qsort(expected, sizes[s], sizeof(EBS_Square), EBS_SquareCompare);
+
+            EBS_SquareList list = {.size = sizes[s], .squares = squares};
+            TEST_ASSERT(EBS_SquareListSort(&list, NULL));
+            for (uint64_t i = 0; i < sizes[s]; ++i) {
+                TEST_ASSERT_EQUAL(expected[i].key, squares[i].key);
+            }
+        }
+    }
+}
+
+void test_SquareListOrder(void) {
+    static EBS_Square squares[1000], expected[1000];
+    const uint64_t limits[] = {0, 1, 2, 17, 249, 250, 1000};
+    const uint32_t masks[] = {0xffffffff, 0x7, 0x0};
+
+    for (uint64_t l = 0; l < sizeof(limits) / sizeof(limits[0]); ++l) {
+        for (uint64_t m = 0; m < sizeof(masks) / sizeof(masks[0]); ++m) {
+            for (uint64_t i = 0; i < 1000; ++i) {
+                squares[i] = EBS_SquareMake(((uint32_t) rand() * 2654435761u) & masks[m], i);
+            }
+            memcpy(expected, squares, sizeof(squares));
+            qsort(expected, 1000, sizeof(EBS_Square), EBS_SquareCompare);
+
+            EBS_SquareList list = {.size = 1000, .squares = squares};
+            TEST_ASSERT(EBS_SquareListOrder(&list, limits[l], NULL));
+            for (uint64_t i = 0; i < limits[l]; ++i) {
+                TEST_ASSERT_EQUAL(expected[i].key, squares[i].key);
+            }
+
+            // the squares past the limit are still all there
+            qsort(squares, 1000, sizeof(EBS_Square), EBS_SquareCompare);
+            for (uint64_t i = 0; i < 1000; ++i) {
+                TEST_ASSERT_EQUAL(expected[i].key, squares[i].key);
+            }
+        }
+    }
+}
+
+void test_SquareListFindMax(void) {
+    EBS_Square squares[] = {
+            EBS_SquareMake(3, 0),
+            EBS_SquareMake(7, 1),
+            EBS_SquareMake(2, 2),
+            EBS_SquareMake(7, 3),
+    };
+    EBS_SquareList list = {.size = 4, .squares = squares};
+    TEST_ASSERT_EQUAL(1, EBS_SquareListFindMax(&list));
+    squares[3] = EBS_SquareMake(8, 3);
+    TEST_ASSERT_EQUAL(3, EBS_SquareListFindMax(&list));
+    list.size = 0;
+    TEST_ASSERT_EQUAL(0, EBS_SquareListFindMax(&list));
 }
 
 void test_SquareListCreate(void) {
@@ -64,13 +141,13 @@ void test_SquareListCreate(void) {
     };
     EBS_SquareList list;
 
-    list = EBS_SquareListCreate(&image, 4);
+    list = EBS_SquareListCreate(&image, 4, 1, 0);
     TEST_ASSERT_EQUAL(16, list.size);
     TEST_ASSERT_EQUAL(4, list.squareCapacity);
     EBS_SquareListFree(&list);
 
     image.channel = 1;
-    list = EBS_SquareListCreate(&image, 4);
+    list = EBS_SquareListCreate(&image, 4, 1, 0);
     TEST_ASSERT_EQUAL(16, list.size);
     TEST_ASSERT_EQUAL(2, list.squareCapacity);
     EBS_SquareListFree(&list);
@@ -78,7 +155,7 @@ void test_SquareListCreate(void) {
 
     image.width = 12;
     image.height = 12;
-    list = EBS_SquareListCreate(&image, 4);
+    list = EBS_SquareListCreate(&image, 4, 1, 0);
     TEST_ASSERT_EQUAL(9, list.size);
     TEST_ASSERT_EQUAL(4, list.squareCapacity);
     EBS_SquareListFree(&list);
@@ -86,10 +163,95 @@ void test_SquareListCreate(void) {
     image.height = 19;
 
 
-    list = EBS_SquareListCreate(&image, 8);
+    list = EBS_SquareListCreate(&image, 8, 1, 0);
     TEST_ASSERT_EQUAL(4, list.size);
     TEST_ASSERT_EQUAL(16, list.squareCapacity);
     EBS_SquareListFree(&list);
+
+    list = EBS_SquareListCreate(&image, 8, 3, 0);
+    TEST_ASSERT_EQUAL(4, list.size);
+    TEST_ASSERT_EQUAL(48, list.squareCapacity);
+    EBS_SquareListFree(&list);
+
+    // the band walk has to agree with the per-square entropy
+    uint8_t randomPixels[37 * 29 * 5];
+    for (uint64_t i = 0; i < sizeof(randomPixels); ++i) {
+        randomPixels[i] = (uint8_t) rand();
+    }
+    for (uint64_t channel = 1; channel <= 5; ++channel) {
+        EBS_Image randomImage = {
+                .width = 37,
+                .height = 29,
+                .channel = channel,
+                .pixels = randomPixels,
+        };
+        list = EBS_SquareListCreate(&randomImage, 8, 1, 0);
+        TEST_ASSERT_EQUAL(12, list.size);
+        for (uint64_t i = 0; i < list.size; ++i) {
+            EBS_Square square = list.squares[i];
+            EBS_SquareCalcEntropy(&randomImage, &square, 8, 1, 0, EBS_EntropyTableGet(NULL, 8));
+            TEST_ASSERT_EQUAL(square.key, list.squares[i].key);
+            if (i > 0) TEST_ASSERT(list.squares[i - 1].key < list.squares[i].key);
+        }
+        EBS_SquareListFree(&list);
+    }
+
+    // with a deeper embedding the entropy ignores every bit that can carry the message
+    for (uint64_t depth = 2; depth <= 4; ++depth) {
+        EBS_Image randomImage = {
+                .width = 37,
+                .height = 29,
+                .channel = 3,
+                .pixels = randomPixels,
+        };
+        EBS_SquareList expected = EBS_SquareListCreate(&randomImage, 8, depth, 0);
+        for (uint64_t i = 0; i < sizeof(randomPixels); ++i) {
+            randomPixels[i] ^= (uint8_t) (rand() & ((1 << depth) - 1));
+        }
+        list = EBS_SquareListCreate(&randomImage, 8, depth, 0);
+        TEST_ASSERT_EQUAL(expected.size, list.size);
+        TEST_ASSERT_EQUAL_MEMORY(expected.squares, list.squares, list.size * sizeof(EBS_Square));
+        for (uint64_t i = 0; i < list.size; ++i) {
+            EBS_Square square = list.squares[i];
+            EBS_SquareCalcEntropy(&randomImage, &square, 8, depth, 0, EBS_EntropyTableGet(NULL, 8));
+            TEST_ASSERT_EQUAL(square.key, list.squares[i].key);
+        }
+        EBS_SquareListFree(&expected);
+        EBS_SquareListFree(&list);
+    }
+}
+
+void test_SquareListCreateMasked(void) {
+    static const uint64_t cases[][2] = {{4, 0x7}, {4, 0x5}, {5, 0x1b}, {7, 0x3f}, {3, 0xff}};
+    uint8_t pixels[37 * 29 * 7], stripped[37 * 29 * 7];
+    for (uint64_t i = 0; i < sizeof(pixels); ++i) {
+        pixels[i] = (uint8_t) rand();
+    }
+
+    // a masked image orders its squares like an image made of the selected channels alone
+    for (uint64_t k = 0; k < sizeof(cases) / sizeof(cases[0]); ++k) {
+        const uint64_t channel = cases[k][0], channelMask = cases[k][1];
+        const uint64_t selected = EBS_ChannelCount(channel, channelMask);
+        uint64_t next = 0;
+        for (uint64_t i = 0; i < 37 * 29 * channel; ++i) {
+            if (channelMask >> (i % channel) & 1) stripped[next++] = pixels[i];
+        }
+        EBS_Image image = {.width = 37, .height = 29, .channel = channel, .pixels = pixels};
+        EBS_Image strippedImage = {.width = 37, .height = 29, .channel = selected, .pixels = stripped};
+
+        EBS_SquareList expected = EBS_SquareListCreate(&strippedImage, 8, 2, 0);
+        EBS_SquareList list = EBS_SquareListCreate(&image, 8, 2, channelMask);
+        TEST_ASSERT_EQUAL(expected.size, list.size);
+        TEST_ASSERT_EQUAL(8 * 8 * selected * 2 / 8, list.squareCapacity);
+        TEST_ASSERT_EQUAL_MEMORY(expected.squares, list.squares, list.size * sizeof(EBS_Square));
+        for (uint64_t i = 0; i < list.size; ++i) {
+            EBS_Square square = list.squares[i];
+            EBS_SquareCalcEntropy(&image, &square, 8, 2, channelMask, EBS_EntropyTableGet(NULL, 8));
+            TEST_ASSERT_EQUAL(square.key, list.squares[i].key);
+        }
+        EBS_SquareListFree(&expected);
+        EBS_SquareListFree(&list);
+    }
 }
 
 void test_SquareListFree(void) {
@@ -102,7 +264,7 @@ void test_SquareListFree(void) {
     };
     EBS_SquareList list;
 
-    list = EBS_SquareListCreate(&image, 4);
+    list = EBS_SquareListCreate(&image, 4, 1, 0);
     EBS_SquareListFree(&list);
     TEST_ASSERT_NULL(list.squares);
     TEST_ASSERT_EQUAL(0, list.size);
@@ -148,16 +310,21 @@ void test_ImageCompare(void) {
     TEST_ASSERT_EQUAL(EBS_ImageCompare(&image1, &image2), 1);
     image1.pixels = pixels1;
     TEST_ASSERT_EQUAL(EBS_ImageCompare(&image1, &image2), 0);
+
+    // the low bits a message can change don't move an image
+    uint8_t pixels3[] = {95, 160, 87, 132, 202, 29, 196, 30};
+    image1.pixels = pixels3;
+    TEST_ASSERT_EQUAL(EBS_ImageCompare(&image1, &image2), 0);
 }
 
 void test_ComputedImageListCreate(void) {
     uint8_t pixels[64];
 
     EBS_Image images[] = {
-            {8, 8, 1, pixels},
-            {4, 4, 2, pixels},
-            {4, 4, 3, pixels},
-            {4, 4, 1, pixels},
+            {.width = 8, .height = 8, .channel = 1, .pixels = pixels},
+            {.width = 4, .height = 4, .channel = 2, .pixels = pixels},
+            {.width = 4, .height = 4, .channel = 3, .pixels = pixels},
+            {.width = 4, .height = 4, .channel = 1, .pixels = pixels},
     };
 
     EBS_ImageList imageList = {
@@ -165,7 +332,11 @@ void test_ComputedImageListCreate(void) {
             .images = images,
     };
 
-    EBS_ComputedImageList computedImageList = EBS_ComputedImageListCreate(&imageList, 2);
+    const EBS_Options options = {
+            .squareSize = 2,
+            .threadCount = 1
+    };
+    EBS_ComputedImageList computedImageList = EBS_ComputedImageListCreate(&imageList, &options, EBS_SQUARE_LIST_ORDER_ALL);
 
     TEST_ASSERT_EQUAL(imageList.size, computedImageList.size);
     TEST_ASSERT_NOT_NULL(computedImageList.computedImages);
@@ -183,14 +354,236 @@ void test_ComputedImageListCreate(void) {
     EBS_ComputedImageListFree(&computedImageList);
 }
 
+void test_ComputedImageListCreateThreaded(void) {
+    const uint64_t sizes[][3] = {
+            {1024, 1024, 4},
+            {300, 200, 3},
+            {64, 64, 1},
+            {97, 45, 6},
+            {640, 480, 2},
+    };
+    const uint64_t imageCount = sizeof(sizes) / sizeof(sizes[0]);
+
+    EBS_Image images[sizeof(sizes) / sizeof(sizes[0])];
+    for (uint64_t i = 0; i < imageCount; ++i) {
+        const uint64_t size = sizes[i][0] * sizes[i][1] * sizes[i][2];
+        images[i] = (EBS_Image) {.width = sizes[i][0], .height = sizes[i][1], .channel = sizes[i][2],
+                                 .pixels = malloc(size)};
+        TEST_ASSERT_NOT_NULL(images[i].pixels);
+        for (uint64_t j = 0; j < size; ++j) {
+            images[i].pixels[j] = (uint8_t) rand();
+        }
+    }
+    EBS_ImageList imageList = {
+            .size = imageCount,
+            .images = images,
+    };
+
+    const EBS_Options options = {
+            .squareSize = 4,
+            .threadCount = 1
+    };
+    EBS_ComputedImageList expected = EBS_ComputedImageListCreate(&imageList, &options, EBS_SQUARE_LIST_ORDER_ALL);
+    TEST_ASSERT_NOT_NULL(expected.computedImages);
+
+    const uint64_t threadCounts[] = {2, 3, 0};
+    for (uint64_t t = 0; t < sizeof(threadCounts) / sizeof(threadCounts[0]); ++t) {
+        const EBS_Options threadOptions = {
+                .squareSize = 4,
+                .threadCount = threadCounts[t]
+        };
+        EBS_ComputedImageList actual = EBS_ComputedImageListCreate(&imageList, &threadOptions, EBS_SQUARE_LIST_ORDER_ALL);
+        TEST_ASSERT_NOT_NULL(actual.computedImages);
+        for (uint64_t i = 0; i < imageCount; ++i) {
+            const EBS_SquareList *expectedList = &expected.computedImages[i].squareList;
+            const EBS_SquareList *actualList = &actual.computedImages[i].squareList;
+            TEST_ASSERT_EQUAL(expectedList->size, actualList->size);
+            for (uint64_t j = 0; j < expectedList->size; ++j) {
+                TEST_ASSERT_EQUAL(expectedList->squares[j].key, actualList->squares[j].key);
+            }
+        }
+        EBS_ComputedImageListFree(&actual);
+    }
+
+    EBS_ComputedImageListFree(&expected);
+    for (uint64_t i = 0; i < imageCount; ++i) {
+        free(images[i].pixels);
+    }
+}
+
+void test_ComputedImageListCreateMany(void) {
+    // enough thumbnails for tasks to hold many of them, some the same but for their low bits
+    const uint64_t imageCount = 5000, imageSize = 8 * 8;
+    uint8_t *pixels = (uint8_t *) malloc(imageCount * imageSize);
+    EBS_Image *images = (EBS_Image *) malloc(imageCount * sizeof(EBS_Image));
+    TEST_ASSERT_NOT_NULL(pixels);
+    TEST_ASSERT_NOT_NULL(images);
+    for (uint64_t i = 0; i < imageCount * imageSize; ++i) {
+        pixels[i] = (uint8_t) rand();
+    }
+    for (uint64_t i = 0; i < imageCount; ++i) {
+        if (i % 100 == 1) {
+            for (uint64_t j = 0; j < imageSize; ++j) {
+                pixels[i * imageSize + j] = (uint8_t) ((pixels[j] & 0xf0) | (rand() & 0x0f));
+            }
+        }
+        images[i] = (EBS_Image) {.width = 8, .height = 8, .channel = 1, .pixels = pixels + i * imageSize};
+    }
+    EBS_ImageList imageList = {imageCount, images};
+
+    const EBS_Options options = {
+            .squareSize = 4,
+            .threadCount = 1
+    };
+    EBS_ComputedImageList expected = EBS_ComputedImageListCreate(&imageList, &options, EBS_SQUARE_LIST_ORDER_ALL);
+    TEST_ASSERT_NOT_NULL(expected.computedImages);
+    for (uint64_t i = 0; i < imageCount; ++i) {
+        TEST_ASSERT(expected.computedImages[i].image.pixels == images[i].pixels);
+        EBS_SquareList list = EBS_SquareListCreate(images + i, 4, 1, 0);
+        TEST_ASSERT_EQUAL(list.size, expected.computedImages[i].squareList.size);
+        for (uint64_t j = 0; j < list.size; ++j) {
+            TEST_ASSERT_EQUAL(list.squares[j].key, expected.computedImages[i].squareList.squares[j].key);
+        }
+        EBS_SquareListFree(&list);
+
+        // equal images keep the order they were given in
+        if (i == 0) continue;
+        const int compare = EBS_ImageCompare(images + i - 1, images + i);
+        TEST_ASSERT(compare < 0 || (compare == 0 && images[i - 1].pixels < images[i].pixels));
+    }
+
+    const EBS_Options threadOptions = {
+            .squareSize = 4,
+            .threadCount = 3
+    };
+    EBS_ComputedImageList actual = EBS_ComputedImageListCreate(&imageList, &threadOptions, EBS_SQUARE_LIST_ORDER_ALL);
+    TEST_ASSERT_NOT_NULL(actual.computedImages);
+    for (uint64_t i = 0; i < imageCount; ++i) {
+        TEST_ASSERT(expected.computedImages[i].image.pixels == actual.computedImages[i].image.pixels);
+        TEST_ASSERT_EQUAL_MEMORY(expected.computedImages[i].squareList.squares,
+                                 actual.computedImages[i].squareList.squares,
+                                 expected.computedImages[i].squareList.size * sizeof(EBS_Square));
+    }
+
+    EBS_ComputedImageListFree(&actual);
+    EBS_ComputedImageListFree(&expected);
+    free(images);
+    free(pixels);
+}
+
+void test_SquareMerge(void) {
+    // entropies repeat across and within the lists so that ties go through the heap
+    static EBS_Square squares[5][40];
+    EBS_ComputedImage computedImages[6];
+    memset(computedImages, 0, sizeof(computedImages));
+    uint64_t total = 0;
+    for (uint64_t i = 0; i < 5; ++i) {
+        const uint64_t size = 10 * i;
+        for (uint64_t j = 0; j < size; ++j) {
+            squares[i][j] = EBS_SquareMake(1 + (uint32_t) rand() % 6, j);
+        }
+        EBS_SquareList list = {.size = size, .squares = squares[i]};
+        EBS_SquareListSort(&list, NULL);
+        computedImages[i + 1].squareList = list;
+        total += size;
+    }
+    computedImages[0].squareList = computedImages[4].squareList;
+    total += computedImages[0].squareList.size;
+    EBS_ComputedImageList computedImageList = {
+            .size = 6,
+            .computedImages = computedImages
+    };
+
+    EBS_SquareMerge squareMerge;
+    uint64_t squareIndex[6] = {0};
+    TEST_ASSERT(EBS_SquareMergeInit(&squareMerge, &computedImageList));
+    for (uint64_t k = 0; k < total; ++k) {
+        const uint64_t expected = EBS_ComputedImageListFindMaxEntropy(&computedImageList, squareIndex);
+        TEST_ASSERT_EQUAL(expected, EBS_SquareMergeTop(&squareMerge));
+        TEST_ASSERT_EQUAL(squareIndex[expected], squareMerge.squareIndex[expected]);
+        ++squareIndex[expected];
+        EBS_SquareMergePop(&squareMerge);
+    }
+    TEST_ASSERT_EQUAL(0, squareMerge.heapSize);
+    EBS_SquareMergeFree(&squareMerge);
+    TEST_ASSERT_NULL(squareMerge.heap);
+}
+
+void test_SquarePiecesCreate(void) {
+    static EBS_Square squares[3][30];
+    EBS_ComputedImage computedImages[3];
+    memset(computedImages, 0, sizeof(computedImages));
+    for (uint64_t i = 0; i < 3; ++i) {
+        for (uint64_t j = 0; j < 30; ++j) {
+            squares[i][j] = EBS_SquareMake(1 + (uint32_t) rand() % 100, j);
+        }
+        EBS_SquareList list = {.size = 30, .squareCapacity = 3 + 2 * i, .squares = squares[i]};
+        EBS_SquareListSort(&list, NULL);
+        computedImages[i].squareList = list;
+    }
+    EBS_ComputedImageList computedImageList = {.size = 3, .computedImages = computedImages};
+
+    // the header square, then the squares of the merge back to back over the message
+    for (uint64_t messageSize = 0; messageSize <= 200; messageSize += 7) {
+        uint64_t pieceCount;
+        const uint64_t headerSize = EBS_HeaderSize(messageSize % 2 == 0);
+        EBS_SquarePiece *pieces = EBS_SquarePiecesCreate(&computedImageList, headerSize, messageSize, &pieceCount);
+        TEST_ASSERT_NOT_NULL(pieces);
+
+        EBS_SquareMerge squareMerge;
+        TEST_ASSERT(EBS_SquareMergeInit(&squareMerge, &computedImageList));
+        uint64_t offset = 0;
+        for (uint64_t i = 0; i < pieceCount; ++i) {
+            const uint64_t top = EBS_SquareMergeTop(&squareMerge);
+            const EBS_SquareList *list = &computedImages[top].squareList;
+            TEST_ASSERT_EQUAL(top, pieces[i].computedImageIndex);
+            TEST_ASSERT(list->squares + squareMerge.squareIndex[top] == pieces[i].square);
+            if (i == 0) {
+                TEST_ASSERT_EQUAL(headerSize, pieces[i].size);
+            } else {
+                TEST_ASSERT_EQUAL(offset, pieces[i].offset);
+                TEST_ASSERT(pieces[i].size != 0 && pieces[i].size <= list->squareCapacity);
+                TEST_ASSERT(pieces[i].size == list->squareCapacity || i == pieceCount - 1);
+                offset += pieces[i].size;
+            }
+            EBS_SquareMergePop(&squareMerge);
+        }
+        TEST_ASSERT_EQUAL(messageSize, offset);
+        EBS_SquareMergeFree(&squareMerge);
+        free(pieces);
+    }
+}
+
+void test_MessageSquareCount(void) {
+    uint8_t pixels[64];
+    EBS_Image images[] = {
+            {.width = 8, .height = 8, .channel = 3, .pixels = pixels},
+            {.width = 8, .height = 8, .channel = 2, .pixels = pixels},
+    };
+    EBS_ImageList imageList = {
+            .size = 2,
+            .images = images,
+    };
+
+    // the smallest square holds 4 * 4 * 2 / 8 = 4 bytes
+    TEST_ASSERT_EQUAL(2, EBS_MessageSquareCount(&imageList, 4, 1, 0, 0));
+    TEST_ASSERT_EQUAL(2, EBS_MessageSquareCount(&imageList, 4, 1, 0, 4));
+    TEST_ASSERT_EQUAL(3, EBS_MessageSquareCount(&imageList, 4, 1, 0, 5));
+    TEST_ASSERT_EQUAL(26, EBS_MessageSquareCount(&imageList, 4, 1, 0, 100));
+    TEST_ASSERT_EQUAL(2, EBS_MessageSquareCount(&imageList, 4, 2, 0, 8));
+    TEST_ASSERT_EQUAL(8, EBS_MessageSquareCount(&imageList, 4, 4, 0, 100));
+    imageList.size = 0;
+    TEST_ASSERT_EQUAL(0, EBS_MessageSquareCount(&imageList, 4, 1, 0, 100));
+}
+
 void test_ComputedImageListFree(void) {
     uint8_t pixels[64];
 
     EBS_Image images[] = {
-            {8, 8, 1, pixels},
-            {4, 4, 2, pixels},
-            {4, 4, 3, pixels},
-            {4, 4, 1, pixels},
+            {.width = 8, .height = 8, .channel = 1, .pixels = pixels},
+            {.width = 4, .height = 4, .channel = 2, .pixels = pixels},
+            {.width = 4, .height = 4, .channel = 3, .pixels = pixels},
+            {.width = 4, .height = 4, .channel = 1, .pixels = pixels},
     };
 
     EBS_ImageList imageList = {
@@ -198,7 +591,11 @@ void test_ComputedImageListFree(void) {
             .images = images,
     };
 
-    EBS_ComputedImageList computedImageList = EBS_ComputedImageListCreate(&imageList, 4);
+    const EBS_Options options = {
+            .squareSize = 4,
+            .threadCount = 1
+    };
+    EBS_ComputedImageList computedImageList = EBS_ComputedImageListCreate(&imageList, &options, EBS_SQUARE_LIST_ORDER_ALL);
 
     EBS_ComputedImageListFree(&computedImageList);
 
@@ -211,10 +608,10 @@ void test_ComputedImageListFindMaxEntropy(void) {
     uint64_t squareIndex[] = {0, 0, 0, 0};
 
     EBS_Image images[] = {
-            {8, 8, 1, pixels},
-            {4, 4, 2, pixels},
-            {4, 4, 3, pixels},
-            {4, 4, 1, pixels},
+            {.width = 8, .height = 8, .channel = 1, .pixels = pixels},
+            {.width = 4, .height = 4, .channel = 2, .pixels = pixels},
+            {.width = 4, .height = 4, .channel = 3, .pixels = pixels},
+            {.width = 4, .height = 4, .channel = 1, .pixels = pixels},
     };
 
     EBS_ImageList imageList = {
@@ -222,7 +619,11 @@ void test_ComputedImageListFindMaxEntropy(void) {
             .images = images,
     };
 
-    EBS_ComputedImageList computedImageList = EBS_ComputedImageListCreate(&imageList, 4);
+    const EBS_Options options = {
+            .squareSize = 4,
+            .threadCount = 1
+    };
+    EBS_ComputedImageList computedImageList = EBS_ComputedImageListCreate(&imageList, &options, EBS_SQUARE_LIST_ORDER_ALL);
 
     const uint64_t maxEntropy = EBS_ComputedImageListFindMaxEntropy(&computedImageList, squareIndex);
 
@@ -235,10 +636,10 @@ void test_ComputedImageListCalcCapacity(void) {
     uint8_t pixels[64];
 
     EBS_Image images[] = {
-            {8, 8, 1, pixels},
-            {4, 4, 2, pixels},
-            {4, 4, 3, pixels},
-            {4, 4, 1, pixels},
+            {.width = 8, .height = 8, .channel = 1, .pixels = pixels},
+            {.width = 4, .height = 4, .channel = 2, .pixels = pixels},
+            {.width = 4, .height = 4, .channel = 3, .pixels = pixels},
+            {.width = 4, .height = 4, .channel = 1, .pixels = pixels},
     };
 
     EBS_ImageList imageList = {
@@ -246,9 +647,13 @@ void test_ComputedImageListCalcCapacity(void) {
             .images = images,
     };
 
-    EBS_ComputedImageList computedImageList = EBS_ComputedImageListCreate(&imageList, 2);
+    const EBS_Options options = {
+            .squareSize = 2,
+            .threadCount = 1
+    };
+    EBS_ComputedImageList computedImageList = EBS_ComputedImageListCreate(&imageList, &options, EBS_SQUARE_LIST_ORDER_ALL);
 
-    const uint64_t capacity = EBS_ComputedImageListCalcCapacity(&computedImageList);
+    const uint64_t capacity = EBS_ComputedImageListCalcCapacity(&computedImageList, false);
 
     EBS_ComputedImageListFree(&computedImageList);
 
@@ -336,6 +741,148 @@ void test_ImageListCheck(void) {
     images[2].width = 2;
 }
 
+void test_ImageView(void) {
+    // a frame with padded rows, and a copy of a rectangle of it with packed rows
+    enum {frameWidth = 70, frameHeight = 50, channel = 3, stride = frameWidth * channel + 13};
+    enum {x = 5, y = 7, width = 48, height = 40};
+    static uint8_t frame[frameHeight * stride], before[frameHeight * stride], packed[width * height * channel];
+    for (uint64_t i = 0; i < sizeof(frame); ++i) {
+        frame[i] = (uint8_t) rand();
+    }
+    memcpy(before, frame, sizeof(frame));
+    for (uint64_t r = 0; r < height; ++r) {
+        memcpy(packed + r * width * channel, frame + (y + r) * stride + x * channel, width * channel);
+    }
+
+    int errorCode;
+    const EBS_Image image = {frameWidth, frameHeight, channel, frame, stride, 0};
+    EBS_Image view = EBS_ImageView(&image, x, y, width, height, &errorCode);
+    TEST_ASSERT_EQUAL(EBS_OK, errorCode);
+    TEST_ASSERT(view.pixels == frame + y * stride + x * channel);
+    TEST_ASSERT_EQUAL(stride, view.stride);
+    EBS_Image copy = {width, height, channel, packed, 0, 0};
+    TEST_ASSERT_EQUAL(0, EBS_ImageCompare(&view, &copy));
+    TEST_ASSERT_NULL(EBS_ImageView(&image, x, y, frameWidth, height, &errorCode).pixels);
+    TEST_ASSERT_EQUAL(EBS_ErrorInvalidImage, errorCode);
+    TEST_ASSERT_NULL(EBS_ImageView(&image, 0, frameHeight, width, 1, &errorCode).pixels);
+    TEST_ASSERT_EQUAL(EBS_ErrorInvalidImage, errorCode);
+
+    // the view carries the same message in the same pixels as the copy, and nothing outside the rectangle changes
+    uint8_t data[300];
+    for (uint64_t i = 0; i < sizeof(data); ++i) {
+        data[i] = (uint8_t) rand();
+    }
+    const EBS_Message message = {sizeof(data), data};
+    const EBS_Options options = {
+            .squareSize = 8,
+            .threadCount = 1,
+            .channelMask = 0x5
+    };
+    EBS_ImageList viewList = {1, &view}, copyList = {1, &copy};
+    EBS_MessageEmbedWithOptions(&viewList, &message, &options, &errorCode);
+    TEST_ASSERT_EQUAL(EBS_OK, errorCode);
+    EBS_MessageEmbedWithOptions(&copyList, &message, &options, &errorCode);
+    TEST_ASSERT_EQUAL(EBS_OK, errorCode);
+    for (uint64_t r = 0; r < frameHeight; ++r) {
+        for (uint64_t i = 0; i < stride; ++i) {
+            const uint64_t column = i / channel;
+            if (r >= y && r < y + height && i < frameWidth * channel && column >= x && column < x + width) {
+                TEST_ASSERT_EQUAL(packed[((r - y) * width + column - x) * channel + i % channel],
+                                  frame[r * stride + i]);
+            } else {
+                TEST_ASSERT_EQUAL(before[r * stride + i], frame[r * stride + i]);
+            }
+        }
+    }
+
+    EBS_Message extracted = EBS_MessageExtractWithOptions(&viewList, &options, &errorCode);
+    TEST_ASSERT_EQUAL(EBS_OK, errorCode);
+    TEST_ASSERT_EQUAL(sizeof(data), extracted.size);
+    TEST_ASSERT_EQUAL_MEMORY(data, extracted.data, sizeof(data));
+    EBS_MessageFree(&extracted);
+
+    // a stride shorter than the row is rejected
+    view.stride = width * channel - 1;
+    TEST_ASSERT(!EBS_ImageListCheck(&viewList));
+}
+
+void test_ImageSamples16(void) {
+    enum {width = 40, height = 24, channel = 3};
+    static uint16_t samples[width * height * channel], before[width * height * channel];
+    static uint8_t high[width * height * channel];
+    for (uint64_t i = 0; i < width * height * channel; ++i) {
+        samples[i] = (uint16_t) rand();
+        high[i] = (uint8_t) (samples[i] >> 8);
+    }
+    memcpy(before, samples, sizeof(samples));
+
+    // the squares are ordered by the high bytes of the samples, and hold as much as those of an 8-bit image
+    EBS_Image image = {.width = width, .height = height, .channel = channel, .pixels = (uint8_t *) samples,
+                       .sampleBits = 16};
+    const EBS_Image highImage = {.width = width, .height = height, .channel = channel, .pixels = high};
+    for (uint64_t depth = 1; depth <= 4; ++depth) {
+        EBS_SquareList expected = EBS_SquareListCreate(&highImage, 8, 1, 0);
+        EBS_SquareList list = EBS_SquareListCreate(&image, 8, depth, 0x5);
+        EBS_SquareList masked = EBS_SquareListCreate(&highImage, 8, 1, 0x5);
+        EBS_SquareList all = EBS_SquareListCreate(&image, 8, depth, 0);
+        TEST_ASSERT_EQUAL(8 * 8 * 2 * depth / 8, list.squareCapacity);
+        TEST_ASSERT_EQUAL_MEMORY(masked.squares, list.squares, list.size * sizeof(EBS_Square));
+        TEST_ASSERT_EQUAL_MEMORY(expected.squares, all.squares, all.size * sizeof(EBS_Square));
+        EBS_SquareListFree(&expected);
+        EBS_SquareListFree(&list);
+        EBS_SquareListFree(&masked);
+        EBS_SquareListFree(&all);
+    }
+
+    // only the low depth bits of the selected samples change, and the message comes back
+    uint8_t data[200];
+    for (uint64_t i = 0; i < sizeof(data); ++i) {
+        data[i] = (uint8_t) rand();
+    }
+    const EBS_Message message = {sizeof(data), data};
+    EBS_ImageList imageList = {1, &image};
+    for (uint64_t depth = 1; depth <= 4; ++depth) {
+        for (uint64_t channelMask = 0; channelMask <= 0x5; channelMask += 0x5) {
+            const EBS_Options options = {
+                    .squareSize = 8,
+                    .threadCount = 1,
+                    .depth = depth,
+                    .channelMask = channelMask,
+                    .checksum = true
+            };
+            int errorCode;
+            EBS_MessageEmbedWithOptions(&imageList, &message, &options, &errorCode);
+            TEST_ASSERT_EQUAL(EBS_OK, errorCode);
+            for (uint64_t i = 0; i < width * height * channel; ++i) {
+                const bool selected = channelMask == 0 || (channelMask >> (i % channel) & 1);
+                const uint16_t kept = (uint16_t) (selected ? ~((1u << depth) - 1) : 0xffff);
+                TEST_ASSERT_EQUAL(before[i] & kept, samples[i] & kept);
+            }
+            EBS_Message extracted = EBS_MessageExtractWithOptions(&imageList, &options, &errorCode);
+            TEST_ASSERT_EQUAL(EBS_OK, errorCode);
+            TEST_ASSERT_EQUAL(sizeof(data), extracted.size);
+            TEST_ASSERT_EQUAL_MEMORY(data, extracted.data, sizeof(data));
+            EBS_MessageFree(&extracted);
+            memcpy(samples, before, sizeof(samples));
+        }
+    }
+
+    // a view steps over whole samples
+    int errorCode;
+    const EBS_Image view = EBS_ImageView(&image, 3, 2, 16, 16, &errorCode);
+    TEST_ASSERT_EQUAL(EBS_OK, errorCode);
+    TEST_ASSERT(view.pixels == (uint8_t *) (samples + (2 * width + 3) * channel));
+    TEST_ASSERT_EQUAL(16, view.sampleBits);
+
+    // other sample sizes, and more channels than a mask of their bytes covers, are rejected
+    image.sampleBits = 12;
+    TEST_ASSERT(!EBS_ImageCheck(&image));
+    image.sampleBits = 16;
+    image.channel = 33;
+    image.width = 8;
+    TEST_ASSERT(!EBS_ImageCheck(&image));
+}
+
 void test_MessageFree(void) {
     EBS_Message message = {
             .size = 64,
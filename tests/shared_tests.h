@@ -4,14 +4,32 @@ void test_SquareCalcEntropy(void);
 
 void test_SquareCompare(void);
 
+void test_SquareListSort(void);
+
+void test_SquareListOrder(void);
+
+void test_SquareListFindMax(void);
+
 void test_SquareListCreate(void);
 
+void test_SquareListCreateMasked(void);
+
 void test_SquareListFree(void);
 
 void test_ImageCompare(void);
 
 void test_ComputedImageListCreate(void);
 
+void test_ComputedImageListCreateThreaded(void);
+
+void test_ComputedImageListCreateMany(void);
+
+void test_SquareMerge(void);
+
+void test_SquarePiecesCreate(void);
+
+void test_MessageSquareCount(void);
+
 void test_ComputedImageListFree(void);
 
 void test_ComputedImageListFindMaxEntropy(void);
@@ -24,4 +42,8 @@ void test_ImageCheck(void);
 
 void test_ImageListCheck(void);
 
+void test_ImageView(void);
+
+void test_ImageSamples16(void);
+
 void test_MessageFree(void);
@@ -3,6 +3,13 @@
 #include "embed_tests.h"
 #include "extract_tests.h"
 #include "shared_tests.h"
+#include "histogram_tests.h"
+#include "entropy_tests.h"
+#include "plan_tests.h"
+#include "index_tests.h"
+#include "channel_tests.h"
+#include "cipher_tests.h"
+#include "context_tests.h"
 
 void setUp(void) {}
 
@@ -12,22 +19,81 @@ int main(void) {
     UNITY_BEGIN();
 
     RUN_TEST(test_SquareEmbed);
+    RUN_TEST(test_SquareEmbedKernel);
+    RUN_TEST(test_SquareEmbedEncrypted);
+    RUN_TEST(test_MessageEmbedThreaded);
+    RUN_TEST(test_MessageEmbedStream);
 
     RUN_TEST(test_SquareExtract);
+    RUN_TEST(test_SquareExtractKernel);
+    RUN_TEST(test_ExtractRowKernels);
+    RUN_TEST(test_ExtractRowKernelSelect);
+    RUN_TEST(test_MessageExtractThreaded);
+    RUN_TEST(test_MessageExtractEncrypted);
+    RUN_TEST(test_MessageExtractChecksum);
+    RUN_TEST(test_MessageExtractStream);
+    RUN_TEST(test_MessageExtractEmptyImage);
 
     RUN_TEST(test_SquareCalcEntropy);
     RUN_TEST(test_SquareCompare);
+    RUN_TEST(test_SquareListSort);
+    RUN_TEST(test_SquareListOrder);
+    RUN_TEST(test_SquareListFindMax);
     RUN_TEST(test_SquareListCreate);
+    RUN_TEST(test_SquareListCreateMasked);
     RUN_TEST(test_SquareListFree);
     RUN_TEST(test_ImageCompare);
     RUN_TEST(test_ComputedImageListCreate);
+    RUN_TEST(test_ComputedImageListCreateThreaded);
+    RUN_TEST(test_ComputedImageListCreateMany);
+    RUN_TEST(test_SquareMerge);
+    RUN_TEST(test_SquarePiecesCreate);
+    RUN_TEST(test_MessageSquareCount);
     RUN_TEST(test_ComputedImageListFree);
     RUN_TEST(test_ComputedImageListFindMaxEntropy);
     RUN_TEST(test_ComputedImageListCalcCapacity);
     RUN_TEST(test_SquareSizeCheck);
     RUN_TEST(test_ImageCheck);
     RUN_TEST(test_ImageListCheck);
+    RUN_TEST(test_ImageView);
+    RUN_TEST(test_ImageSamples16);
     RUN_TEST(test_MessageFree);
 
+    RUN_TEST(test_HistogramSquare);
+    RUN_TEST(test_HistogramRowKernels);
+    RUN_TEST(test_HistogramChannel);
+    RUN_TEST(test_HistogramRowKernelSelect);
+    RUN_TEST(test_HistogramFold);
+
+    RUN_TEST(test_ChannelCount);
+    RUN_TEST(test_ChannelPackKernels);
+    RUN_TEST(test_ChannelKernelSelect);
+
+    RUN_TEST(test_CipherVector);
+    RUN_TEST(test_CipherKernels);
+    RUN_TEST(test_CipherApply);
+
+    RUN_TEST(test_ContextCreate);
+    RUN_TEST(test_ContextReuse);
+    RUN_TEST(test_ContextPlan);
+    RUN_TEST(test_ContextThreads);
+
+    RUN_TEST(test_EntropyLog2);
+    RUN_TEST(test_EntropyTableValue);
+    RUN_TEST(test_EntropyTableGet);
+    RUN_TEST(test_EntropySum);
+    RUN_TEST(test_EntropyKey);
+
+    RUN_TEST(test_PlanCreate);
+    RUN_TEST(test_PlanEmbed);
+    RUN_TEST(test_PlanExtract);
+    RUN_TEST(test_PlanDepth);
+    RUN_TEST(test_PlanChannelMask);
+
+    RUN_TEST(test_IndexKey);
+    RUN_TEST(test_IndexSaveLoad);
+    RUN_TEST(test_IndexValidate);
+    RUN_TEST(test_ComputedImageListCreateIndexed);
+
     return UNITY_END();
 }
\ No newline at end of file